@@ -0,0 +1,209 @@
+// $Id$
+/*
+ * Benchmark for OSC Parser
+ * See README.txt for details
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2009 Thorsten Klose (tk@midibox.org)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ * 
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+#include <string.h>
+#include "benchmark.h"
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+static s32 BENCHMARK_Method(mios32_osc_args_t *osc_args, u32 method_arg);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Search Tree of a typical TouchOSC layout
+// 4 pages with 16 faders, rotaries, toggle and push buttons
+/////////////////////////////////////////////////////////////////////////////
+
+#define CONTROL(name, type, num) { name, NULL, &BENCHMARK_Method, ((type) << 8) | (num) }
+
+const static mios32_osc_search_tree_t parse_page[] = {
+  CONTROL("fader1",   0,  0), CONTROL("fader2",   0,  1), CONTROL("fader3",   0,  2), CONTROL("fader4",   0,  3),
+  CONTROL("fader5",   0,  4), CONTROL("fader6",   0,  5), CONTROL("fader7",   0,  6), CONTROL("fader8",   0,  7),
+  CONTROL("fader9",   0,  8), CONTROL("fader10",  0,  9), CONTROL("fader11",  0, 10), CONTROL("fader12",  0, 11),
+  CONTROL("fader13",  0, 12), CONTROL("fader14",  0, 13), CONTROL("fader15",  0, 14), CONTROL("fader16",  0, 15),
+  CONTROL("rotary1",  1,  0), CONTROL("rotary2",  1,  1), CONTROL("rotary3",  1,  2), CONTROL("rotary4",  1,  3),
+  CONTROL("rotary5",  1,  4), CONTROL("rotary6",  1,  5), CONTROL("rotary7",  1,  6), CONTROL("rotary8",  1,  7),
+  CONTROL("rotary9",  1,  8), CONTROL("rotary10", 1,  9), CONTROL("rotary11", 1, 10), CONTROL("rotary12", 1, 11),
+  CONTROL("rotary13", 1, 12), CONTROL("rotary14", 1, 13), CONTROL("rotary15", 1, 14), CONTROL("rotary16", 1, 15),
+  CONTROL("toggle1",  2,  0), CONTROL("toggle2",  2,  1), CONTROL("toggle3",  2,  2), CONTROL("toggle4",  2,  3),
+  CONTROL("toggle5",  2,  4), CONTROL("toggle6",  2,  5), CONTROL("toggle7",  2,  6), CONTROL("toggle8",  2,  7),
+  CONTROL("toggle9",  2,  8), CONTROL("toggle10", 2,  9), CONTROL("toggle11", 2, 10), CONTROL("toggle12", 2, 11),
+  CONTROL("toggle13", 2, 12), CONTROL("toggle14", 2, 13), CONTROL("toggle15", 2, 14), CONTROL("toggle16", 2, 15),
+  CONTROL("push1",    3,  0), CONTROL("push2",    3,  1), CONTROL("push3",    3,  2), CONTROL("push4",    3,  3),
+  CONTROL("push5",    3,  4), CONTROL("push6",    3,  5), CONTROL("push7",    3,  6), CONTROL("push8",    3,  7),
+  CONTROL("push9",    3,  8), CONTROL("push10",   3,  9), CONTROL("push11",   3, 10), CONTROL("push12",   3, 11),
+  CONTROL("push13",   3, 12), CONTROL("push14",   3, 13), CONTROL("push15",   3, 14), CONTROL("push16",   3, 15),
+  { NULL, NULL, NULL, 0 }
+};
+
+// the same tree twice: only parse_root is compiled
+const static mios32_osc_search_tree_t parse_root[] = {
+  { "1", parse_page, NULL, 0x00000000 }, // bit [17:16] selects the page
+  { "2", parse_page, NULL, 0x00010000 },
+  { "3", parse_page, NULL, 0x00020000 },
+  { "4", parse_page, NULL, 0x00030000 },
+  { NULL, NULL, NULL, 0 }
+};
+
+const static mios32_osc_search_tree_t parse_root_uncompiled[] = {
+  { "1", parse_page, NULL, 0x00000000 }, // bit [17:16] selects the page
+  { "2", parse_page, NULL, 0x00010000 },
+  { "3", parse_page, NULL, 0x00020000 },
+  { "4", parse_page, NULL, 0x00030000 },
+  { NULL, NULL, NULL, 0 }
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Test messages
+/////////////////////////////////////////////////////////////////////////////
+
+#define NUM_MESSAGES 8
+
+static const char *message_paths[NUM_MESSAGES] = {
+  "/1/fader1", "/1/fader16", "/2/rotary7", "/2/rotary12",
+  "/3/toggle4", "/3/push9", "/4/push16", "/4/fader8",
+};
+
+static const char *message_paths_wildcards[NUM_MESSAGES] = {
+  "/1/fader?", "/*/fader16", "/2/rotary[1-4]", "/[23]/rotary12",
+  "/3/{toggle,push}4", "/3/push*", "/4/push16", "/4/fader8",
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////////////////////////////////
+
+// enough for 8 messages in a bundle
+#define PACKET_BUFFER_SIZE 512
+static u8 packet_buffer[PACKET_BUFFER_SIZE];
+static u32 packet_len[NUM_MESSAGES];
+static u32 num_packets;
+
+static u32 num_method_calls;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Initialisation
+/////////////////////////////////////////////////////////////////////////////
+s32 BENCHMARK_Init(u32 mode)
+{
+  s32 status = MIOS32_OSC_CompileSearchTree(parse_root);
+
+  if( status < 0 ) {
+    MIOS32_MIDI_SendDebugMessage("ERROR: search tree can't be compiled (status %d)!\n", status);
+  }
+
+  return status;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// OSC method: only counts the calls
+/////////////////////////////////////////////////////////////////////////////
+static s32 BENCHMARK_Method(mios32_osc_args_t *osc_args, u32 method_arg)
+{
+  ++num_method_calls;
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Creates the test packets
+/////////////////////////////////////////////////////////////////////////////
+s32 BENCHMARK_Reset(u32 par)
+{
+  const char **paths = (par & BENCHMARK_PAR_WILDCARDS) ? message_paths_wildcards : message_paths;
+  u8 *end_ptr = packet_buffer;
+  int i;
+
+  if( par & BENCHMARK_PAR_BUNDLE ) {
+    mios32_osc_timetag_t timetag;
+    timetag.seconds = 0;
+    timetag.fraction = 1;
+
+    end_ptr = MIOS32_OSC_PutString(end_ptr, "#bundle");
+    end_ptr = MIOS32_OSC_PutTimetag(end_ptr, timetag);
+  }
+
+  num_packets = 0;
+  for(i=0; i<NUM_MESSAGES; ++i) {
+    u8 *insert_len_ptr = end_ptr;
+    if( par & BENCHMARK_PAR_BUNDLE )
+      end_ptr += 4; // we will insert the length later
+
+    u8 *message_ptr = end_ptr;
+    end_ptr = MIOS32_OSC_PutString(end_ptr, (char *)paths[i]);
+    end_ptr = MIOS32_OSC_PutString(end_ptr, ",f");
+    end_ptr = MIOS32_OSC_PutFloat(end_ptr, 0.5);
+
+    if( par & BENCHMARK_PAR_BUNDLE ) {
+      MIOS32_OSC_PutWord(insert_len_ptr, (u32)(end_ptr-message_ptr));
+    } else {
+      packet_len[num_packets++] = (u32)(end_ptr-message_ptr);
+    }
+  }
+
+  if( par & BENCHMARK_PAR_BUNDLE )
+    packet_len[num_packets++] = (u32)(end_ptr-packet_buffer);
+
+  num_method_calls = 0;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Parses all test packets once
+/////////////////////////////////////////////////////////////////////////////
+s32 BENCHMARK_Start(u32 par)
+{
+  const mios32_osc_search_tree_t *search_tree = (par & BENCHMARK_PAR_COMPILED) ? parse_root : parse_root_uncompiled;
+  u8 *packet = packet_buffer;
+  int i;
+
+  for(i=0; i<num_packets; ++i) {
+    MIOS32_OSC_ParsePacket(packet, packet_len[i], search_tree);
+    packet += packet_len[i];
+  }
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Number of messages which are parsed by BENCHMARK_Start()
+/////////////////////////////////////////////////////////////////////////////
+u32 BENCHMARK_NumMessagesGet(void)
+{
+  return NUM_MESSAGES;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Number of method calls since BENCHMARK_Reset()
+/////////////////////////////////////////////////////////////////////////////
+u32 BENCHMARK_NumMethodCallsGet(void)
+{
+  return num_method_calls;
+}
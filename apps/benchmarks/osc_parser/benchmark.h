@@ -0,0 +1,50 @@
+// $Id$
+/*
+ * Header file for benchmark routines
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2009 Thorsten Klose (tk@midibox.org)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ * 
+ * ==========================================================================
+ */
+
+#ifndef _BENCHMARK_H
+#define _BENCHMARK_H
+
+/////////////////////////////////////////////////////////////////////////////
+// Global definitions
+/////////////////////////////////////////////////////////////////////////////
+
+// flags for the benchmark parameter
+#define BENCHMARK_PAR_COMPILED   (1 << 0) // use the compiled search tree
+#define BENCHMARK_PAR_BUNDLE     (1 << 1) // all messages in a single bundle
+#define BENCHMARK_PAR_WILDCARDS  (1 << 2) // addresses with wildcards
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Global Types
+/////////////////////////////////////////////////////////////////////////////
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+extern s32 BENCHMARK_Init(u32 mode);
+
+extern s32 BENCHMARK_Reset(u32 par);
+extern s32 BENCHMARK_Start(u32 par);
+
+extern u32 BENCHMARK_NumMessagesGet(void);
+extern u32 BENCHMARK_NumMethodCallsGet(void);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Export global variables
+/////////////////////////////////////////////////////////////////////////////
+
+
+#endif /* _BENCHMARK_H */
@@ -0,0 +1,14 @@
+// $Id$
+/*
+ * Local MIOS32 configuration file for the host build of the
+ * OSC Parser Benchmark
+ *
+ */
+
+#ifndef _MIOS32_CONFIG_H
+#define _MIOS32_CONFIG_H
+
+// same hash table size like on STM32F4
+#define MIOS32_OSC_SEARCH_HASH_SIZE 128
+
+#endif /* _MIOS32_CONFIG_H */
@@ -0,0 +1,130 @@
+// $Id$
+/*
+ * Host build of the OSC Parser Benchmark
+ * See README.txt for details
+ *
+ * Runs the tests of benchmark.c in a loop and reports the time per message
+ * and the number of method calls. The MIOS32 functions which are used by
+ * the parser are replaced by stubs.
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2009 Thorsten Klose (tk@midibox.org)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <time.h>
+
+#include "../benchmark.h"
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local definitions
+/////////////////////////////////////////////////////////////////////////////
+
+// number of BENCHMARK_Start() calls per test
+#define NUM_LOOPS 200000
+
+#define NUM_TESTS 6
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+static const char test_names[NUM_TESTS][40] = {
+  "single messages, search tree",
+  "single messages, compiled search tree",
+  "bundled messages, search tree",
+  "bundled messages, compiled search tree",
+  "wildcards, search tree",
+  "wildcards, compiled search tree",
+};
+
+
+/////////////////////////////////////////////////////////////////////////////
+// MIOS32 stubs
+/////////////////////////////////////////////////////////////////////////////
+
+s32 MIOS32_MIDI_SendDebugMessage(const char *format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  vprintf(format, args);
+  va_end(args);
+
+  return 0; // no error
+}
+
+s32 MIOS32_MIDI_SendDebugHexDump(const u8 *src, u32 len)
+{
+  return 0; // not used
+}
+
+s32 MIOS32_IRQ_Disable(void)
+{
+  return 0; // single threaded
+}
+
+s32 MIOS32_IRQ_Enable(void)
+{
+  return 0; // single threaded
+}
+
+// only used if the benchmark is linked against a parser version without search tree compiler
+__attribute__((weak)) s32 MIOS32_OSC_CompileSearchTree(const mios32_osc_search_tree_t *search_tree)
+{
+  return 0; // tree will be searched uncompiled
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// returns a monotonic timestamp in nS
+/////////////////////////////////////////////////////////////////////////////
+static unsigned long long TimeGet(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Main
+/////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+  if( BENCHMARK_Init(0) < 0 )
+    return 1;
+
+  printf("OSC Parser Benchmark: %d loops with %u messages per test\n", NUM_LOOPS, (unsigned)BENCHMARK_NumMessagesGet());
+
+  u32 par;
+  for(par=0; par<NUM_TESTS; ++par) {
+    BENCHMARK_Reset(par);
+    BENCHMARK_Start(par); // warm up caches
+    u32 method_calls = BENCHMARK_NumMethodCallsGet();
+
+    unsigned long long t_begin = TimeGet();
+    int i;
+    for(i=0; i<NUM_LOOPS; ++i)
+      BENCHMARK_Start(par);
+    unsigned long long t_end = TimeGet();
+
+    double ns = (double)(t_end - t_begin) / ((double)NUM_LOOPS * BENCHMARK_NumMessagesGet());
+    printf("Test #%u (%s): %.1f nS per message, %u method calls\n", (unsigned)par, test_names[par], ns, (unsigned)method_calls);
+  }
+
+  return 0;
+}
@@ -0,0 +1,18 @@
+// $Id$
+/*
+ * FreeRTOS replacement for the host build of the
+ * MIDI Out Scheduler Benchmark
+ *
+ * only the heap functions are used by seq_midi_out.c and mid_parser.c
+ *
+ */
+
+#ifndef _FREERTOS_H
+#define _FREERTOS_H
+
+#include <stdlib.h>
+
+#define pvPortMalloc(size) malloc(size)
+#define vPortFree(ptr)     free(ptr)
+
+#endif /* _FREERTOS_H */
@@ -0,0 +1,120 @@
+// $Id$
+/*
+ * MIOS32 and BPM generator stubs for the host build of the
+ * MIDI Out Scheduler Benchmark
+ *
+ * The BPM generator is replaced by a tick counter which is under direct
+ * control of the benchmark (like the slave mode trick in benchmark.c),
+ * MIDI packages are sent to a dummy port which only counts them.
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2008 Thorsten Klose (tk@midibox.org)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ * 
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+#include <seq_bpm.h>
+
+#include <stdarg.h>
+
+#include "host_stubs.h"
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Global variables
+/////////////////////////////////////////////////////////////////////////////
+
+u32 host_stubs_sent_packages;
+u8  host_stubs_debug_enabled;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+static u32 bpm_tick;
+static float bpm;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// MIOS32 functions
+/////////////////////////////////////////////////////////////////////////////
+
+s32 MIOS32_MIDI_SendPackage(mios32_midi_port_t port, mios32_midi_package_t package)
+{
+  ++host_stubs_sent_packages;
+  return 0; // no error
+}
+
+s32 MIOS32_MIDI_SendDebugMessage(const char *format, ...)
+{
+  if( host_stubs_debug_enabled ) {
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+  }
+
+  return 0; // no error
+}
+
+s32 MIOS32_IRQ_Disable(void)
+{
+  return 0; // single threaded
+}
+
+s32 MIOS32_IRQ_Enable(void)
+{
+  return 0; // single threaded
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// BPM generator
+/////////////////////////////////////////////////////////////////////////////
+
+s32 SEQ_BPM_IsRunning(void)
+{
+  return 1; // always running
+}
+
+u32 SEQ_BPM_TickGet(void)
+{
+  return bpm_tick;
+}
+
+s32 SEQ_BPM_TickSet(u32 tick)
+{
+  bpm_tick = tick;
+  return 0; // no error
+}
+
+float SEQ_BPM_Get(void)
+{
+  return bpm;
+}
+
+s32 SEQ_BPM_Set(float _bpm)
+{
+  bpm = _bpm;
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// returns a monotonic timestamp in nS
+/////////////////////////////////////////////////////////////////////////////
+unsigned long long HOST_STUBS_TimeGet(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
@@ -0,0 +1,33 @@
+// $Id$
+/*
+ * Header file of MIOS32 stubs for the host build
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2008 Thorsten Klose (tk@midibox.org)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ * 
+ * ==========================================================================
+ */
+
+#ifndef _HOST_STUBS_H
+#define _HOST_STUBS_H
+
+#include <time.h>
+
+/////////////////////////////////////////////////////////////////////////////
+// Prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+extern unsigned long long HOST_STUBS_TimeGet(void);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Export global variables
+/////////////////////////////////////////////////////////////////////////////
+
+extern u32 host_stubs_sent_packages;
+extern u8  host_stubs_debug_enabled;
+
+#endif /* _HOST_STUBS_H */
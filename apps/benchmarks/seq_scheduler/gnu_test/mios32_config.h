@@ -0,0 +1,20 @@
+// $Id$
+/*
+ * Local MIOS32 configuration file for the host build of the
+ * MIDI Out Scheduler Benchmark
+ *
+ * SEQ_MIDI_OUT_MALLOC_METHOD, SEQ_MIDI_OUT_SCHEDULER and
+ * SEQ_MIDI_OUT_MAX_EVENTS are passed by the makefile
+ *
+ */
+
+#ifndef _MIOS32_CONFIG_H
+#define _MIOS32_CONFIG_H
+
+// enable seq_midi_out_max_allocated and seq_midi_out_dropouts
+#define SEQ_MIDI_OUT_MALLOC_ANALYSIS 1
+
+// enable seq_midi_out_sched_* counters
+#define SEQ_MIDI_OUT_SCHEDULER_ANALYSIS 1
+
+#endif /* _MIOS32_CONFIG_H */
@@ -0,0 +1,333 @@
+// $Id$
+/*
+ * Host build of the MIDI Out Scheduler Benchmark
+ * See README.txt for details
+ *
+ * Plays the bundled demo MIDI file and synthetic multi-track loads through
+ * SEQ_MIDI_OUT_Send/SEQ_MIDI_OUT_Handler, and reports the throughput,
+ * the worst-case handler time and the allocation statistics for the
+ * SEQ_MIDI_OUT_MALLOC_METHOD and SEQ_MIDI_OUT_SCHEDULER the binary has been
+ * compiled with.
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2008 Thorsten Klose (tk@midibox.org)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+/////////////////////////////////////////////////////////////////////////////
+// Include files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <mios32.h>
+#include <seq_bpm.h>
+#include <seq_midi_out.h>
+
+#include <mid_parser.h>
+
+#include <string.h>
+
+#include "../mid_file.h"
+#include "host_stubs.h"
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local definitions
+/////////////////////////////////////////////////////////////////////////////
+
+// synthetic loads are running at 384 ppqn like MBSEQ
+#define SYNTH_PPQN          384
+#define SYNTH_STEP_TICKS    (SYNTH_PPQN/4)
+#define SYNTH_CLOCK_TICKS   (SYNTH_PPQN/24)
+#define SYNTH_NUM_STEPS     256
+
+// number of echo repeats for each note of a synthetic track
+#define SYNTH_ECHO_REPEATS  3
+
+// dummy port (so that the interface doesn't falsify the benchmark results)
+#define BENCHMARK_PORT      0xff
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local types
+/////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  u32 ticks;
+  u32 sent_packages;
+  unsigned long long total_ns;
+  unsigned long long handler_sum_ns;
+  unsigned long long handler_max_ns;
+  unsigned long long send_max_ns;
+} benchmark_result_t;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+static u32 random_seed;
+static unsigned long long send_max_ns;
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+static s32 BENCHMARK_Send(mios32_midi_package_t midi_package, seq_midi_out_event_type_t event_type, u32 timestamp, u32 len);
+static s32 BENCHMARK_PlayEvent(u8 track, mios32_midi_package_t midi_package, u32 tick);
+static s32 BENCHMARK_PlayMeta(u8 track, u8 meta, u32 len, u8 *buffer, u32 tick);
+
+
+/////////////////////////////////////////////////////////////////////////////
+// deterministic random generator, so that all methods get the same load
+/////////////////////////////////////////////////////////////////////////////
+static u32 BENCHMARK_Random(u32 range)
+{
+  random_seed = random_seed * 1103515245 + 12345;
+  return ((random_seed >> 16) & 0x7fff) % range;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// resets the scheduler and the analysis variables
+/////////////////////////////////////////////////////////////////////////////
+static void BENCHMARK_Reset(benchmark_result_t *result)
+{
+  SEQ_MIDI_OUT_FlushQueue();
+  SEQ_MIDI_OUT_Init(0);
+  SEQ_BPM_TickSet(0);
+
+  random_seed = 42;
+  send_max_ns = 0;
+  host_stubs_sent_packages = 0;
+
+  memset(result, 0, sizeof(benchmark_result_t));
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// increments the tick and calls the handler
+/////////////////////////////////////////////////////////////////////////////
+static void BENCHMARK_Tick(benchmark_result_t *result)
+{
+  SEQ_BPM_TickSet(++result->ticks);
+
+  unsigned long long t = HOST_STUBS_TimeGet();
+  SEQ_MIDI_OUT_Handler();
+  t = HOST_STUBS_TimeGet() - t;
+
+  result->handler_sum_ns += t;
+  if( t > result->handler_max_ns )
+    result->handler_max_ns = t;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// plays the demo MIDI file (like BENCHMARK_Start() of the core build)
+/////////////////////////////////////////////////////////////////////////////
+static s32 BENCHMARK_RunMidiFile(benchmark_result_t *result)
+{
+  BENCHMARK_Reset(result);
+
+  MID_FILE_open("dummy");
+  MID_PARSER_Read();
+
+  unsigned long long t = HOST_STUBS_TimeGet();
+
+  // step through song until last position reached
+  // wait additional BPM ticks to ensure that all events have been played
+  while( MID_PARSER_FetchEvents(result->ticks, 1) > 0 || seq_midi_out_allocated ) {
+    BENCHMARK_Tick(result);
+  }
+
+  result->total_ns = HOST_STUBS_TimeGet() - t;
+  result->sent_packages = host_stubs_sent_packages;
+  result->send_max_ns = send_max_ns;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// plays a synthetic sequence with the given number of tracks
+// each track plays a note with random gatelength and echo repeats at each
+// step, odd tracks are sustained and released with SEQ_MIDI_OUT_ReSchedule,
+// a CC is sent each 4th step, and MIDI clock is sent to all tracks
+/////////////////////////////////////////////////////////////////////////////
+static s32 BENCHMARK_RunSynthetic(benchmark_result_t *result, u32 num_tracks)
+{
+  BENCHMARK_Reset(result);
+
+  unsigned long long t = HOST_STUBS_TimeGet();
+
+  u32 end_tick = SYNTH_NUM_STEPS * SYNTH_STEP_TICKS;
+  u32 tick;
+  for(tick=0; tick < end_tick || seq_midi_out_allocated; tick=result->ticks) {
+    if( tick < end_tick ) {
+      if( (tick % SYNTH_CLOCK_TICKS) == 0 ) {
+	mios32_midi_package_t p;
+	p.ALL = 0;
+	p.type = 0x5; // Single-byte system common message
+	p.evnt0 = 0xf8;
+	BENCHMARK_Send(p, SEQ_MIDI_OUT_ClkEvent, tick, 0);
+      }
+
+      if( (tick % SYNTH_STEP_TICKS) == 0 ) {
+	u32 step = tick / SYNTH_STEP_TICKS;
+	u32 track;
+	for(track=0; track<num_tracks; ++track) {
+	  mios32_midi_package_t p;
+	  p.ALL = 0;
+	  p.cable = track & 0xf; // tag for re-scheduling
+
+	  // humanized timestamp
+	  u32 timestamp = tick + BENCHMARK_Random(8);
+
+	  if( (step % 4) == 0 ) {
+	    p.type = CC;
+	    p.event = CC;
+	    p.chn = track & 0xf;
+	    p.cc_number = 1;
+	    p.value = BENCHMARK_Random(128);
+	    BENCHMARK_Send(p, SEQ_MIDI_OUT_CCEvent, timestamp, 0);
+	  }
+
+	  p.type = NoteOn;
+	  p.event = NoteOn;
+	  p.chn = track & 0xf;
+	  p.note = 0x24 + BENCHMARK_Random(48);
+	  p.velocity = 1 + BENCHMARK_Random(127);
+
+	  if( track & 1 ) {
+	    // sustained note: release previous note, play the new one with an infinite Off event
+	    SEQ_MIDI_OUT_ReSchedule(p.cable, SEQ_MIDI_OUT_OffEvent, tick, NULL);
+	    BENCHMARK_Send(p, SEQ_MIDI_OUT_OnEvent, timestamp, 0);
+	    if( step < (SYNTH_NUM_STEPS-1) ) {
+	      mios32_midi_package_t p_off = p;
+	      p_off.velocity = 0;
+	      BENCHMARK_Send(p_off, SEQ_MIDI_OUT_OffEvent, 0xffffffff, 0);
+	    }
+	  } else {
+	    u32 len = 1 + BENCHMARK_Random(4*SYNTH_STEP_TICKS);
+	    int repeat;
+	    for(repeat=0; repeat<=SYNTH_ECHO_REPEATS; ++repeat) {
+	      BENCHMARK_Send(p, SEQ_MIDI_OUT_OnOffEvent, timestamp + repeat*(SYNTH_STEP_TICKS/2), len);
+	      p.velocity = (p.velocity > 16) ? (p.velocity - 16) : 1;
+	    }
+	  }
+	}
+      }
+    } else if( tick == end_tick ) {
+      u32 track;
+      for(track=1; track<num_tracks; track+=2)
+	SEQ_MIDI_OUT_ReSchedule(track & 0xf, SEQ_MIDI_OUT_OffEvent, tick, NULL);
+    }
+
+    BENCHMARK_Tick(result);
+  }
+
+  result->total_ns = HOST_STUBS_TimeGet() - t;
+  result->sent_packages = host_stubs_sent_packages;
+  result->send_max_ns = send_max_ns;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// prints the result of a benchmark run
+/////////////////////////////////////////////////////////////////////////////
+static void BENCHMARK_Print(const char *name, benchmark_result_t *result)
+{
+  double events_per_sec = result->total_ns ? ((double)result->sent_packages * 1e9 / (double)result->total_ns) : 0.0;
+
+  printf("M%d S%d %-10s %7u events %6.2f Mev/s | handler avg %5.2f max %7.2f uS | send max %7.2f uS | alloc max %4u drops %5u | insert avg %3u max %4u | dispatch avg %3u max %4u\n",
+	 SEQ_MIDI_OUT_MALLOC_METHOD,
+	 SEQ_MIDI_OUT_SCHEDULER,
+	 name,
+	 (unsigned)result->sent_packages,
+	 events_per_sec / 1e6,
+	 result->ticks ? ((double)result->handler_sum_ns / 1000.0 / (double)result->ticks) : 0.0,
+	 (double)result->handler_max_ns / 1000.0,
+	 (double)result->send_max_ns / 1000.0,
+	 (unsigned)seq_midi_out_max_allocated,
+	 (unsigned)seq_midi_out_dropouts,
+	 (unsigned)(seq_midi_out_sched_inserts ? (seq_midi_out_sched_insert_steps / seq_midi_out_sched_inserts) : 0),
+	 (unsigned)seq_midi_out_sched_insert_steps_max,
+	 (unsigned)(seq_midi_out_sched_dispatches ? (seq_midi_out_sched_dispatch_steps / seq_midi_out_sched_dispatches) : 0),
+	 (unsigned)seq_midi_out_sched_dispatch_steps_max);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// main
+/////////////////////////////////////////////////////////////////////////////
+int main(int argc, char *argv[])
+{
+  benchmark_result_t result;
+
+  host_stubs_debug_enabled = (argc > 1 && strcmp(argv[1], "-v") == 0);
+
+  MID_FILE_Init(0);
+  MID_PARSER_Init(0);
+  SEQ_MIDI_OUT_Init(0);
+
+  MID_PARSER_InstallFileCallbacks(&MID_FILE_read, &MID_FILE_eof, &MID_FILE_seek);
+  MID_PARSER_InstallEventCallbacks(&BENCHMARK_PlayEvent, &BENCHMARK_PlayMeta);
+
+  BENCHMARK_RunMidiFile(&result);
+  BENCHMARK_Print("demo.mid", &result);
+
+  BENCHMARK_RunSynthetic(&result, 16);
+  BENCHMARK_Print("16 tracks", &result);
+
+  BENCHMARK_RunSynthetic(&result, 64);
+  BENCHMARK_Print("64 tracks", &result);
+
+  SEQ_MIDI_OUT_FlushQueue();
+  SEQ_MIDI_OUT_FreeHeap();
+
+  return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// schedules an event and measures the insert time
+/////////////////////////////////////////////////////////////////////////////
+static s32 BENCHMARK_Send(mios32_midi_package_t midi_package, seq_midi_out_event_type_t event_type, u32 timestamp, u32 len)
+{
+  unsigned long long t = HOST_STUBS_TimeGet();
+  s32 status = SEQ_MIDI_OUT_Send(BENCHMARK_PORT, midi_package, event_type, timestamp, len);
+  t = HOST_STUBS_TimeGet() - t;
+
+  if( t > send_max_ns )
+    send_max_ns = t;
+
+  return status;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// called when a MIDI event should be played at a given tick
+/////////////////////////////////////////////////////////////////////////////
+static s32 BENCHMARK_PlayEvent(u8 track, mios32_midi_package_t midi_package, u32 tick)
+{
+  seq_midi_out_event_type_t event_type = SEQ_MIDI_OUT_OnEvent;
+  if( midi_package.event == NoteOff || (midi_package.event == NoteOn && midi_package.velocity == 0) )
+    event_type = SEQ_MIDI_OUT_OffEvent;
+
+  return BENCHMARK_Send(midi_package, event_type, tick, 0);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// called when a Meta event should be played/processed at a given tick
+/////////////////////////////////////////////////////////////////////////////
+static s32 BENCHMARK_PlayMeta(u8 track, u8 meta, u32 len, u8 *buffer, u32 tick)
+{
+  return 0; // no error
+}
@@ -22,6 +22,7 @@
 // 3: internal static allocation with 32bit flags
 // 4: FreeRTOS based pvPortMalloc
 // 5: malloc provided by library
+// 6: internal static allocation with free-list (constant allocation time)
 #define SEQ_MIDI_OUT_MALLOC_METHOD 3
 
 // max number of scheduled events which will allocate memory
@@ -32,5 +33,13 @@
 // enable seq_midi_out_max_allocated and seq_midi_out_dropouts
 #define SEQ_MIDI_OUT_MALLOC_ANALYSIS 1
 
+// scheduler method:
+// 0: sorted linked list (insert O(n), dispatch O(1))
+// 1: binary heap with tag index (insert and dispatch O(log n))
+#define SEQ_MIDI_OUT_SCHEDULER 0
+
+// enable seq_midi_out_sched_* counters
+#define SEQ_MIDI_OUT_SCHEDULER_ANALYSIS 1
+
 
 #endif /* _MIOS32_CONFIG_H */
@@ -129,6 +129,53 @@ static u16 event_pool_maps_begin;
 static u16 event_pool_num_items;
 static u16 event_pool_num_maps;
 
+// index for MBNG_EVENT_MIDI_NotifyPackage: items which can receive MIDI events are
+// hashed by the first two bytes of their stream, items which match any second byte
+// (use_any_key_or_cc, matrices, PitchBend, NRPN, ...) are hashed with MBNG_EVENT_INDEX_ANY
+// disabled by default on LPC17, since the event pool already occupies most of the AHB RAM
+#ifndef MBNG_EVENT_MIDI_INDEX
+# if defined(MIOS32_FAMILY_STM32F4xx)
+#  define MBNG_EVENT_MIDI_INDEX 1
+# else
+#  define MBNG_EVENT_MIDI_INDEX 0
+# endif
+#endif
+
+#ifndef MBNG_EVENT_INDEX_HASH_BITS
+#define MBNG_EVENT_INDEX_HASH_BITS 8
+#endif
+#define MBNG_EVENT_INDEX_HASH_SIZE (1 << MBNG_EVENT_INDEX_HASH_BITS)
+#define MBNG_EVENT_INDEX_HASH(evnt0, evnt1) ((u16)((((u16)(evnt0) << 8) | (evnt1)) * 40503) >> (16-MBNG_EVENT_INDEX_HASH_BITS))
+#define MBNG_EVENT_INDEX_ANY 0x80 // can't be a MIDI data byte
+#define MBNG_EVENT_INDEX_EMPTY 0xffff
+// the indices cover a pool in which each item has at least a 2 byte stream
+// pools with more (smaller) items are searched without index
+#define MBNG_EVENT_INDEX_MAX_ITEMS (MBNG_EVENT_POOL_MAX_SIZE / (sizeof(mbng_event_pool_item_t)-1+2))
+
+// sorted id and hw_id tables for MBNG_EVENT_ItemSearchById/ByHwId
+// disabled by default if the pool is located in the (small) AHB RAM
+#ifndef MBNG_EVENT_ID_INDEX
+# if defined(MIOS32_FAMILY_STM32F4xx)
+#  define MBNG_EVENT_ID_INDEX 1
+# else
+#  define MBNG_EVENT_ID_INDEX 0
+# endif
+#endif
+
+// (not located in AHB_SECTION, on LPC17 this RAM is reserved for the event pool)
+static u8 event_index_valid;
+#if MBNG_EVENT_MIDI_INDEX || MBNG_EVENT_ID_INDEX
+static u16 event_index_pool_offset[MBNG_EVENT_INDEX_MAX_ITEMS]; // pool offset of each item
+#endif
+#if MBNG_EVENT_MIDI_INDEX
+static u16 event_index_hash[MBNG_EVENT_INDEX_HASH_SIZE]; // first item of each chain
+static u16 event_index_next[MBNG_EVENT_INDEX_MAX_ITEMS];  // next item in chain (items are in pool order)
+#endif
+#if MBNG_EVENT_ID_INDEX
+static u16 event_index_by_id[MBNG_EVENT_INDEX_MAX_ITEMS];    // item numbers sorted by id
+static u16 event_index_by_hw_id[MBNG_EVENT_INDEX_MAX_ITEMS]; // item numbers sorted by hw_id
+#endif
+
 // last active event
 mbng_event_item_id_t last_event_item_id;
 
@@ -185,6 +232,8 @@ static u8 lc_meters[LC_METERS_NUM_PORTS][LC_METERS_NUM_ITEMS];
 static s32 MBNG_EVENT_ItemCopy2User(mbng_event_pool_item_t* pool_item, mbng_event_item_t *item);
 static s32 MBNG_EVENT_ItemCopy2Pool(mbng_event_item_t *item, mbng_event_pool_item_t* pool_item);
 
+static s32 MBNG_EVENT_IndexBuild(void);
+
 static s32 MBNG_EVENT_LCMeters_Update(void);
 static s32 MBNG_EVENT_LCMeters_Set(u8 port_ix, u8 lc_meter_value);
 static s32 MBNG_EVENT_LCMeters_Tick(void);
@@ -370,6 +419,7 @@ s32 MBNG_EVENT_PoolClear(void)
   event_pool_maps_begin = 0;
   event_pool_num_items = 0;
   event_pool_num_maps = 0;
+  event_index_valid = 0;
 
   last_event_item_id = 0;
 
@@ -406,7 +456,198 @@ s32 MBNG_EVENT_PoolUpdate(void)
     pool_ptr += pool_item->len;
   }
 
+  // rebuild the index for incoming MIDI events
+  MBNG_EVENT_IndexBuild();
+
+  return 0; // no error
+}
+
+
+#if MBNG_EVENT_ID_INDEX
+/////////////////////////////////////////////////////////////////////////////
+//! Help functions for the id/hw_id tables: returns the key of an item
+/////////////////////////////////////////////////////////////////////////////
+static inline u16 MBNG_EVENT_IndexKey(u16 item_ix, u8 by_hw_id)
+{
+  mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)&event_pool[event_index_pool_offset[item_ix]];
+  return by_hw_id ? pool_item->hw_id : pool_item->id;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! Sorts a table by key, items with the same key are sorted by item number
+//! (shell sort: no recursion, no additional memory)
+/////////////////////////////////////////////////////////////////////////////
+static void MBNG_EVENT_IndexSort(u16 *table, u16 num_items, u8 by_hw_id)
+{
+  u16 gap;
+  for(gap=num_items/2; gap>0; gap/=2) {
+    u16 i;
+    for(i=gap; i<num_items; ++i) {
+      u16 item_ix = table[i];
+      u16 key = MBNG_EVENT_IndexKey(item_ix, by_hw_id);
+      u16 j;
+      for(j=i; j>=gap; j-=gap) {
+	u16 prev_ix = table[j-gap];
+	u16 prev_key = MBNG_EVENT_IndexKey(prev_ix, by_hw_id);
+	if( prev_key < key || (prev_key == key && prev_ix < item_ix) )
+	  break;
+	table[j] = prev_ix;
+      }
+      table[j] = item_ix;
+    }
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! Searches an item with the given key in a sorted table. The search continues
+//! at table position *table_pos, with *table_pos == 0 the first entry of the
+//! key will be searched.
+//! Only active items are considered if requested.
+//! Items with the same key are returned in pool order.
+//! \returns the matching item number and the table position of the next
+//! entry in *table_pos, -1 if no item found
+/////////////////////////////////////////////////////////////////////////////
+static s32 MBNG_EVENT_IndexSearch(u16 *table, u8 by_hw_id, u16 key, u16 *table_pos, u8 only_active)
+{
+  u16 num_items = event_pool_num_items;
+  u16 pos = *table_pos;
+
+  if( !pos ) {
+    // binary search for the first entry >= key
+    u16 hi = num_items;
+    while( pos < hi ) {
+      u16 mid = (pos + hi) / 2;
+      if( MBNG_EVENT_IndexKey(table[mid], by_hw_id) < key )
+	pos = mid + 1;
+      else
+	hi = mid;
+    }
+  }
+
+  for(; pos<num_items; ++pos) {
+    u16 item_ix = table[pos];
+    if( MBNG_EVENT_IndexKey(item_ix, by_hw_id) != key )
+      break; // no more entries with this key
+
+    if( only_active ) {
+      mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)&event_pool[event_index_pool_offset[item_ix]];
+      if( !pool_item->flags.active )
+	continue;
+    }
+
+    *table_pos = pos + 1;
+    return item_ix;
+  }
+
+  return -1; // not found
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! Copies an item which has been found in a table, and sets continue_ix
+//! to the table position of the next entry (upper half)
+/////////////////////////////////////////////////////////////////////////////
+static s32 MBNG_EVENT_IndexItemCopy2User(u16 item_ix, u16 table_pos, mbng_event_item_t *item, u32 *continue_ix)
+{
+  mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)&event_pool[event_index_pool_offset[item_ix]];
+  MBNG_EVENT_ItemCopy2User(pool_item, item);
+
+  if( table_pos >= event_pool_num_items )
+    *continue_ix = 0;
+  else
+    *continue_ix = (u32)table_pos << 16;
+
+  return 0; // no error
+}
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Help function for the index of incoming MIDI events: returns the hash of
+//! an item, or MBNG_EVENT_INDEX_EMPTY if the item doesn't receive MIDI events
+/////////////////////////////////////////////////////////////////////////////
+static u16 MBNG_EVENT_IndexHash(mbng_event_pool_item_t *pool_item)
+{
+  u8 *stream = &pool_item->data_begin;
+  u16 hw_type = pool_item->hw_id & 0xf000;
+
+  if( !pool_item->len_stream )
+    return MBNG_EVENT_INDEX_EMPTY; // no MIDI event
+
+  if( hw_type == MBNG_EVENT_CONTROLLER_SENDER )
+    return MBNG_EVENT_INDEX_EMPTY; // a sender doesn't receive
+
+  // hash with second byte only if it has to match
+  u8 evnt1 = MBNG_EVENT_INDEX_ANY;
+  mbng_event_type_t event_type = ((mbng_event_flags_t)pool_item->flags).type;
+  if( event_type <= MBNG_EVENT_TYPE_CC &&
+      pool_item->len_stream >= 2 &&
+      !pool_item->flags.use_any_key_or_cc &&
+      hw_type != MBNG_EVENT_CONTROLLER_BUTTON_MATRIX &&
+      hw_type != MBNG_EVENT_CONTROLLER_LED_MATRIX ) {
+    evnt1 = stream[1];
+  }
+
+  return MBNG_EVENT_INDEX_HASH(stream[0], evnt1);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Builds the indices which are used by MBNG_EVENT_MIDI_NotifyPackage to find
+//! the items which could match to an incoming MIDI event, and by
+//! MBNG_EVENT_ItemSearchById/ByHwId.
+//! Called by MBNG_EVENT_PoolUpdate, and on the next search if the pool has
+//! been changed by MBNG_EVENT_ItemAdd or MBNG_EVENT_ItemModify in between
+//! (e.g. during MIDI learn)
+/////////////////////////////////////////////////////////////////////////////
+static s32 MBNG_EVENT_IndexBuild(void)
+{
+#if !MBNG_EVENT_MIDI_INDEX && !MBNG_EVENT_ID_INDEX
+  return -1; // no index
+#else
+  if( event_pool_num_items > MBNG_EVENT_INDEX_MAX_ITEMS )
+    return -1; // too many items, the pool will be searched without index
+
+  // determine the pool offset of each item
+  u8 *pool_ptr = (u8 *)&event_pool[0];
+  u32 i;
+  for(i=0; i<event_pool_num_items; ++i) {
+    mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)pool_ptr;
+    event_index_pool_offset[i] = (u32)pool_item - (u32)&event_pool[0];
+#if MBNG_EVENT_ID_INDEX
+    event_index_by_id[i] = i;
+    event_index_by_hw_id[i] = i;
+#endif
+    pool_ptr += pool_item->len;
+  }
+
+#if MBNG_EVENT_MIDI_INDEX
+  // build the chains for incoming MIDI events in reverse order, so that each chain is in pool order
+  for(i=0; i<MBNG_EVENT_INDEX_HASH_SIZE; ++i) {
+    event_index_hash[i] = MBNG_EVENT_INDEX_EMPTY;
+  }
+
+  s32 ix;
+  for(ix=event_pool_num_items-1; ix>=0; --ix) {
+    mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)&event_pool[event_index_pool_offset[ix]];
+    u16 hash = MBNG_EVENT_IndexHash(pool_item);
+    if( hash == MBNG_EVENT_INDEX_EMPTY )
+      continue; // item doesn't receive MIDI events
+
+    event_index_next[ix] = event_index_hash[hash];
+    event_index_hash[hash] = ix;
+  }
+#endif
+
+#if MBNG_EVENT_ID_INDEX
+  // sort id/hw_id tables
+  MBNG_EVENT_IndexSort(event_index_by_id, event_pool_num_items, 0);
+  MBNG_EVENT_IndexSort(event_index_by_hw_id, event_pool_num_items, 1);
+#endif
+
+  event_index_valid = 1;
+
   return 0; // no error
+#endif
 }
 
 
@@ -1426,6 +1667,7 @@ s32 MBNG_EVENT_ItemAdd(mbng_event_item_t *item)
   event_pool_size += pool_item->len;
   ++event_pool_num_items;
   event_pool_maps_begin += pool_item_len;
+  event_index_valid = 0;
 
   return 0; // no error
 }
@@ -1451,6 +1693,10 @@ s32 MBNG_EVENT_ItemModify(mbng_event_item_t *item)
       if( len_diff >= 0 && (event_pool_size+len_diff) > MBNG_EVENT_POOL_MAX_SIZE )
 	return -2; // out of storage 
 
+      // keys of the indices before modification
+      u16 prev_hw_id = pool_item->hw_id;
+      u16 prev_hash = MBNG_EVENT_IndexHash(pool_item);
+
       if( len_diff != 0 ) {
 	// make room
 	u8 *old_next_pool_item = (u8 *)((u32)pool_item + pool_item->len);
@@ -1485,6 +1731,11 @@ s32 MBNG_EVENT_ItemModify(mbng_event_item_t *item)
 	MBNG_EVENT_ItemCopy2Pool(item, pool_item);
       }
 
+      // the indices have to be rebuilt if the following items have been moved, or if a key has been changed
+      // (e.g. value changes during a NGR loop keep the indices valid)
+      if( len_diff != 0 || pool_item->hw_id != prev_hw_id || MBNG_EVENT_IndexHash(pool_item) != prev_hash )
+	event_index_valid = 0;
+
       return 0; // operation was successfull
     }
     pool_ptr += pool_item->len;
@@ -1500,6 +1751,19 @@ s32 MBNG_EVENT_ItemModify(mbng_event_item_t *item)
 /////////////////////////////////////////////////////////////////////////////
 s32 MBNG_EVENT_ItemSearchById(mbng_event_item_id_t id, mbng_event_item_id_t id_end_range, mbng_event_item_t *item, u32 *continue_ix)
 {
+#if MBNG_EVENT_ID_INDEX
+  // ranges are searched in the pool, so that items are returned in pool order
+  if( !id_end_range && (event_index_valid || MBNG_EVENT_IndexBuild() >= 0) ) {
+    // upper half of continue_ix: table position of the next entry
+    u16 table_pos = *continue_ix >> 16;
+    s32 item_ix = MBNG_EVENT_IndexSearch(event_index_by_id, 0, id, &table_pos, 0);
+    if( item_ix < 0 )
+      return -1; // not found
+
+    return MBNG_EVENT_IndexItemCopy2User(item_ix, table_pos, item, continue_ix); // item found
+  }
+#endif
+
   u8 *pool_ptr = (u8 *)&event_pool[0];
   u32 i = 0;
 
@@ -1542,6 +1806,19 @@ s32 MBNG_EVENT_ItemSearchById(mbng_event_item_id_t id, mbng_event_item_id_t id_e
 /////////////////////////////////////////////////////////////////////////////
 s32 MBNG_EVENT_ItemSearchByHwId(mbng_event_item_id_t hw_id, mbng_event_item_id_t hw_id_end_range, mbng_event_item_t *item, u32 *continue_ix)
 {
+#if MBNG_EVENT_ID_INDEX
+  // ranges are searched in the pool, so that items are returned in pool order
+  if( !hw_id_end_range && (event_index_valid || MBNG_EVENT_IndexBuild() >= 0) ) {
+    // upper half of continue_ix: table position of the next entry
+    u16 table_pos = *continue_ix >> 16;
+    s32 item_ix = MBNG_EVENT_IndexSearch(event_index_by_hw_id, 1, hw_id, &table_pos, 1);
+    if( item_ix < 0 )
+      return -1; // not found
+
+    return MBNG_EVENT_IndexItemCopy2User(item_ix, table_pos, item, continue_ix); // item found
+  }
+#endif
+
   u8 *pool_ptr = (u8 *)&event_pool[0];
   u32 i = 0;
 
@@ -4470,6 +4747,105 @@ s32 MBNG_EVENT_Dump(void)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+//! Help function for MBNG_EVENT_MIDI_NotifyPackage: forwards a received MIDI
+//! event to a pool item whose first stream byte is matching
+/////////////////////////////////////////////////////////////////////////////
+static s32 MBNG_EVENT_MIDI_NotifyItem(mbng_event_pool_item_t *pool_item, u32 port_mask, mios32_midi_package_t midi_package, u16 nrpn_address, u16 nrpn_value, u8 nrpn_msb_only)
+{
+  u8 evnt1 = midi_package.evnt1;
+
+  if( (pool_item->hw_id & 0xf000) == MBNG_EVENT_CONTROLLER_SENDER ) // a sender doesn't receive
+    return 0;
+
+  if( !(pool_item->enabled_ports & port_mask) ) // port not enabled
+    return 0;
+
+  mbng_event_type_t event_type = ((mbng_event_flags_t)pool_item->flags).type;
+  if( event_type <= MBNG_EVENT_TYPE_CC ) {
+    u8 *stream = &pool_item->data_begin;
+    if( pool_item->flags.use_any_key_or_cc || stream[1] == evnt1 ) { // || pool_item->secondary_value >= 128 || evnt1 == pool_item->secondary_value ) {
+      mbng_event_item_t item;
+      MBNG_EVENT_ItemCopy2User(pool_item, &item);
+      if( item.flags.use_key_or_cc ) {
+	item.secondary_value = midi_package.value;
+	MBNG_EVENT_ItemReceive(&item, midi_package.evnt1, 1, 1);
+      } else {
+	item.secondary_value = midi_package.evnt1;
+	MBNG_EVENT_ItemReceive(&item, midi_package.value, 1, 1);
+      }
+    } else {
+      // EXTRA for button/led matrices
+      int matrix = (pool_item->hw_id & 0x0fff) - 1;
+      int num_pins = -1;
+
+      switch( pool_item->hw_id & 0xf000 ) {
+      case MBNG_EVENT_CONTROLLER_BUTTON_MATRIX: {
+	if( matrix >= 0 && matrix < MBNG_PATCH_NUM_MATRIX_DIN ) {
+	  mbng_patch_matrix_din_entry_t *m = (mbng_patch_matrix_din_entry_t *)&mbng_patch_matrix_din[matrix];
+
+	  if( m->sr_din1 ) {
+	    u8 row_size = m->sr_din2 ? 16 : 8;
+	    num_pins = row_size * row_size;
+	  }
+	}
+      } break;
+      case MBNG_EVENT_CONTROLLER_LED_MATRIX: {
+	if( matrix >= 0 && matrix < MBNG_PATCH_NUM_MATRIX_DOUT ) {
+	  mbng_patch_matrix_dout_entry_t *m = (mbng_patch_matrix_dout_entry_t *)&mbng_patch_matrix_dout[matrix];
+
+	  if( m->sr_dout_r1 && !pool_item->flags.led_matrix_pattern ) {
+	    u8 row_size = m->sr_dout_r2 ? 16 : 8; // we assume that the same condition is valid for dout_g2 and dout_b2
+	    num_pins = row_size * row_size;
+	  }
+	}
+      } break;
+      }
+
+      if( num_pins >= 0 ) {
+	int first_evnt1 = stream[1];
+	if( evnt1 >= first_evnt1 && evnt1 < (first_evnt1 + num_pins) ) {
+	  mbng_event_item_t item;
+	  MBNG_EVENT_ItemCopy2User(pool_item, &item);
+	  item.matrix_pin = evnt1 - first_evnt1;
+	  MBNG_EVENT_ItemReceive(&item, midi_package.value, 1, 1);
+	}
+      }
+    }
+  } else if( event_type <= MBNG_EVENT_TYPE_AFTERTOUCH ) {
+    mbng_event_item_t item;
+    MBNG_EVENT_ItemCopy2User(pool_item, &item);
+    MBNG_EVENT_ItemReceive(&item, evnt1, 1, 1);
+  } else if( event_type == MBNG_EVENT_TYPE_PITCHBEND ) {
+    mbng_event_item_t item;
+    MBNG_EVENT_ItemCopy2User(pool_item, &item);
+    MBNG_EVENT_ItemReceive(&item, evnt1 | ((u16)midi_package.value << 7), 1, 1);
+  } else if( event_type == MBNG_EVENT_TYPE_NRPN ) {
+    u8 *stream = &pool_item->data_begin;
+    u16 expected_address = stream[1] | ((u16)stream[2] << 7);
+    mbng_event_nrpn_format_t nrpn_format = stream[3];
+    if( nrpn_address == expected_address &&
+	(!nrpn_msb_only || nrpn_format == MBNG_EVENT_NRPN_FORMAT_MSB_ONLY) ) {
+      mbng_event_item_t item;
+      MBNG_EVENT_ItemCopy2User(pool_item, &item);
+
+      if( nrpn_format == MBNG_EVENT_NRPN_FORMAT_MSB_ONLY )
+	MBNG_EVENT_ItemReceive(&item, nrpn_value / 128, 1, 1);
+      else
+	MBNG_EVENT_ItemReceive(&item, nrpn_value, 1, 1);
+    }
+  } else if( event_type >= MBNG_EVENT_TYPE_CLOCK && event_type <= MBNG_EVENT_TYPE_CONT ) {
+    mbng_event_item_t item;
+    MBNG_EVENT_ItemCopy2User(pool_item, &item);
+    MBNG_EVENT_ItemReceive(&item, 0, 1, 1);
+  } else {
+    // no additional event types yet...
+  }
+
+  return 0; // no error
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 //! This function should be called from APP_MIDI_NotifyPackage whenver a new
 //! MIDI event has been received
@@ -4665,104 +5041,44 @@ s32 MBNG_EVENT_MIDI_NotifyPackage(mios32_midi_port_t port, mios32_midi_package_t
 
   // search in pool for matching events
   u8 evnt0 = midi_package.evnt0;
-  u8 evnt1 = midi_package.evnt1;
-  u8 *pool_ptr = (u8 *)&event_pool[0];
-  u32 i;
-  for(i=0; i<event_pool_num_items; ++i) {
-    mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)pool_ptr;
-    if( pool_item->data_begin == evnt0 && pool_item->len_stream ) { // timing critical
-      // first byte is matching - now we've a bit more time for checking
-      
-      if( (pool_item->hw_id & 0xf000) == MBNG_EVENT_CONTROLLER_SENDER ) { // a sender doesn't receive
-	pool_ptr += pool_item->len;
-	continue;
-      }
 
-      if( !(pool_item->enabled_ports & port_mask) ) { // port not enabled
-	pool_ptr += pool_item->len;
-	continue;
+#if MBNG_EVENT_MIDI_INDEX
+  if( event_index_valid || MBNG_EVENT_IndexBuild() >= 0 ) {
+    // walk through the chain of this event, and the chain of items which match to any second byte
+    // both chains are in pool order, entries with lower index are handled first
+    u16 hash = MBNG_EVENT_INDEX_HASH(evnt0, midi_package.evnt1);
+    u16 hash_any = MBNG_EVENT_INDEX_HASH(evnt0, MBNG_EVENT_INDEX_ANY);
+    u16 ix_key = event_index_hash[hash];
+    u16 ix_any = (hash_any != hash) ? event_index_hash[hash_any] : MBNG_EVENT_INDEX_EMPTY;
+    // (stop if the pool has been changed by a received event)
+    while( event_index_valid && (ix_key != MBNG_EVENT_INDEX_EMPTY || ix_any != MBNG_EVENT_INDEX_EMPTY) ) {
+      u16 ix;
+      if( ix_key < ix_any ) {
+	ix = ix_key;
+	ix_key = event_index_next[ix];
+      } else {
+	ix = ix_any;
+	ix_any = event_index_next[ix];
       }
 
-      mbng_event_type_t event_type = ((mbng_event_flags_t)pool_item->flags).type;
-      if( event_type <= MBNG_EVENT_TYPE_CC ) {
-	u8 *stream = &pool_item->data_begin;
-	if( pool_item->flags.use_any_key_or_cc || stream[1] == evnt1 ) { // || pool_item->secondary_value >= 128 || evnt1 == pool_item->secondary_value ) {
-	  mbng_event_item_t item;
-	  MBNG_EVENT_ItemCopy2User(pool_item, &item);
-	  if( item.flags.use_key_or_cc ) {
-	    item.secondary_value = midi_package.value;
-	    MBNG_EVENT_ItemReceive(&item, midi_package.evnt1, 1, 1);
-	  } else {
-	    item.secondary_value = midi_package.evnt1;
-	    MBNG_EVENT_ItemReceive(&item, midi_package.value, 1, 1);
-	  }
-	} else {
-	  // EXTRA for button/led matrices
-	  int matrix = (pool_item->hw_id & 0x0fff) - 1;
-	  int num_pins = -1;
-
-	  switch( pool_item->hw_id & 0xf000 ) {
-	  case MBNG_EVENT_CONTROLLER_BUTTON_MATRIX: {
-	    if( matrix >= 0 && matrix < MBNG_PATCH_NUM_MATRIX_DIN ) {
-	      mbng_patch_matrix_din_entry_t *m = (mbng_patch_matrix_din_entry_t *)&mbng_patch_matrix_din[matrix];
-
-	      if( m->sr_din1 ) {
-		u8 row_size = m->sr_din2 ? 16 : 8;
-		num_pins = row_size * row_size;
-	      }
-	    }
-	  } break;
-	  case MBNG_EVENT_CONTROLLER_LED_MATRIX: {
-	    if( matrix >= 0 && matrix < MBNG_PATCH_NUM_MATRIX_DOUT ) {
-	      mbng_patch_matrix_dout_entry_t *m = (mbng_patch_matrix_dout_entry_t *)&mbng_patch_matrix_dout[matrix];
-
-	      if( m->sr_dout_r1 && !pool_item->flags.led_matrix_pattern ) {
-		u8 row_size = m->sr_dout_r2 ? 16 : 8; // we assume that the same condition is valid for dout_g2 and dout_b2
-		num_pins = row_size * row_size;
-	      }
-	    }
-	  } break;
-	  }
+      // the chains can contain items of other events which have the same hash
+      mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)&event_pool[event_index_pool_offset[ix]];
+      if( pool_item->data_begin == evnt0 && pool_item->len_stream ) { // timing critical
+	MBNG_EVENT_MIDI_NotifyItem(pool_item, port_mask, midi_package, nrpn_address, nrpn_value, nrpn_msb_only);
+      }
+    }
 
-	  if( num_pins >= 0 ) {
-	    int first_evnt1 = stream[1];
-	    if( evnt1 >= first_evnt1 && evnt1 < (first_evnt1 + num_pins) ) {
-	      mbng_event_item_t item;
-	      MBNG_EVENT_ItemCopy2User(pool_item, &item);
-	      item.matrix_pin = evnt1 - first_evnt1;
-	      MBNG_EVENT_ItemReceive(&item, midi_package.value, 1, 1);
-	    }
-	  }
-	}
-      } else if( event_type <= MBNG_EVENT_TYPE_AFTERTOUCH ) {
-	mbng_event_item_t item;
-	MBNG_EVENT_ItemCopy2User(pool_item, &item);
-	MBNG_EVENT_ItemReceive(&item, evnt1, 1, 1);
-      } else if( event_type == MBNG_EVENT_TYPE_PITCHBEND ) {
-	mbng_event_item_t item;
-	MBNG_EVENT_ItemCopy2User(pool_item, &item);
-	MBNG_EVENT_ItemReceive(&item, evnt1 | ((u16)midi_package.value << 7), 1, 1);
-      } else if( event_type == MBNG_EVENT_TYPE_NRPN ) {
-	u8 *stream = &pool_item->data_begin;
-	u16 expected_address = stream[1] | ((u16)stream[2] << 7);
-	mbng_event_nrpn_format_t nrpn_format = stream[3];
-	if( nrpn_address == expected_address &&
-	    (!nrpn_msb_only || nrpn_format == MBNG_EVENT_NRPN_FORMAT_MSB_ONLY) ) {
-	  mbng_event_item_t item;
-	  MBNG_EVENT_ItemCopy2User(pool_item, &item);
+    return 0; // no error
+  }
+#endif
 
-	  if( nrpn_format == MBNG_EVENT_NRPN_FORMAT_MSB_ONLY )
-	    MBNG_EVENT_ItemReceive(&item, nrpn_value / 128, 1, 1);
-	  else
-	    MBNG_EVENT_ItemReceive(&item, nrpn_value, 1, 1);
-	}
-      } else if( event_type >= MBNG_EVENT_TYPE_CLOCK && event_type <= MBNG_EVENT_TYPE_CONT ) {
-	mbng_event_item_t item;
-	MBNG_EVENT_ItemCopy2User(pool_item, &item);
-	MBNG_EVENT_ItemReceive(&item, 0, 1, 1);
-      } else {
-	// no additional event types yet...
-      }
+  // no index available: search through the whole pool
+  u8 *pool_ptr = (u8 *)&event_pool[0];
+  u32 i;
+  for(i=0; i<event_pool_num_items; ++i) {
+    mbng_event_pool_item_t *pool_item = (mbng_event_pool_item_t *)pool_ptr;
+    if( pool_item->data_begin == evnt0 && pool_item->len_stream ) { // timing critical
+      MBNG_EVENT_MIDI_NotifyItem(pool_item, port_mask, midi_package, nrpn_address, nrpn_value, nrpn_msb_only);
     }
     pool_ptr += pool_item->len;
   }
@@ -16,6 +16,7 @@
 /////////////////////////////////////////////////////////////////////////////
 
 #include <mios32.h>
+#include <string.h>
 #include "app.h"
 #include <FreeRTOS.h>
 #include <task.h>
@@ -34,6 +35,10 @@
 #define CHECK_STEP 0xF2
 #define INITIAL_SECTOR_INC 0x1000
 
+// throughput measurement: number of sectors, and sectors per multi-sector access
+#define THROUGHPUT_SECTORS 512
+#define THROUGHPUT_BLOCK_SECTORS 16
+
 // display messages
 #define DISPLAY_TASK_DELAYMS 100
 #define DISPLAY_TASK_MSG_COUNTDOWN_STARTVALUE 10
@@ -46,6 +51,7 @@
 #define SDCARD_CHECK_PHASE_FIND_FIRSTSECTOR 4
 #define SDCARD_CHECK_PHASE_FIND_LASTSECTOR 5
 #define SDCARD_CHECK_PHASE_DEEPCHECK 6
+#define SDCARD_CHECK_PHASE_THROUGHPUT 7
 #define SDCARD_CHECK_PHASE_FINISHED 16
 
 // errors
@@ -65,6 +71,8 @@ static s32 check_sdcard_buffer(void);
 static void clear_sdcard_buffer(void);
 static s32 check_sector_rw(void);
 static s32 sdcard_try_connect();
+static s32 throughput_transfer(u8 write, u8 multi);
+static void measure_throughput(void);
 
 /////////////////////////////////////////////////////////////////////////////
 // Global Variables
@@ -85,6 +93,11 @@ volatile u8 last_error;
 volatile u16 subseq_check_errors;
 u8 sdcard_buffer[0x200];
 
+// transfer time in mS: single sector write, multi sector write, single sector read, multi sector read
+volatile u32 throughput_ms[4];
+volatile u8 throughput_valid;
+u8 throughput_buffer[THROUGHPUT_BLOCK_SECTORS*0x200];
+
 u8 was_available;
 
 
@@ -169,7 +182,7 @@ void APP_Background(void){
         break;
       case SDCARD_CHECK_PHASE_DEEPCHECK://deep check all sectors
         if(sector > last_sector_rw){
-          phase = SDCARD_CHECK_PHASE_FINISHED;
+          phase = SDCARD_CHECK_PHASE_THROUGHPUT;
           subseq_check_errors = 0;
           }
         else{
@@ -183,6 +196,10 @@ void APP_Background(void){
             sector += CHECK_STEP;
           }
         break;
+      case SDCARD_CHECK_PHASE_THROUGHPUT://measure transfer rates of single and multi sector accesses
+        measure_throughput();
+        phase = SDCARD_CHECK_PHASE_FINISHED;
+        break;
       }
     }
   }
@@ -251,6 +268,61 @@ static s32 sdcard_try_connect(){
   return 1;
   }
 
+// writes or reads THROUGHPUT_SECTORS starting at first_sector_rw, either sector
+// by sector or with THROUGHPUT_BLOCK_SECTORS per multi sector access
+// returns the transfer time in mS, or < 0 on errors
+static s32 throughput_transfer(u8 write, u8 multi){
+  s32 resp;
+  u32 s;
+  u32 timestamp = MIOS32_TIMESTAMP_Get();
+  for(s = 0; s < THROUGHPUT_SECTORS; s += multi ? THROUGHPUT_BLOCK_SECTORS : 1){
+    u8 *buffer = &throughput_buffer[(s % THROUGHPUT_BLOCK_SECTORS)*0x200];
+    if(multi)
+      resp = write ? MIOS32_SDCARD_SectorsWrite(first_sector_rw + s, buffer, THROUGHPUT_BLOCK_SECTORS)
+                   : MIOS32_SDCARD_SectorsRead(first_sector_rw + s, buffer, THROUGHPUT_BLOCK_SECTORS);
+    else
+      resp = write ? MIOS32_SDCARD_SectorWrite(first_sector_rw + s, buffer)
+                   : MIOS32_SDCARD_SectorRead(first_sector_rw + s, buffer);
+    if(resp){
+      last_error = write ? SDCARD_CHECK_ERROR_WRITE : SDCARD_CHECK_ERROR_READ;
+      last_error_code = resp;
+      return -1;
+      }
+    }
+  return MIOS32_TIMESTAMP_GetDelay(timestamp);
+  }
+
+static void measure_throughput(void){
+  u32 i;
+  s32 ms;
+  throughput_valid = 0;
+  if(first_sector_rw == 0xffffffff || (last_sector_rw - first_sector_rw) < THROUGHPUT_SECTORS)
+    return;
+  for(i = 0; i < sizeof(throughput_buffer); i++)
+    throughput_buffer[i] = (u8)(i ^ (i >> 9));
+  // 0: single write, 1: multi write, 2: single read, 3: multi read
+  for(i = 0; i < 4; i++){
+    if(i >= 2)
+      memset(throughput_buffer, 0, sizeof(throughput_buffer));
+    if((ms = throughput_transfer(i < 2, i & 1)) < 0){
+      subseq_check_errors = 1;// notify error
+      sdcard_try_connect();
+      return;
+      }
+    throughput_ms[i] = ms ? ms : 1;
+    }
+  // compare data of the last multi sector read
+  for(i = 0; i < sizeof(throughput_buffer); i++){
+    if(throughput_buffer[i] != (u8)(i ^ (i >> 9))){
+      last_error = SDCARD_CHECK_ERROR_COMPARE;
+      last_error_code = 0;
+      subseq_check_errors = 1;// notify error
+      return;
+      }
+    }
+  throughput_valid = 1;
+  }
+
 /////////////////////////////////////////////////////////////////////////////
 // This task is running endless in background to drive display-output
 /////////////////////////////////////////////////////////////////////////////
@@ -306,6 +378,15 @@ static void TASK_Display(void *pvParameters){
           msg_countdown = 0;// restart message countdown if it was disabled
           }
         break;
+      case SDCARD_CHECK_PHASE_THROUGHPUT:
+        if(msg_countdown != -phase){
+          MIOS32_LCD_Clear();
+	  MIOS32_LCD_CursorSet(0,0);
+	  MIOS32_LCD_PrintString("Throughput test..");
+          MIOS32_MIDI_SendDebugMessage("Measuring throughput with %d sectors..", THROUGHPUT_SECTORS);
+          msg_countdown = -phase;
+          }
+        break;
       case SDCARD_CHECK_PHASE_FINISHED:
         if(msg_countdown != -phase){// was this stuff already printed/ sent do debug condsole?
           msg_countdown = -phase;// disable further message output in this phase
@@ -317,6 +398,13 @@ static void TASK_Display(void *pvParameters){
 	    MIOS32_LCD_PrintFormattedString("0x%08X",last_sector_rw);
 	    MIOS32_MIDI_SendDebugMessage("Sectors 0x%08X - 0x%08X checked, %d bad sectors",
 	      first_sector_rw,last_sector_rw,bad_sector_count);
+	    if(throughput_valid){
+	      u32 kbytes = THROUGHPUT_SECTORS / 2;
+	      MIOS32_MIDI_SendDebugMessage("Write: single sector %d kB/s, %d sectors %d kB/s",
+	        kbytes*1000/throughput_ms[0], THROUGHPUT_BLOCK_SECTORS, kbytes*1000/throughput_ms[1]);
+	      MIOS32_MIDI_SendDebugMessage("Read:  single sector %d kB/s, %d sectors %d kB/s",
+	        kbytes*1000/throughput_ms[2], THROUGHPUT_BLOCK_SECTORS, kbytes*1000/throughput_ms[3]);
+	      }
 	    }
 	  else{
 	    switch(last_error){
@@ -61,6 +61,7 @@
 // 0: off
 // 1: CV processing only
 // 2: CV processing + mapping
+// 3: output interrupt in block processing mode (CV_TIMER_SE_Output, incl. AOUT_UpdateDMA)
 //#define STOPWATCH_PERFORMANCE_MEASURING 2
 #define STOPWATCH_PERFORMANCE_MEASURING 0
 
@@ -80,6 +81,16 @@ static u8  cv_se_overloaded;
 static u32 cv_se_overload_check_ctr = 0;
 static u32 cv_se_last_mios32_timestamp = 0;
 
+// block processing: the engine renders blocks of cv_se_block_size update cycles
+// into a buffer of two blocks, the frames are sent by a second timer at the update rate
+static u8  cv_se_block_size = 0; // 0: engine updated directly by the timer
+static u8  cv_se_frame_rd;
+static u8  cv_se_frame_wr;
+static u8  cv_se_frames_primed;
+static volatile u8 cv_se_frames_available;
+static u32 cv_se_frame_underruns;
+static MbCvFrameT cv_se_frames[2*APP_CV_BLOCK_SIZE_MAX];
+
 /////////////////////////////////////////////////////////////////////////////
 // C++ objects
 /////////////////////////////////////////////////////////////////////////////
@@ -90,6 +101,8 @@ MbCvEnvironment mbCvEnvironment;
 // Local prototypes
 /////////////////////////////////////////////////////////////////////////////
 extern void CV_TIMER_SE_Update(void);
+extern void CV_TIMER_SE_Output(void);
+static void CV_TIMER_Init(void);
 static s32 NOTIFY_MIDI_Rx(mios32_midi_port_t port, u8 byte);
 static s32 NOTIFY_MIDI_Tx(mios32_midi_port_t port, mios32_midi_package_t package);
 static s32 NOTIFY_MIDI_TimeOut(mios32_midi_port_t port);
@@ -375,7 +388,8 @@ extern void CV_TIMER_SE_Update(void)
   }
 
   // check MIOS32 timestamp each second
-  if( ++cv_se_overload_check_ctr >= (cv_se_speed_factor*500) ) {
+  cv_se_overload_check_ctr += cv_se_block_size ? cv_se_block_size : 1;
+  if( cv_se_overload_check_ctr >= (cv_se_speed_factor*500) ) {
     u32 timestamp = MIOS32_TIMESTAMP_Get();
     u32 delay = timestamp - cv_se_last_mios32_timestamp;
     cv_se_overload_check_ctr = 0;
@@ -389,6 +403,35 @@ extern void CV_TIMER_SE_Update(void)
   if( cv_se_overloaded )
     return;
 
+  if( cv_se_block_size ) {
+    // block processing: render the next block if it fits into the buffer
+    // (the frames are sent by CV_TIMER_SE_Output)
+    if( cv_se_frames_available > cv_se_block_size )
+      return; // output stalled
+
+#if STOPWATCH_PERFORMANCE_MEASURING == 1 || STOPWATCH_PERFORMANCE_MEASURING == 2
+    APP_StopwatchReset();
+#endif
+
+    mbCvEnvironment.tickBlock(&cv_se_frames[cv_se_frame_wr], cv_se_block_size);
+
+#if STOPWATCH_PERFORMANCE_MEASURING == 1 || STOPWATCH_PERFORMANCE_MEASURING == 2
+    APP_StopwatchCapture();
+#endif
+
+    cv_se_frame_wr += cv_se_block_size;
+    if( cv_se_frame_wr >= 2*cv_se_block_size )
+      cv_se_frame_wr = 0;
+
+    MIOS32_IRQ_Disable(); // must be atomic, CV_TIMER_SE_Output has a higher priority
+    cv_se_frames_available += cv_se_block_size;
+    MIOS32_IRQ_Enable();
+
+    // start ADC conversions
+    MIOS32_AIN_StartConversions();
+    return;
+  }
+
 #if STOPWATCH_PERFORMANCE_MEASURING == 1 || STOPWATCH_PERFORMANCE_MEASURING == 2
   APP_StopwatchReset();
 #endif
@@ -413,6 +456,74 @@ extern void CV_TIMER_SE_Update(void)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// This timer interrupt sends the frames rendered in block processing mode
+// It runs at the update rate with a higher priority than CV_TIMER_SE_Update
+// The load is only AOUT_PinSet for each channel and the preparation of the
+// DMA buffer, it never waits for SPI transfers (the MAX525 gate pins are
+// part of the DMA transfer as well). Measure it with STOPWATCH_PERFORMANCE_MEASURING 3
+/////////////////////////////////////////////////////////////////////////////
+extern void CV_TIMER_SE_Output(void)
+{
+  u8 available = cv_se_frames_available;
+
+  // start once two blocks are available, so that the engine can take up to
+  // one block period to render the next block
+  if( !cv_se_frames_primed ) {
+    if( available < 2*cv_se_block_size )
+      return;
+    cv_se_frames_primed = 1;
+  }
+
+  if( !available ) {
+    // engine didn't deliver in time: keep the current outputs and wait for two blocks again
+    ++cv_se_frame_underruns;
+    cv_se_frames_primed = 0;
+    return;
+  }
+
+#if STOPWATCH_PERFORMANCE_MEASURING == 3
+  APP_StopwatchReset();
+#endif
+
+  MbCvFrameT *frame = &cv_se_frames[cv_se_frame_rd];
+  MBCV_MAP_UpdateOutputs(frame->cvOut, frame->cvGates, frame->clockRunning, frame->externalClocks, 1);
+
+#if STOPWATCH_PERFORMANCE_MEASURING == 3
+  APP_StopwatchCapture();
+#endif
+
+  if( ++cv_se_frame_rd >= 2*cv_se_block_size )
+    cv_se_frame_rd = 0;
+
+  --cv_se_frames_available; // atomic, since CV_TIMER_SE_Update can't interrupt this handler
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// (Re-)starts the timers for the selected update rate and block size
+// should be called with disabled interrupts
+/////////////////////////////////////////////////////////////////////////////
+static void CV_TIMER_Init(void)
+{
+  u32 period = 2000 / cv_se_speed_factor;
+
+  if( cv_se_block_size ) {
+    cv_se_frame_rd = 0;
+    cv_se_frame_wr = 0;
+    cv_se_frames_primed = 0;
+    cv_se_frames_available = 0;
+
+    // the block period is a multiple of the output period, so that both timers stay in sync
+    MIOS32_TIMER_Init(2, cv_se_block_size * period, CV_TIMER_SE_Update, MIOS32_IRQ_PRIO_MID);
+    MIOS32_TIMER_Init(1, period, CV_TIMER_SE_Output, MIOS32_IRQ_PRIO_HIGH);
+  } else {
+    MIOS32_TIMER_DeInit(1);
+    MIOS32_TIMER_Init(2, period, CV_TIMER_SE_Update, MIOS32_IRQ_PRIO_MID);
+  }
+}
+
+
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -650,8 +761,8 @@ s32 APP_CvUpdateRateFactorSet(u8 factor)
   cv_se_speed_factor = factor;
   mbCvEnvironment.updateSpeedFactorSet(cv_se_speed_factor);
 
-  // start timer
-  MIOS32_TIMER_Init(2, 2000 / cv_se_speed_factor, CV_TIMER_SE_Update, MIOS32_IRQ_PRIO_MID);
+  // start timer(s)
+  CV_TIMER_Init();
 
   // clear overload indicators
   cv_se_overloaded = 0;
@@ -669,6 +780,47 @@ s32 APP_CvUpdateRateFactorGet(void)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Block Size (0: engine is updated directly by the timer, 1..APP_CV_BLOCK_SIZE_MAX:
+// engine renders blocks of update cycles, outputs are sent via DMA)
+/////////////////////////////////////////////////////////////////////////////
+s32 APP_CvBlockSizeSet(u8 size)
+{
+  if( size > APP_CV_BLOCK_SIZE_MAX )
+    return -1; // invalid size
+
+  MIOS32_IRQ_Disable();
+
+  cv_se_block_size = size;
+
+  // restart timer(s) (if update rate already configured)
+  if( cv_se_speed_factor )
+    CV_TIMER_Init();
+
+  // clear overload indicators
+  cv_se_overloaded = 0;
+  cv_se_overload_check_ctr = 0;
+  cv_se_last_mios32_timestamp = MIOS32_TIMESTAMP_Get();
+
+  MIOS32_IRQ_Enable();
+
+  return 0; // no error
+}
+
+s32 APP_CvBlockSizeGet(void)
+{
+  return cv_se_block_size;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the number of frames which couldn't be sent in time
+/////////////////////////////////////////////////////////////////////////////
+u32 APP_CvBlockUnderrunsGet(void)
+{
+  return cv_se_frame_underruns;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Speed Factor (engine will be updated at factor * 500 Hz)
 /////////////////////////////////////////////////////////////////////////////
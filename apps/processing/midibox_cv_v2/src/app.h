@@ -21,6 +21,9 @@
 
 #define APP_CV_UPDATE_RATE_FACTOR_MAX 20
 
+// max. number of update cycles rendered in one block
+#define APP_CV_BLOCK_SIZE_MAX 16
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Global Types
@@ -69,6 +72,9 @@ extern s32 APP_SelectMainLCD(void);
 
 extern s32 APP_CvUpdateRateFactorSet(u8 factor);
 extern s32 APP_CvUpdateRateFactorGet(void);
+extern s32 APP_CvBlockSizeSet(u8 size);
+extern s32 APP_CvBlockSizeGet(void);
+extern u32 APP_CvBlockUnderrunsGet(void);
 extern s32 APP_CvBipolarOutputDisplaySet(u8 value);
 extern s32 APP_CvBipolarOutputDisplayGet(void);
 extern s32 APP_CvUpdateOverloadStatusGet(void);
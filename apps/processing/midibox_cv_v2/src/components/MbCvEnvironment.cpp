@@ -28,6 +28,24 @@
 #define CV_BANK_NUM 1  // currently only a single bank is available in ROM
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Determines the peak value of each CV channel within a block
+/////////////////////////////////////////////////////////////////////////////
+static void blockPeak(u16 *peak, const MbCvFrameT *frames, u8 numFrames)
+{
+    for(int i=0; i<CV_SE_NUM; ++i)
+        peak[i] = 0;
+
+    const MbCvFrameT *frame = frames;
+    for(int f=0; f<numFrames; ++f, ++frame) {
+        for(int i=0; i<CV_SE_NUM; ++i) {
+            if( frame->cvOut[i] > peak[i] )
+                peak[i] = frame->cvOut[i];
+        }
+    }
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Constructor
 /////////////////////////////////////////////////////////////////////////////
@@ -102,6 +120,63 @@ void MbCvEnvironment::updateSpeedFactorSet(u8 _updateSpeedFactor)
 // Sound Engines Update Cycle
 /////////////////////////////////////////////////////////////////////////////
 bool MbCvEnvironment::tick(void)
+{
+    bool updateRequired = tickEngines();
+
+    if( updateRequired ) {
+        mapOutputs();
+
+        // update meters
+        u16 *out = cvOut.first();
+        u16 *outMeter = cvOutMeter.first();
+        for(int cv=0; cv < cvOut.size; ++cv, ++out, ++outMeter) {
+            if( *out > *outMeter ) {
+                *outMeter = *out;
+            }
+        }
+    }
+
+    return updateRequired;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Block processing: executes numFrames update cycles
+// The engines are still updated cycle by cycle since they can modulate each
+// other. CV values, gates and clock states of each cycle are stored into the
+// frames, which are sent to the outputs by the caller (see app.cpp)
+/////////////////////////////////////////////////////////////////////////////
+void MbCvEnvironment::tickBlock(MbCvFrameT *frames, u8 numFrames)
+{
+    MbCvFrameT *frame = frames;
+    for(int f=0; f<numFrames; ++f, ++frame) {
+        if( tickEngines() )
+            mapOutputs();
+
+        memcpy(frame->cvOut, cvOut.first(), sizeof(frame->cvOut));
+        frame->cvGates = cvGates;
+        frame->clockRunning = mbCvClock.isRunning;
+        frame->externalClocks = mbCvClock.externalClocks;
+    }
+
+    // meters only take the peak value of the block
+    u16 peak[CV_SE_NUM] __attribute__((aligned(4)));
+    blockPeak(peak, frames, numFrames);
+
+    u16 *outMeter = cvOutMeter.first();
+    for(int cv=0; cv < cvOutMeter.size; ++cv, ++outMeter) {
+        if( peak[cv] > *outMeter ) {
+            *outMeter = peak[cv];
+        }
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Updates the clock and all engines
+// returns true if CV registers have to be updated
+/////////////////////////////////////////////////////////////////////////////
+bool MbCvEnvironment::tickEngines(void)
 {
     bool updateRequired = false;
 
@@ -144,15 +219,22 @@ bool MbCvEnvironment::tick(void)
         }
     }
 
-    if( updateRequired ) {
-        // map engine parameters to CV outputs
-        // we do this as a second step, so that it will be possible to map values
-        // of a single engine to different channels in future
+    return updateRequired;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Maps engine parameters to CV outputs
+// we do this as a second step, so that it will be possible to map values
+// of a single engine to different channels in future
+/////////////////////////////////////////////////////////////////////////////
+void MbCvEnvironment::mapOutputs(void)
+{
+    {
         cvGates = 0;
         MbCv *s = mbCv.first();
         u16 *out = cvOut.first();
-        u16 *outMeter = cvOutMeter.first();
-        for(int cv=0; cv < cvOut.size; ++cv, ++s, ++out, ++outMeter) {
+        for(int cv=0; cv < cvOut.size; ++cv, ++s, ++out) {
             MbCvVoice *v = &s->mbCvVoice;
             MbCvMidiVoice *mv = (MbCvMidiVoice *)v->midiVoicePtr;
 
@@ -177,14 +259,8 @@ bool MbCvEnvironment::tick(void)
             if( v->voiceForceToScale ) {
                 *out = scaleValue(*out / 512) * 512;
             }
-
-            if( *out > *outMeter ) {
-                *outMeter = *out;
-            }
         }
     }
-
-    return updateRequired;
 }
 
 
@@ -24,6 +24,14 @@
 #include "MbCvPatch.h"
 #include "MbCvScope.h"
 
+// one update cycle of all CV channels, rendered by MbCvEnvironment::tickBlock()
+typedef struct {
+    u16 cvOut[CV_SE_NUM];
+    u32 cvGates;
+    bool clockRunning;
+    u8 externalClocks;
+} MbCvFrameT;
+
 class MbCvEnvironment
 {
 public:
@@ -67,6 +75,10 @@ public:
     // returns true if CV registers have to be updated
     bool tick(void);
 
+    // Block processing: executes numFrames update cycles of all engines
+    // and stores the CV outputs of each cycle into the given frames
+    void tickBlock(MbCvFrameT *frames, u8 numFrames);
+
     // Should be called each mS from a thread, e.g. for synchronized patch changes
     void tick_1mS(void);
 
@@ -147,6 +159,10 @@ public:
     u16 lastNrpnCvChannels;
 
 protected:
+    // engine update and output mapping, used by tick() and tickBlock()
+    bool tickEngines(void);
+    void mapOutputs(void);
+
     // MIDI NRPN variables
     u16 nrpnAddress[16];
     u16 nrpnValue[16];
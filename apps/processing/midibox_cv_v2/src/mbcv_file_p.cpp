@@ -307,6 +307,17 @@ s32 MBCV_FILE_P_Read(char *filename)
             APP_CvUpdateRateFactorSet(factor);
           }
 
+        } else if( strcasecmp(parameter, "CV_BlockSize") == 0 ) {
+          s32 size;
+          char *word = remove_quotes(strtok_r(NULL, separators, &brkt));
+          if( (size=get_dec(word)) < 0 || size > APP_CV_BLOCK_SIZE_MAX ) {
+#if DEBUG_VERBOSE_LEVEL >= 1
+            DEBUG_MSG("[MBCV_FILE_P] ERROR '%s' should be between 0..%d\n", parameter, APP_CV_BLOCK_SIZE_MAX);
+#endif
+          } else {
+            APP_CvBlockSizeSet(size);
+          }
+
         } else if( strcasecmp(parameter, "CV_BipolarOutputDisplay") == 0 ) {
           s32 value;
           char *word = remove_quotes(strtok_r(NULL, separators, &brkt));
@@ -713,6 +724,10 @@ static s32 MBCV_FILE_P_Write_Hlp(u8 write_to_file)
   FLUSH_BUFFER;
   sprintf(line_buffer, "CV_UpdateRateFactor %d\n", APP_CvUpdateRateFactorGet());
   FLUSH_BUFFER;
+  sprintf(line_buffer, "\n# Block Processing (0: off, 1..%d: update cycles rendered at once)\n", APP_CV_BLOCK_SIZE_MAX);
+  FLUSH_BUFFER;
+  sprintf(line_buffer, "CV_BlockSize %d\n", APP_CvBlockSizeGet());
+  FLUSH_BUFFER;
   sprintf(line_buffer, "CV_BipolarOutputDisplay %d\n", APP_CvBipolarOutputDisplayGet());
   FLUSH_BUFFER;
 
@@ -163,9 +163,20 @@ extern "C" s32 MBCV_MAP_Update(void)
   // retrieve the AOUT values of all channels
   MbCvEnvironment* env = APP_GetEnv();
 
+  return MBCV_MAP_UpdateOutputs(env->cvOut.first(), env->cvGates, env->mbCvClock.isRunning, env->mbCvClock.externalClocks, 0);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Updates the outputs with the given CV values, gates and clock states
+// (used for frames rendered in block processing mode)
+// if use_dma is set, the AOUT channels are sent via SPI DMA in background
+/////////////////////////////////////////////////////////////////////////////
+extern "C" s32 MBCV_MAP_UpdateOutputs(u16 *cv_out, u32 gates, u8 clock_running, u8 external_clocks, u8 use_dma)
+{
   u8 caliMode = AOUT_CaliModeGet();
   u8 caliPin = AOUT_CaliPinGet();
-  u16 *out = env->cvOut.first();
+  u16 *out = cv_out;
   for(int cv=0; cv<CV_SE_NUM; ++cv, ++out) {
     if( caliMode == 0 || caliPin != cv ) {
       AOUT_PinSet(cv, *out);
@@ -173,24 +184,27 @@ extern "C" s32 MBCV_MAP_Update(void)
   }
 
   // update AOUTs
-  AOUT_Update();
+  if( use_dma )
+    AOUT_UpdateDMA();
+  else
+    AOUT_Update();
 
-  AOUT_DigitalPinsSet(env->cvGates);
+  AOUT_DigitalPinsSet(gates);
 
   // gates and DIN sync signals are available at shift registers
-  u8 gates = AOUT_DigitalPinsGet();
+  u8 dout_gates = AOUT_DigitalPinsGet();
   u8 din_sync_value = 0;
   {
-    if( env->mbCvClock.isRunning )
+    if( clock_running )
       din_sync_value |= (1 << 0); // START/STOP
 
-    din_sync_value |= env->mbCvClock.externalClocks << 1;
+    din_sync_value |= external_clocks << 1;
   }
 
   // following DOUT transfers should be atomic to ensure, that all pins are updated at the same scan cycle
   MIOS32_IRQ_Disable();
   if( mbcv_hwcfg_dout.gate_sr )
-    MIOS32_DOUT_SRSet(mbcv_hwcfg_dout.gate_sr-1, gates);
+    MIOS32_DOUT_SRSet(mbcv_hwcfg_dout.gate_sr-1, dout_gates);
   if( mbcv_hwcfg_dout.clk_sr )
     MIOS32_DOUT_SRSet(mbcv_hwcfg_dout.clk_sr-1, din_sync_value);
   MIOS32_IRQ_Enable();
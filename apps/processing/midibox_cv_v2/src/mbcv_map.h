@@ -56,6 +56,7 @@ extern "C" u16 MBCV_MAP_CaliPointGet(u8 cv);
 extern "C" s32 MBCV_MAP_CaliPointSet(u32 cv, u16 value);
 
 extern s32 MBCV_MAP_Update(void);
+extern s32 MBCV_MAP_UpdateOutputs(u16 *cv_out, u32 gates, u8 clock_running, u8 external_clocks, u8 use_dma);
 
 extern s32 MBCV_MAP_ResetAllChannels(void);
 
@@ -273,7 +273,8 @@ s32 TERMINAL_ParseLine(char *input, void *_output_function)
       MIDIMON_TerminalHelp(_output_function);
       MIDI_ROUTER_TerminalHelp(_output_function);
       out("  set dout <pin> <0|1>:             directly sets DOUT (all or 0..%d) to given level (1 or 0)", MIOS32_SRIO_NUM_SR*8 - 1);
-      out("  set update_rate <1..%d>:          sets update rate of sound engine (factor*500 Hz), current: %d\n", APP_CV_UPDATE_RATE_FACTOR_MAX, APP_CvUpdateRateFactorGet());
+      out("  set update_rate <1..%d>:          sets update rate of sound engine (factor*500 Hz), current: %d", APP_CV_UPDATE_RATE_FACTOR_MAX, APP_CvUpdateRateFactorGet());
+      out("  set block_size <0..%d>:           number of update cycles rendered at once (0: off), current: %d\n", APP_CV_BLOCK_SIZE_MAX, APP_CvBlockSizeGet());
       AOUT_TerminalHelp(_output_function);
 #ifdef MIOS32_LCD_universal
       APP_LCD_TerminalHelp(_output_function);
@@ -423,6 +424,21 @@ s32 TERMINAL_ParseLine(char *input, void *_output_function)
 	    APP_CvUpdateRateFactorSet(factor);
 	    out("Update Rate set to %d Hz (factor %d)", 500*APP_CvUpdateRateFactorGet(), APP_CvUpdateRateFactorGet());
 	  }
+	} else if( strcmp(parameter, "block_size") == 0 ) {
+	  s32 size = -1;
+	  if( (parameter = strtok_r(NULL, separators, &brkt)) ) {
+	    size = get_dec(parameter);
+	  }
+
+	  if( (size < 0 || size > APP_CV_BLOCK_SIZE_MAX) ) {
+	    out("Block Size should be between 0..%d!", APP_CV_BLOCK_SIZE_MAX);
+	  } else {
+	    APP_CvBlockSizeSet(size);
+	    if( size )
+	      out("Block Size set to %d update cycles (%d uS latency), %u underruns so far", size, 2*size*(2000/APP_CvUpdateRateFactorGet()), APP_CvBlockUnderrunsGet());
+	    else
+	      out("Block processing disabled");
+	  }
 	} else {
 	  out("Unknown set parameter: '%s'!", parameter);
 	}
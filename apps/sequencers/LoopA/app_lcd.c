@@ -4,6 +4,11 @@
  * provides a resolution of 256x64)
  * Referenced from MIOS32_LCD routines
  *
+ * The screen is sent via a framebuffer: APP_LCD_FramebufferWrite() only
+ * copies a pixel row into RAM and marks it as dirty if it has been changed,
+ * APP_LCD_Flush() transfers the dirty rows. With APP_LCD_FRAMEBUFFER_SPI >= 0
+ * the rows are sent via SPI DMA in background (see app_lcd.h)
+ *
  * ==========================================================================
  *
  *  Copyright (C) 2011 Thorsten Klose (tk@midibox.org)
@@ -19,6 +24,7 @@
 /////////////////////////////////////////////////////////////////////////////
 
 #include <mios32.h>
+#include <string.h>
 
 #include "app_lcd.h"
 
@@ -40,12 +46,81 @@
 #define APP_LCD_USE_J10_FOR_CS 0
 #endif
 
+#if APP_LCD_FRAMEBUFFER_SPI >= 0
+# define APP_LCD_FLUSH_VIA_SPI 1
+#else
+# define APP_LCD_FLUSH_VIA_SPI 0
+#endif
+
+// first column address of the 256 pixels wide display (4 pixels per column)
+#define APP_LCD_COLUMN_OFFSET 0x1c
+
 /////////////////////////////////////////////////////////////////////////////
 // Local variables
 /////////////////////////////////////////////////////////////////////////////
 
 static u32 display_available = 0;
 
+static u8 lcd_framebuffer[APP_LCD_HEIGHT][APP_LCD_FRAMEBUFFER_ROW_SIZE];
+static volatile u32 lcd_dirty_rows[APP_LCD_HEIGHT/32]; // one flag per row
+
+#if APP_LCD_FLUSH_VIA_SPI
+static volatile u8 flush_busy;
+static u8 flush_row;
+static u8 flush_num_rows;
+static u8 flush_state;
+static u8 flush_cmd[5];
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+#if APP_LCD_FLUSH_VIA_SPI
+static void APP_LCD_FlushNextRows(void);
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Help functions for the dirty flags
+// (have to be called with disabled interrupts if a flush could be in progress)
+/////////////////////////////////////////////////////////////////////////////
+static inline u8 APP_LCD_RowDirty(u8 row)
+{
+  return (lcd_dirty_rows[row / 32] & (1UL << (row % 32))) ? 1 : 0;
+}
+
+static inline void APP_LCD_RowDirtySet(u8 row, u8 dirty)
+{
+  if( dirty )
+    lcd_dirty_rows[row / 32] |= (1UL << (row % 32));
+  else
+    lcd_dirty_rows[row / 32] &= ~(1UL << (row % 32));
+}
+
+static void APP_LCD_AllRowsDirty(void)
+{
+  int i;
+  MIOS32_IRQ_Disable();
+  for(i=0; i<(APP_LCD_HEIGHT/32); ++i)
+    lcd_dirty_rows[i] = 0xffffffff;
+  MIOS32_IRQ_Enable();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Selects the display (value 0) or all displays (value 0x00) via CS lines
+/////////////////////////////////////////////////////////////////////////////
+static inline void APP_LCD_CS_Set(u8 value)
+{
+#if APP_LCD_USE_J10_FOR_CS
+  MIOS32_BOARD_J10_Set(value);
+#else
+  MIOS32_BOARD_J15_DataSet(value);
+#endif
+}
+
 
 //-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
 //  Instruction Setting
@@ -279,6 +354,12 @@ s32 APP_LCD_Init(u32 mode)
   mios32_lcd_parameters.height = APP_LCD_HEIGHT;
   mios32_lcd_parameters.colour_depth = APP_LCD_COLOUR_DEPTH;
 
+#if APP_LCD_FLUSH_VIA_SPI
+  // SCLK is high when idle, data is taken with the rising edge
+  MIOS32_SPI_IO_Init(APP_LCD_FRAMEBUFFER_SPI, APP_LCD_OUTPUT_MODE ? MIOS32_SPI_PIN_DRIVER_STRONG_OD : MIOS32_SPI_PIN_DRIVER_STRONG);
+  MIOS32_SPI_TransferModeInit(APP_LCD_FRAMEBUFFER_SPI, MIOS32_SPI_MODE_CLK1_PHASE1, APP_LCD_FRAMEBUFFER_SPI_PRESCALER);
+#endif
+
   u16 ctr;
   for (ctr=0; ctr<300; ++ctr)
     MIOS32_DELAY_Wait_uS(1000);
@@ -363,6 +444,8 @@ s32 APP_LCD_Init(u32 mode)
   // Set_Partial_Display(0x01,0x00,0x00);// Disable Partial Display
   Set_Display_On();
 
+  // transfer the complete framebuffer with the next flush
+  APP_LCD_AllRowsDirty();
 
   return (display_available & (1 << mios32_lcd_device)) ? 0 : -1; // return -1 if display not available
 }
@@ -386,16 +469,21 @@ s32 APP_LCD_Data(u8 data)
 
   u8 cs=0;
 
-  // chip select and DC
-#if APP_LCD_USE_J10_FOR_CS
-  MIOS32_BOARD_J10_Set(~(1 << cs));
-#else
-  MIOS32_BOARD_J15_DataSet(~(1 << cs));
+#if APP_LCD_FLUSH_VIA_SPI
+  // wait until the framebuffer has been sent
+  while( flush_busy );
 #endif
+
+  // chip select and DC
+  APP_LCD_CS_Set(~(1 << cs));
   MIOS32_BOARD_J15_RS_Set(1); // RS pin used to control DC
 
   // send data
+#if APP_LCD_FLUSH_VIA_SPI
+  MIOS32_SPI_TransferByte(APP_LCD_FRAMEBUFFER_SPI, data);
+#else
   MIOS32_BOARD_J15_SerDataShift(data);
+#endif
 
   // increment graphical cursor
   ++mios32_lcd_x;
@@ -420,15 +508,20 @@ s32 APP_LCD_Data(u8 data)
 /////////////////////////////////////////////////////////////////////////////
 s32 APP_LCD_Cmd(u8 cmd)
 {
-  // select all LCDs
-#if APP_LCD_USE_J10_FOR_CS
-  MIOS32_BOARD_J10_Set(0x00);
-#else
-  MIOS32_BOARD_J15_DataSet(0x00);
+#if APP_LCD_FLUSH_VIA_SPI
+  // wait until the framebuffer has been sent
+  while( flush_busy );
 #endif
+
+  // select all LCDs
+  APP_LCD_CS_Set(0x00);
   MIOS32_BOARD_J15_RS_Set(0); // RS pin used to control DC
 
+#if APP_LCD_FLUSH_VIA_SPI
+  MIOS32_SPI_TransferByte(APP_LCD_FRAMEBUFFER_SPI, cmd);
+#else
   MIOS32_BOARD_J15_SerDataShift(cmd);
+#endif
 
   return 0; // no error
 }
@@ -441,26 +534,15 @@ s32 APP_LCD_Cmd(u8 cmd)
 /////////////////////////////////////////////////////////////////////////////
 s32 APP_LCD_Clear(void)
 {
-  u8 i, j;
-
-  for (j=0; j<64; j++)
-  {
-    APP_LCD_Cmd(0x15);
-    APP_LCD_Data(0+0x1c);
-
-    APP_LCD_Cmd(0x75);
-    APP_LCD_Data(j);
+#if APP_LCD_FLUSH_VIA_SPI
+  // wait until the framebuffer has been sent
+  while( flush_busy );
+#endif
 
-    APP_LCD_Cmd(0x5c);
+  memset(lcd_framebuffer, 0x00, sizeof(lcd_framebuffer));
+  APP_LCD_AllRowsDirty();
 
-    for (i=0; i<64; i++)
-    {
-       APP_LCD_Data(0);
-       APP_LCD_Data(0);
-    }
-  }
-
-  return 0;
+  return APP_LCD_Flush(0);
 }
 
 
@@ -592,3 +674,178 @@ s32 APP_LCD_BitmapPrint(mios32_lcd_bitmap_t bitmap)
 
   return 0; // no error
 }
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Copies a pixel row into the framebuffer (APP_LCD_FRAMEBUFFER_ROW_SIZE bytes,
+// 2 pixels per byte). The row is marked as dirty if it has been changed and
+// will be transfered with the next APP_LCD_Flush()
+// IN: <row>: 0..APP_LCD_HEIGHT-1, <data>: pixel data
+// OUT: returns < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 APP_LCD_FramebufferWrite(u8 row, u8 *data)
+{
+  if( row >= APP_LCD_HEIGHT )
+    return -1; // invalid row
+
+  if( memcmp(lcd_framebuffer[row], data, APP_LCD_FRAMEBUFFER_ROW_SIZE) == 0 )
+    return 0; // no change
+
+  memcpy(lcd_framebuffer[row], data, APP_LCD_FRAMEBUFFER_ROW_SIZE);
+
+  MIOS32_IRQ_Disable(); // must be atomic, flag could be cleared by DMA callback
+  APP_LCD_RowDirtySet(row, 1);
+  MIOS32_IRQ_Enable();
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Transfers the dirty rows of the framebuffer to the display
+// Consecutive dirty rows are sent with a single RAM write command
+// With APP_LCD_FRAMEBUFFER_SPI >= 0 the function returns immediately, and
+// the rows are sent via DMA in background
+// IN: <force>: if 1, all rows will be transfered
+// OUT: returns < 0 on errors
+//      returns 1 if the previous flush is still in progress. Rows which
+//      have been modified meanwhile will be sent with the next call
+/////////////////////////////////////////////////////////////////////////////
+s32 APP_LCD_Flush(u8 force)
+{
+  if( force )
+    APP_LCD_AllRowsDirty();
+
+#if APP_LCD_FLUSH_VIA_SPI
+  if( flush_busy )
+    return 1; // previous flush still in progress
+
+  flush_busy = 1;
+  flush_row = 0;
+  APP_LCD_FlushNextRows();
+#else
+  u8 row = 0;
+  while( row < APP_LCD_HEIGHT ) {
+    if( !APP_LCD_RowDirty(row) ) {
+      ++row;
+      continue;
+    }
+
+    // search for consecutive dirty rows
+    u8 num_rows = 0;
+    while( (row+num_rows) < APP_LCD_HEIGHT && APP_LCD_RowDirty(row+num_rows) ) {
+      APP_LCD_RowDirtySet(row+num_rows, 0);
+      ++num_rows;
+    }
+
+    // set column and row address, the end addresses have been set during initialisation
+    APP_LCD_Cmd(0x15);
+    APP_LCD_Data(APP_LCD_COLUMN_OFFSET);
+    APP_LCD_Cmd(0x75);
+    APP_LCD_Data(row);
+    APP_LCD_Cmd(0x5c); // Write RAM
+
+    // send data (CS and DC already set by APP_LCD_Data)
+    u8 *ptr = &lcd_framebuffer[row][0];
+    int i;
+    for(i=0; i<(num_rows*APP_LCD_FRAMEBUFFER_ROW_SIZE); ++i)
+      MIOS32_BOARD_J15_SerDataShift(*ptr++);
+
+    row += num_rows;
+  }
+#endif
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns 1 while the framebuffer is sent via SPI DMA
+// OUT: 0 if no flush is in progress
+/////////////////////////////////////////////////////////////////////////////
+s32 APP_LCD_FlushBusy(void)
+{
+#if APP_LCD_FLUSH_VIA_SPI
+  return flush_busy ? 1 : 0;
+#else
+  return 0; // transfers are blocking
+#endif
+}
+
+
+#if APP_LCD_FLUSH_VIA_SPI
+/////////////////////////////////////////////////////////////////////////////
+// DMA callback: sends the address commands, the pixel data and continues
+// with the next dirty rows
+// Commands and parameters are sent separately, since DC has to be switched
+// between them
+/////////////////////////////////////////////////////////////////////////////
+static void APP_LCD_FlushCallback(void)
+{
+  u8 state = flush_state++;
+  u8 *ptr;
+  u16 len;
+
+  if( state < sizeof(flush_cmd) ) {
+    // commands at even, parameters at odd positions
+    MIOS32_BOARD_J15_RS_Set(state & 1); // RS pin used to control DC
+    ptr = &flush_cmd[state];
+    len = 1;
+  } else if( state == sizeof(flush_cmd) ) {
+    MIOS32_BOARD_J15_RS_Set(1); // RS pin used to control DC
+    ptr = &lcd_framebuffer[flush_row][0];
+    len = flush_num_rows * APP_LCD_FRAMEBUFFER_ROW_SIZE;
+  } else {
+    flush_row += flush_num_rows;
+    APP_LCD_FlushNextRows();
+    return;
+  }
+
+  if( MIOS32_SPI_TransferBlock(APP_LCD_FRAMEBUFFER_SPI, ptr, NULL, len, APP_LCD_FlushCallback) < 0 ) {
+    // SPI not available: try again with next flush
+    int i;
+    MIOS32_IRQ_Disable();
+    for(i=0; i<flush_num_rows; ++i)
+      APP_LCD_RowDirtySet(flush_row+i, 1);
+    MIOS32_IRQ_Enable();
+    flush_busy = 0;
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Searches for the next dirty rows and starts the transfer
+// Called from APP_LCD_Flush() and from the DMA callback
+/////////////////////////////////////////////////////////////////////////////
+static void APP_LCD_FlushNextRows(void)
+{
+  u8 num_rows = 0;
+
+  MIOS32_IRQ_Disable(); // must be atomic
+  while( flush_row < APP_LCD_HEIGHT && !APP_LCD_RowDirty(flush_row) )
+    ++flush_row;
+  while( (flush_row+num_rows) < APP_LCD_HEIGHT && APP_LCD_RowDirty(flush_row+num_rows) ) {
+    APP_LCD_RowDirtySet(flush_row+num_rows, 0);
+    ++num_rows;
+  }
+  MIOS32_IRQ_Enable();
+
+  if( !num_rows ) {
+    // all dirty rows have been sent
+    flush_busy = 0;
+    return;
+  }
+
+  // set column and row address, the end addresses have been set during initialisation
+  flush_num_rows = num_rows;
+  flush_cmd[0] = 0x15;
+  flush_cmd[1] = APP_LCD_COLUMN_OFFSET;
+  flush_cmd[2] = 0x75;
+  flush_cmd[3] = flush_row;
+  flush_cmd[4] = 0x5c; // Write RAM
+
+  // select the display and start with the first command
+  APP_LCD_CS_Set(~(1 << 0));
+  flush_state = 0;
+  APP_LCD_FlushCallback();
+}
+#endif
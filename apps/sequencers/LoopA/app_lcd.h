@@ -36,6 +36,22 @@
 #define APP_LCD_COLOUR_DEPTH 1
 #define APP_LCD_BITMAP_SIZE ((APP_LCD_NUM_X*APP_LCD_WIDTH * APP_LCD_NUM_Y*APP_LCD_HEIGHT * APP_LCD_COLOUR_DEPTH) / 8)
 
+// the framebuffer stores 4bit grayscale values (2 pixels per byte)
+#define APP_LCD_FRAMEBUFFER_ROW_SIZE (APP_LCD_WIDTH/2)
+
+// -1: the framebuffer is flushed via J15 (serial data shift, blocking)
+// 0 (J16), 1 (J8/9) or 2 (J19): the framebuffer is flushed via given SPI peripheral with DMA in background,
+// SCLK/MOSI of the display have to be connected to this port, CS and DC lines are still driven from J15
+// (on a LoopA J16 is used by the SD Card and J8/9 by the SRIO chain, therefore only J19 is free)
+// can be changed from mios32_config.h
+#ifndef APP_LCD_FRAMEBUFFER_SPI
+#define APP_LCD_FRAMEBUFFER_SPI -1
+#endif
+
+#ifndef APP_LCD_FRAMEBUFFER_SPI_PRESCALER
+#define APP_LCD_FRAMEBUFFER_SPI_PRESCALER MIOS32_SPI_PRESCALER_16 // ca. 5 MBit
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Global Types
@@ -59,6 +75,10 @@ extern s32 APP_LCD_FColourSet(u32 rgb);
 extern s32 APP_LCD_BitmapPixelSet(mios32_lcd_bitmap_t bitmap, u16 x, u16 y, u32 colour);
 extern s32 APP_LCD_BitmapPrint(mios32_lcd_bitmap_t bitmap);
 
+extern s32 APP_LCD_FramebufferWrite(u8 row, u8 *data);
+extern s32 APP_LCD_Flush(u8 force);
+extern s32 APP_LCD_FlushBusy(void);
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Export global variables
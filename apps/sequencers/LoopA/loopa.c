@@ -93,6 +93,33 @@ s8 liveTransposeRequested_ = 0;       // If != active liveTranspose_, perform a
 u16 clipActiveNote_[TRACKS][SCENES];  // currently active edited note number, when in noteroll editor
 s8 valueEncoderAccel_ = 0;            // 1: value encoder pushed (while turning) -> accellerate data inputs
 
+// --- Playback index (not on disk) ---
+// notes of the active scene clips sorted by their transformed/quantized tick, so that loopaSeqTick()
+// only has to touch the notes which are due. Only modified by the sequencer task, the other tasks
+// request updates via clipIndexNoteChanged() and clipIndexInvalidate()
+typedef struct
+{
+   u16 tick;                          // transformed/quantized tick of the note
+   u16 noteNumber;                    // index in clipNotes_
+} ClipIndexEntry;
+
+typedef struct
+{
+   u8 scene;
+   u8 stretch;
+   s8 swing;
+   u16 steps;
+   s16 scroll;
+   u32 quantize;
+   u16 notesSize;
+} ClipIndexParams;                    // clip parameters the index has been built with
+
+static ClipIndexEntry clipIndex_[TRACKS][MAXNOTES];
+static u16 clipIndexSize_[TRACKS];
+static ClipIndexParams clipIndexParams_[TRACKS];
+static u8 clipIndexValid_[TRACKS];                          // 0: rebuild the complete index with the next tick
+static u32 clipIndexNoteChanged_[TRACKS][(MAXNOTES + 31) / 32];  // notes which have to be re-sorted with the next tick
+
 // =================================================================================================
 
 
@@ -175,11 +202,49 @@ u32 quantize(u32 tick, u32 quantizeMeasure, s8 swingPercent, u32 clipLengthInTic
 // -------------------------------------------------------------------------------------------------
 
 
+/**
+ * Clip fx probabilities/randomization: check if a note in a clip should be dropped
+ * @return 1, if the note fails the random test
+ *
+ */
+u8 probabilityDropsNote(u8 clip, u16 noteNumber)
+{
+   s8 randomMinimum = clipFxProbability_[clip][activeScene_];
+   if (randomMinimum)
+   {
+      srand(((millisecondsSinceStartup_ >> 5U) << 8U) + noteNumber);  // Newly rerandomize every ~ 32ms
+      if ((rand() % 100) < randomMinimum)
+         return 1;
+   }
+
+   return 0;
+}
+// -------------------------------------------------------------------------------------------------
+
+
 /**
  * Transform (stretch, scroll, probabilities/random) and then quantize/apply swing to a note in a clip
  *
  */
 s32 quantizeTransform(u8 clip, u16 noteNumber)
+{
+   s32 tick = quantizeTransformTick(clip, noteNumber);
+
+   // if clip fx probabilities/randomization is on, only consider notes that pass the random test
+   if (tick < 0 || probabilityDropsNote(clip, noteNumber))
+      return -1;
+
+   return tick;
+}
+// -------------------------------------------------------------------------------------------------
+
+
+/**
+ * Transform (stretch, scroll) and then quantize/apply swing to a note in a clip, without probabilities/random
+ * @return tick or -1, if the note is not within the clip length
+ *
+ */
+s32 quantizeTransformTick(u8 clip, u16 noteNumber)
 {
    // Idea: scroll first, and modulo-map to trackstart/end boundaries
    //       scale afterwards
@@ -198,15 +263,6 @@ s32 quantizeTransform(u8 clip, u16 noteNumber)
    if (tick >= clipLengthInTicks)
       return -1;
 
-   // if clip fx probabilities/randomization is on, only consider notes that pass the random test
-   s8 randomMinimum = clipFxProbability_[clip][activeScene_];
-   if (randomMinimum)
-   {
-      srand(((millisecondsSinceStartup_ >> 5U) << 8U) + noteNumber);  // Newly rerandomize every ~ 32ms
-      if ((rand() % 100) < randomMinimum)
-         return -1;
-   }
-
    // scroll
    tick += clipScroll_[clip][activeScene_] * TICKS_PER_STEP;
 
@@ -230,6 +286,167 @@ u32 getClipLengthInTicks(u8 clip)
 // -------------------------------------------------------------------------------------------------
 
 
+/**
+ * Playback index: request a re-sort of a (recorded or edited) note of the active scene clip
+ *
+ */
+void clipIndexNoteChanged(u8 clip, u16 noteNumber)
+{
+   if (clip < TRACKS && noteNumber < MAXNOTES)
+   {
+      MIOS32_IRQ_Disable();
+      clipIndexNoteChanged_[clip][noteNumber / 32] |= 1UL << (noteNumber % 32);
+      MIOS32_IRQ_Enable();
+   }
+}
+// -------------------------------------------------------------------------------------------------
+
+
+/**
+ * Playback index: request a rebuild of the complete index of the active scene clip (e.g. after notes have been replaced)
+ *
+ */
+void clipIndexInvalidate(u8 clip)
+{
+   if (clip < TRACKS)
+      clipIndexValid_[clip] = 0;
+}
+// -------------------------------------------------------------------------------------------------
+
+
+/**
+ * Playback index: find the first entry with a tick >= the given tick
+ *
+ */
+static u16 clipIndexFind(u8 clip, u32 tick)
+{
+   u16 lo = 0;
+   u16 hi = clipIndexSize_[clip];
+
+   while (lo < hi)
+   {
+      u16 mid = (lo + hi) >> 1U;
+      if (clipIndex_[clip][mid].tick < tick)
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+
+   return lo;
+}
+// -------------------------------------------------------------------------------------------------
+
+
+/**
+ * Playback index: insert a note at its sorted position
+ * Notes with the same tick are kept in note number order (like they were played before)
+ *
+ */
+static void clipIndexInsertNote(u8 clip, u16 noteNumber)
+{
+   s32 tick = noteNumber < clipNotesSize_[clip][activeScene_] ? quantizeTransformTick(clip, noteNumber) : -1;
+
+   if (tick >= 0) // only notes within the clip length are indexed
+   {
+      ClipIndexEntry *index = clipIndex_[clip];
+      u16 size = clipIndexSize_[clip];
+      u16 pos = clipIndexFind(clip, tick);
+
+      while (pos < size && index[pos].tick == tick && index[pos].noteNumber < noteNumber)
+         pos++;
+
+      memmove(&index[pos + 1], &index[pos], (size - pos) * sizeof(ClipIndexEntry));
+      index[pos].tick = tick;
+      index[pos].noteNumber = noteNumber;
+      clipIndexSize_[clip] = size + 1;
+   }
+}
+// -------------------------------------------------------------------------------------------------
+
+
+/**
+ * Playback index: remove a note from the index (if found) and insert it again at its new position
+ *
+ */
+static void clipIndexUpdateNote(u8 clip, u16 noteNumber)
+{
+   ClipIndexEntry *index = clipIndex_[clip];
+   u16 size = clipIndexSize_[clip];
+   u16 i;
+
+   for (i = 0; i < size; i++)
+   {
+      if (index[i].noteNumber == noteNumber)
+      {
+         memmove(&index[i], &index[i + 1], (size - i - 1) * sizeof(ClipIndexEntry));
+         clipIndexSize_[clip] = size - 1;
+         break;
+      }
+   }
+
+   clipIndexInsertNote(clip, noteNumber);
+}
+// -------------------------------------------------------------------------------------------------
+
+
+/**
+ * Playback index: bring the index of the active scene clip up to date, called by the sequencer task
+ * A clip parameter change (or invalidation) leads to a complete rebuild, recorded/edited notes are
+ * re-sorted incrementally
+ *
+ */
+static void clipIndexUpdate(u8 clip)
+{
+   ClipIndexParams params;
+   params.scene = activeScene_;
+   params.stretch = clipStretch_[clip][activeScene_];
+   params.swing = clipFxSwing_[clip][activeScene_];
+   params.steps = clipSteps_[clip][activeScene_];
+   params.scroll = clipScroll_[clip][activeScene_];
+   params.quantize = clipFxQuantize_[clip][activeScene_];
+   params.notesSize = clipNotesSize_[clip][activeScene_];
+
+   ClipIndexParams *prev = &clipIndexParams_[clip];
+
+   // get and clear pending requests
+   u32 changed[(MAXNOTES + 31) / 32];
+   MIOS32_IRQ_Disable();
+   u8 valid = clipIndexValid_[clip];
+   clipIndexValid_[clip] = 1;
+   memcpy(changed, clipIndexNoteChanged_[clip], sizeof(changed));
+   memset(clipIndexNoteChanged_[clip], 0, sizeof(changed));
+   MIOS32_IRQ_Enable();
+
+   u16 i;
+   if (!valid || params.scene != prev->scene || params.stretch != prev->stretch || params.swing != prev->swing ||
+       params.steps != prev->steps || params.scroll != prev->scroll || params.quantize != prev->quantize ||
+       params.notesSize < prev->notesSize)
+   {
+      // rebuild
+      clipIndexSize_[clip] = 0;
+      for (i = 0; i < params.notesSize; i++)
+         clipIndexInsertNote(clip, i);
+   }
+   else
+   {
+      // notes which have been appended since the last update
+      for (i = prev->notesSize; i < params.notesSize; i++)
+         changed[i / 32] |= 1UL << (i % 32);
+
+      for (i = 0; i < params.notesSize; i++)
+      {
+         if (!changed[i / 32])
+            i |= 31; // skip to next word
+         else if (changed[i / 32] & (1UL << (i % 32)))
+            clipIndexUpdateNote(clip, i);
+      }
+   }
+
+   *prev = params;
+}
+// -------------------------------------------------------------------------------------------------
+
+
 /**
  * Request (or cancel) a synced mute/unmute toggle
  *
@@ -554,6 +771,11 @@ void loadSession(u16 sessionNumber)
       }
 
       status |= FILE_ReadClose(&file);
+
+      // clip notes have been replaced, rebuild the playback index
+      u8 track;
+      for (track = 0; track < TRACKS; track++)
+         clipIndexInvalidate(track);
    }
 
    if (status == 0)
@@ -767,16 +989,21 @@ s32 loopaSeqTick(u32 bpmTick)
       {
          s8 liveTransposeSemi = trackLiveTranspose_[track] ? liveTransposeSemitones_[liveTranspose_ + 7] : 0;
 
+         // only the notes due at this tick are taken from the playback index
+         clipIndexUpdate(track);
+
          if (!trackMute_[track])
          {
             u32 clipNoteTime = boundTickToClipSteps(bpmTick, track);
-            u16 i;
+            u16 idx;
 
-            for (i = 0; i < clipNotesSize_[track][activeScene_]; i++) // i: clip notes iterator
+            for (idx = clipIndexFind(track, clipNoteTime); idx < clipIndexSize_[track] && clipIndex_[track][idx].tick == clipNoteTime; idx++)
             {
+               u16 i = clipIndex_[track][idx].noteNumber; // i: clip notes iterator
+
                if (clipNotes_[track][activeScene_][i].length > 0) // not still being held/recorded!
                {
-                  if (quantizeTransform(track, i) == clipNoteTime)
+                  if (!probabilityDropsNote(track, i))
                   {
                      // If cursor erase is activated on the active track, set velocity of this note to zero, erase it, don't play it
                      if (cursorEraseActive_ && track == activeTrack_)
@@ -824,13 +1051,15 @@ s32 loopaSeqTick(u32 bpmTick)
             if (cursorEraseActive_)
             {
                u32 clipNoteTime = boundTickToClipSteps(bpmTick, track);
-               u16 i;
+               u16 idx;
 
-               for (i = 0; i < clipNotesSize_[track][activeScene_]; i++) // i: clip notes iterator
+               for (idx = clipIndexFind(track, clipNoteTime); idx < clipIndexSize_[track] && clipIndex_[track][idx].tick == clipNoteTime; idx++)
                {
+                  u16 i = clipIndex_[track][idx].noteNumber; // i: clip notes iterator
+
                   if (clipNotes_[track][activeScene_][i].length > 0) // not still being held/recorded!
                   {
-                     if (quantizeTransform(track, i) == clipNoteTime)
+                     if (!probabilityDropsNote(track, i))
                      {
                         clipNotes_[track][activeScene_][i].velocity = 0;
                      }
@@ -987,6 +1216,7 @@ s32 seqInit()
       trackMidiForward_[i] = 0;    // Disable note forwarding/live play on this track by default
       trackLiveTranspose_[i] = 1;  // Enable live transposition of notes on this track by default
       trackMuteToggleRequested_[i] = 0;
+      clipIndexInvalidate(i);
 
       for (j = 0; j < SCENES; j++)
       {
@@ -1092,6 +1322,8 @@ void loopaRecord(mios32_midi_port_t port, mios32_midi_package_t midi_package)
                // screenFormattedFlashMessage("Note %d on - ptr %d", midi_package.note, clipNoteNumber);
                if (!reusedDeletedNote)
                   clipNotesSize_[activeTrack_][activeScene_]++;
+               else
+                  clipIndexNoteChanged(activeTrack_, clipNoteNumber);
             }
             else if (midi_package.type == NoteOff || (midi_package.type == NoteOn && midi_package.velocity == 0))
             {
@@ -126,9 +126,21 @@ u32 boundTickToClipSteps(u32 tick, u8 clip);
 // Quantize a tick time event
 u32 quantize(u32 tick, u32 quantizeMeasure, s8 swingPercent, u32 clipLengthInTicks);
 
+// Clip fx probabilities/randomization: check if a note in a clip should be dropped
+u8 probabilityDropsNote(u8 clip, u16 noteNumber);
+
 // Transform (stretch, scroll, probabilities/random) and then quantize/apply swing a note in a clip
 s32 quantizeTransform(u8 clip, u16 noteNumber);
 
+// Transform (stretch, scroll) and then quantize/apply swing a note in a clip, without probabilities/random
+s32 quantizeTransformTick(u8 clip, u16 noteNumber);
+
+// Playback index: request a re-sort of a (recorded or edited) note of the active scene clip
+void clipIndexNoteChanged(u8 clip, u16 noteNumber);
+
+// Playback index: request a rebuild of the complete index of the active scene clip (e.g. after notes have been replaced)
+void clipIndexInvalidate(u8 clip);
+
 // Get the clip length in ticks
 u32 getClipLengthInTicks(u8 clip);
 
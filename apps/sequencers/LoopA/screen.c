@@ -1736,6 +1736,10 @@ void display()
 {
    u8 i, j;
 
+   // previous frame still sent via DMA: render the next frame once it has been transfered
+   if (APP_LCD_FlushBusy())
+      return;
+
    frameCounter_++;
 
    if (isScreensaverActive() && hw_enabled != HARDWARE_LOOPA_TESTMODE)
@@ -1947,17 +1951,10 @@ void display()
       screenshotRequested_ = 0;
    }
 
-   // Push screen buffer to screen
+   // Push screen buffer to the framebuffer of the display driver, only modified rows will be transfered
+   u8 row[APP_LCD_FRAMEBUFFER_ROW_SIZE];
    for (j = 0; j < 64; j++)
    {
-      APP_LCD_Cmd(0x15);
-      APP_LCD_Data(0+0x1c);
-
-      APP_LCD_Cmd(0x75);
-      APP_LCD_Data(j);
-
-      APP_LCD_Cmd(0x5c);
-
       u8 bgcol = 0;
       for (i = 0; i < 128; i++)
       {
@@ -1976,14 +1973,18 @@ void display()
          }
 
          if (flash && out == 0)
-            APP_LCD_Data(flash); // normally raise dark level slightly, but more intensively after 16 16th notes during flash
+            row[i] = flash; // normally raise dark level slightly, but more intensively after 16 16th notes during flash
          else
-            APP_LCD_Data(out);
+            row[i] = out;
 
          screen[j][i] = bgcol; // clear written pixels
       }
+
+      APP_LCD_FramebufferWrite(j, row);
    }
 
+   APP_LCD_Flush(0);
+
    if (flash)
       oledBeatFlashState_ = 0;
 }
@@ -925,6 +925,7 @@ void clipFreeze()
 
    optimizedAmount = clipNotesSize_[activeTrack_][activeScene_] - optimizedNotes;
    clipNotesSize_[activeTrack_][activeScene_] = optimizedNotes;
+   clipIndexInvalidate(activeTrack_);
 
    screenFormattedFlashMessage("%d notes optimized", optimizedAmount);
 }
@@ -1536,6 +1537,7 @@ void loopaButtonPressed(s32 pin)
                clipStretch_[activeTrack_][activeScene_] = copiedClipStretch_;
                memcpy(clipNotes_[activeTrack_][activeScene_], copiedClipNotes_, sizeof(copiedClipNotes_));
                clipNotesSize_[activeTrack_][activeScene_] = copiedClipNotesSize_;
+               clipIndexInvalidate(activeTrack_);
                screenFormattedFlashMessage("pasted clip from buffer");
             }
             else
@@ -2267,6 +2269,7 @@ void loopaEncoderTurned(s32 encoder, s32 incrementer)
                newTick = (newTick / TICKS_PER_STEP) * TICKS_PER_STEP;
 
                clipNotes_[activeTrack_][activeScene_][activeNote].tick = (u16) newTick;
+               clipIndexNoteChanged(activeTrack_, activeNote);
             }
          } else if (command_ == COMMAND_NOTE_KEY)
          {
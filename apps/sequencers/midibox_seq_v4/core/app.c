@@ -556,7 +556,9 @@ void SEQ_TASK_Period1mS_LowPrio(void)
   SEQ_UI_LCD_Handler();
 
   // update LEDs
+  u32 profile_begin = SEQ_STATISTICS_ProfileBegin();
   SEQ_UI_LED_Handler();
+  SEQ_STATISTICS_ProfileEnd(SEQ_STATISTICS_PROFILE_LED_HANDLER, profile_begin);
 
   // update TPD
   SEQ_TPD_Handler();
@@ -825,7 +827,9 @@ void SEQ_TASK_MIDI(void)
   SEQ_CORE_Handler();
 
   // send timestamped MIDI events
+  u32 profile_begin = SEQ_STATISTICS_ProfileBegin();
   SEQ_MIDI_OUT_Handler();
+  SEQ_STATISTICS_ProfileEnd(SEQ_STATISTICS_PROFILE_MIDI_OUT, profile_begin);
 
 #if !defined(MIOS32_DONT_USE_AOUT)
   // update CV and gates
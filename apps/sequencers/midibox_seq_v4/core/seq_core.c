@@ -71,6 +71,7 @@
 /////////////////////////////////////////////////////////////////////////////
 
 static s32 SEQ_CORE_ResetTrkPos(u8 track, seq_core_trk_t *t, seq_cc_trk_t *tcc);
+static u16 SEQ_CORE_OutputMutedTracksGet(void);
 static s32 SEQ_CORE_NextStep(seq_core_trk_t *t, seq_cc_trk_t *tcc, u8 no_progression, u8 reverse);
 
 
@@ -85,6 +86,8 @@ u8 seq_core_steps_per_pattern;
 u8 seq_core_pattern_switch_margin_ms;
 u8 seq_core_pattern_switch_measured_ms;
 
+u8 seq_core_lookahead_ticks;
+
 u16 seq_core_trk_muted;
 u16 seq_core_trk_synched_mute;
 u16 seq_core_trk_synched_unmute;
@@ -129,6 +132,15 @@ u8 seq_core_glb_loop_steps;
 static u32 bpm_tick_prefetch_req;
 static u32 bpm_tick_prefetched;
 
+// lookahead window (see SEQ_CORE_LookaheadCancel)
+static u16 lookahead_cancel_req;
+static u16 lookahead_trk_muted;
+
+// history of the generated steps (see SEQ_CORE_PlayedStepGet)
+static u32 step_history_timestamp[SEQ_CORE_NUM_TRACKS][SEQ_CORE_STEP_HISTORY_SIZE];
+static u8  step_history_step[SEQ_CORE_NUM_TRACKS][SEQ_CORE_STEP_HISTORY_SIZE];
+static u8  step_history_ix[SEQ_CORE_NUM_TRACKS];
+
 static float seq_core_bpm_target;
 static float seq_core_bpm_sweep_inc;
 
@@ -169,6 +181,10 @@ s32 SEQ_CORE_Init(u32 mode)
     seq_core_metronome_note_b = 0x25; // C#1
   }
 
+  if( mode == 0 ) {
+    seq_core_lookahead_ticks = SEQ_CORE_LOOKAHEAD_TICKS;
+  }
+
   if( mode == 0 ) {
     seq_core_shadow_out_port = DEFAULT;
     seq_core_shadow_out_chn = 0; // means: off
@@ -270,6 +286,9 @@ s32 SEQ_CORE_Init(u32 mode)
   SEQ_STATISTICS_StopwatchInit();
 #endif
 
+  // init profiling of the main handlers
+  SEQ_STATISTICS_ProfileInit();
+
   return 0; // no error
 }
 
@@ -497,11 +516,33 @@ s32 SEQ_CORE_Handler(void)
       // check all requests again after execution of this part
       again = 1;
 
+      // withdraw events which have been generated ahead of time, but which are not valid anymore
+      // this is the case if tracks have been muted meanwhile (mute, solo, port mute or slave clock mute),
+      // or if requested via SEQ_CORE_LookaheadCancel()
+      {
+	MIOS32_IRQ_Disable(); // must be atomic
+	u16 cancel_tracks = lookahead_cancel_req;
+	lookahead_cancel_req = 0;
+	MIOS32_IRQ_Enable();
+
+	if( seq_core_lookahead_ticks )
+	  cancel_tracks |= SEQ_CORE_OutputMutedTracksGet() & ~lookahead_trk_muted;
+
+	if( cancel_tracks && seq_core_lookahead_ticks && !seq_core_state.FIRST_CLK ) {
+	  u8 track;
+	  for(track=0; track<SEQ_CORE_NUM_TRACKS; ++track) {
+	    if( cancel_tracks & (1 << track) )
+	      SEQ_MIDI_OUT_Cancel(track, bpm_tick);
+	  }
+	}
+      }
+
       // it's possible to forward the sequencer on pattern changes
       // in this case bpm_tick_prefetch_req is > bpm_tick
-      // in all other cases, we only generate a single tick (realtime play)
-      u32 add_bpm_ticks = 0;
-      if( bpm_tick_prefetch_req > bpm_tick ) {
+      // in all other cases, we generate a single tick (realtime play),
+      // or seq_core_lookahead_ticks ahead of time if configured
+      u32 add_bpm_ticks = seq_core_lookahead_ticks;
+      if( bpm_tick_prefetch_req > (bpm_tick + add_bpm_ticks) ) {
 	add_bpm_ticks = bpm_tick_prefetch_req - bpm_tick;
       }
       // invalidate request before a new one will be generated (e.g. via SEQ_SONG_NextPos())
@@ -532,7 +573,9 @@ s32 SEQ_CORE_Handler(void)
 #endif
 
 	// generate MIDI events
+	u32 profile_begin = SEQ_STATISTICS_ProfileBegin();
 	SEQ_CORE_Tick(bpm_tick, -1, 0);
+	SEQ_STATISTICS_ProfileEnd(SEQ_STATISTICS_PROFILE_CORE_TICK, profile_begin);
 	SEQ_MIDPLY_Tick(bpm_tick);
 
 #if LED_PERFORMANCE_MEASURING == 1
@@ -575,6 +618,10 @@ s32 SEQ_CORE_Handler(void)
 	  }
 	}
       }
+
+      // mutes which have been changed while generating the ticks (synched mutes) are part of the generated window
+      if( seq_core_lookahead_ticks )
+	lookahead_trk_muted = SEQ_CORE_OutputMutedTracksGet();
     }
   } while( again && num_loops < 10 );
 
@@ -656,6 +703,16 @@ s32 SEQ_CORE_Reset(u32 bpm_start)
 
       t->bar = pos_bar;
     }
+
+    // clear step history
+    {
+      int i;
+      for(i=0; i<SEQ_CORE_STEP_HISTORY_SIZE; ++i) {
+	step_history_timestamp[track][i] = bpm_start;
+	step_history_step[track][i] = t->step;
+      }
+      step_history_ix[track] = 0;
+    }
   }
 
   // since timebase has been changed, ensure that Off-Events are played 
@@ -668,6 +725,8 @@ s32 SEQ_CORE_Reset(u32 bpm_start)
   // cancel prefetch requests/counter
   bpm_tick_prefetch_req = 0;
   bpm_tick_prefetched = bpm_start;
+  lookahead_cancel_req = 0;
+  lookahead_trk_muted = SEQ_CORE_OutputMutedTracksGet();
 
   // cancel stop and set step request
   seq_core_state.MANUAL_TRIGGER_STOP_REQ = 0;
@@ -1050,6 +1109,18 @@ s32 SEQ_CORE_Tick(u32 bpm_tick, s8 export_track, u8 mute_nonloopback_tracks)
 	      mute_this_step = 1; // mute initial step which is going to be recorded
 	  }
 
+	  // store step in history, so that the played step can be determined if it has been generated ahead of time
+	  {
+	    MIOS32_IRQ_Disable(); // must be atomic, read by SEQ_CORE_PlayedStepGet()
+	    u8 ix = step_history_ix[track] + 1;
+	    if( ix >= SEQ_CORE_STEP_HISTORY_SIZE )
+	      ix = 0;
+	    step_history_ix[track] = ix;
+	    step_history_timestamp[track][ix] = bpm_tick;
+	    step_history_step[track][ix] = t->step;
+	    MIOS32_IRQ_Enable();
+	  }
+
 	  // forward new step to recording function (only used in live recording mode)
 	  if( track_record_enabled )
 	    SEQ_RECORD_NewStep(track, prev_step, t->step, bpm_tick);
@@ -2410,6 +2481,113 @@ s32 SEQ_CORE_AddForwardDelay(u16 delay_ms)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// This function requests to withdraw the events of the given tracks which
+// have been generated ahead of time (seq_core_lookahead_ticks) but haven't
+// been played yet, e.g. because a pattern has been changed or a step has
+// been recorded. Mutes, solo, port and slave clock mutes are detected
+// automatically by SEQ_CORE_Handler().
+//
+// Only the MIDI events are removed, the tracks won't be rewinded: a step
+// which has been generated within the lookahead window won't be played.
+// Pending echo and roll events of the tracks are withdrawn as well, Off
+// events will be kept so that no note hangs.
+//
+// The request will be processed with the next tick by SEQ_CORE_Handler()
+/////////////////////////////////////////////////////////////////////////////
+s32 SEQ_CORE_LookaheadCancel(u16 tracks)
+{
+  MIOS32_IRQ_Disable(); // must be atomic
+  lookahead_cancel_req |= tracks;
+  MIOS32_IRQ_Enable();
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the step of a track which is played at the given bpm_tick.
+// With a lookahead window, t->step and t->timestamp_next_step_ref already
+// belong to a step which has been generated ahead of time, therefore the
+// played step is taken from the step history.
+//
+// *step_timestamp: the tick at which the played step has been started
+// *next_step_timestamp: the tick at which the next step will be played
+// (both optional, can be NULL)
+//
+// Returns the number of steps which have already been generated after the
+// played step (0 if no step has been generated ahead of time)
+/////////////////////////////////////////////////////////////////////////////
+s32 SEQ_CORE_PlayedStepGet(u8 track, u32 bpm_tick, u8 *step, u32 *step_timestamp, u32 *next_step_timestamp)
+{
+  if( track >= SEQ_CORE_NUM_TRACKS )
+    return -1; // invalid track
+
+  seq_core_trk_t *t = &seq_core_trk[track];
+  s32 num_ahead = 0;
+
+  MIOS32_IRQ_Disable(); // must be atomic, history is updated by SEQ_CORE_Tick()
+  u8 ix = step_history_ix[track];
+  u32 next_timestamp = t->timestamp_next_step_ref;
+
+  u8 played_step = t->step;
+
+  // without lookahead (or while the sequencer is stopped) the current step is played
+  // otherwise search backwards for the step which has been started at or before bpm_tick
+  // if the history doesn't go back far enough, the oldest step will be taken
+  if( seq_core_lookahead_ticks && SEQ_BPM_IsRunning() ) {
+    while( step_history_timestamp[track][ix] > bpm_tick && num_ahead < (SEQ_CORE_STEP_HISTORY_SIZE-1) ) {
+      next_timestamp = step_history_timestamp[track][ix];
+      ix = ix ? (ix-1) : (SEQ_CORE_STEP_HISTORY_SIZE-1);
+      ++num_ahead;
+    }
+    played_step = step_history_step[track][ix];
+  }
+
+  if( step )
+    *step = played_step;
+  if( step_timestamp )
+    *step_timestamp = step_history_timestamp[track][ix];
+  if( next_step_timestamp )
+    *next_step_timestamp = next_timestamp;
+  MIOS32_IRQ_Enable();
+
+  return num_ahead;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the tracks which are currently not sent to the output because of
+// the track mute, solo, port mute or slave clock mute function.
+// Used by SEQ_CORE_Handler() to detect state changes which invalidate the
+// events generated ahead of time. Step based mutes (e.g. record mode) are
+// part of the generated window and therefore not considered here.
+/////////////////////////////////////////////////////////////////////////////
+static u16 SEQ_CORE_OutputMutedTracksGet(void)
+{
+  if( seq_core_slaveclk_mute )
+    return 0xffff; // Slave Clock Mute Function
+
+  u16 muted = 0;
+  u8 track;
+  seq_cc_trk_t *tcc = &seq_cc_trk[0];
+  for(track=0; track<SEQ_CORE_NUM_TRACKS; ++track, ++tcc) {
+    u16 track_mask = 1 << track;
+    u8 track_soloed = seq_core_trk_soloed && (seq_core_trk_soloed & track_mask);
+
+    // same conditions as in SEQ_CORE_Tick()
+    if( (!seq_core_trk_soloed && seq_ui_button_state.SOLO && !SEQ_UI_IsSelectedTrack(track)) ||
+	(seq_core_trk_soloed && !track_soloed) ||
+	(!track_soloed && (seq_core_trk_muted & track_mask)) || // Track Mute function
+	SEQ_MIDI_PORT_OutMuteGet(tcc->midi_port) || // Port Mute Function
+	tcc->playmode == SEQ_CORE_TRKMODE_Off ) // track disabled
+      muted |= track_mask;
+  }
+
+  return muted;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // This function updates the BPM rate in a given sweep time
 /////////////////////////////////////////////////////////////////////////////
@@ -24,6 +24,26 @@
 
 #define SEQ_CORE_NUM_BPM_PRESETS       16
 
+// default number of ticks which are generated ahead of time (0 = disabled)
+// can be changed with the "set lookahead" terminal command, stored in MBSEQ_GC.V4
+// Note: generated events allocate SEQ_MIDI_OUT items until they are played,
+// which means that a large lookahead requires a large SEQ_MIDI_OUT_MAX_EVENTS
+#ifndef SEQ_CORE_LOOKAHEAD_TICKS
+#define SEQ_CORE_LOOKAHEAD_TICKS       0
+#endif
+
+// max. number of lookahead ticks (96 ticks = 1/16 note)
+#ifndef SEQ_CORE_LOOKAHEAD_TICKS_MAX
+#define SEQ_CORE_LOOKAHEAD_TICKS_MAX   96
+#endif
+
+// number of generated steps per track which are stored to determine the played step
+// (see SEQ_CORE_PlayedStepGet) - 4 entries cover a lookahead of 96 ticks with 1/32 steps,
+// with shorter steps the oldest stored step will be taken
+#ifndef SEQ_CORE_STEP_HISTORY_SIZE
+#define SEQ_CORE_STEP_HISTORY_SIZE     4
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Global Types
@@ -257,6 +277,8 @@ extern s32 SEQ_CORE_StepTriggerReq(u8 bus);
 extern s32 SEQ_CORE_NotifyIncomingMIDIEvent(u8 track, mios32_midi_package_t p);
 
 extern s32 SEQ_CORE_AddForwardDelay(u16 delay_ms);
+extern s32 SEQ_CORE_LookaheadCancel(u16 tracks);
+extern s32 SEQ_CORE_PlayedStepGet(u8 track, u32 bpm_tick, u8 *step, u32 *step_timestamp, u32 *next_step_timestamp);
 
 extern s32 SEQ_CORE_BPM_Update(float bpm, float sweep_ramp);
 extern s32 SEQ_CORE_BPM_SweepHandler(void);
@@ -277,6 +299,7 @@ extern u8 seq_core_steps_per_measure;
 extern u8 seq_core_steps_per_pattern;
 
 extern u8 seq_core_pattern_switch_margin_ms;
+extern u8 seq_core_lookahead_ticks;
 
 extern u16 seq_core_trk_muted;
 extern u16 seq_core_trk_synched_mute;
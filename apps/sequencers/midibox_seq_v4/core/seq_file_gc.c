@@ -371,6 +371,8 @@ s32 SEQ_FILE_GC_Read(void)
 	    seq_record_quantize = value; // only for legacy reasons - quantisation moved to local configuration file seq_file_c.c
 	  } else if( strcmp(parameter, "PasteClrAll") == 0 ) {
 	    seq_core_options.PASTE_CLR_ALL = value;
+	  } else if( strcmp(parameter, "LookaheadTicks") == 0 ) {
+	    seq_core_lookahead_ticks = (value > SEQ_CORE_LOOKAHEAD_TICKS_MAX) ? SEQ_CORE_LOOKAHEAD_TICKS_MAX : value;
 #ifndef MBSEQV4L
 	  } else if( strcmp(parameter, "DatawheelMode") == 0 ) {
 	    seq_ui_edit_datawheel_mode = value;
@@ -710,6 +712,9 @@ static s32 SEQ_FILE_GC_Write_Hlp(u8 write_to_file)
   sprintf(line_buffer, "PasteClrAll %d\n", seq_core_options.PASTE_CLR_ALL);
   FLUSH_BUFFER;
 
+  sprintf(line_buffer, "LookaheadTicks %d\n", seq_core_lookahead_ticks);
+  FLUSH_BUFFER;
+
 #ifndef MBSEQV4L
   sprintf(line_buffer, "DatawheelMode %d\n", seq_ui_edit_datawheel_mode);
   FLUSH_BUFFER;
@@ -45,6 +45,7 @@
 #include "seq_par.h"
 #include "seq_layer.h"
 #include "seq_scale.h"
+#include "seq_statistics.h"
 
 /////////////////////////////////////////////////////////////////////////////
 // Global variables
@@ -252,6 +253,9 @@ s32 SEQ_LCD_Update(u8 force)
 
   MUTEX_LCD_TAKE;
 
+  // measured after the mutex has been taken, so that waiting time isn't considered
+  u32 profile_begin = SEQ_STATISTICS_ProfileBegin();
+
   u8 *ptr = (u8 *)lcd_buffer;
   for(y=0; y<LCD_MAX_LINES; ++y)
     for(x=0; x<LCD_MAX_COLUMNS; ++x) {
@@ -293,6 +297,8 @@ s32 SEQ_LCD_Update(u8 force)
 					     remote_last_x[y]-remote_first_x[y]+1);
   }
 
+  SEQ_STATISTICS_ProfileEnd(SEQ_STATISTICS_PROFILE_LCD_UPDATE, profile_begin);
+
   return 0; // no error
 }
 
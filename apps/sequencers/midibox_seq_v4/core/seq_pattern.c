@@ -128,6 +128,10 @@ s32 SEQ_PATTERN_Change(u8 group, seq_pattern_t pattern, u8 force_immediate_chang
 #if LED_PERFORMANCE_MEASURING
     MIOS32_BOARD_LED_Set(0x00000001, 0);
 #endif
+
+    // events of the previous pattern which have been generated ahead of time are not valid anymore
+    if( SEQ_BPM_IsRunning() )
+      SEQ_CORE_LookaheadCancel(0xf << (4*group));
   } else {
 
     // TODO: stall here if previous pattern change hasn't been finished yet!
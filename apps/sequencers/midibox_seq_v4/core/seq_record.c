@@ -410,12 +410,22 @@ s32 SEQ_RECORD_Receive(mios32_midi_package_t midi_package, u8 track)
 	  // insert length into current step
 	  u8 instrument = 0;
 	  int len;
+	  int len_step = ui_selected_step;
 	  if( step_record_mode ) {
 	    len = 71; // 75%
 	    if( tcc->event_mode != SEQ_EVENT_MODE_Drum )
 	      len = (duration <= 96) ? duration : 96; // for duration >= 96 the length will be stretched after record
 	  } else {
-	    len = SEQ_BPM_TickGet() - t->rec_timestamp;
+	    // with a lookahead window t->step and t->rec_timestamp could already belong
+	    // to a step which hasn't been played yet: take the played step instead
+	    u32 bpm_tick = SEQ_BPM_TickGet();
+	    u8 played_step;
+	    u32 played_step_timestamp;
+	    SEQ_CORE_PlayedStepGet(track, bpm_tick, &played_step, &played_step_timestamp, NULL);
+	    len_step = played_step;
+
+	    u32 rec_timestamp = (t->rec_timestamp > bpm_tick) ? played_step_timestamp : t->rec_timestamp;
+	    len = bpm_tick - rec_timestamp;
 
 	    if( len < 1 )
 	      len = 1;
@@ -423,7 +433,6 @@ s32 SEQ_RECORD_Receive(mios32_midi_package_t midi_package, u8 track)
 	      len = 95;
 	  }
 
-	  int len_step = step_record_mode ? ui_selected_step : t->step;
 	  u8 num_p_layers = SEQ_PAR_NumLayersGet(track);
 
 	  while( 1 ) {
@@ -564,18 +573,22 @@ s32 SEQ_RECORD_Receive(mios32_midi_package_t midi_package, u8 track)
 
     if( !step_record_mode ) {
       u8 prev_step = ui_selected_step;
-      u8 new_step = t->step;
+
+      // with a lookahead window t->step could already have been generated ahead of time: take the played step
+      u32 timestamp = SEQ_BPM_TickGet();
+      u8 new_step;
+      u32 timestamp_next_step_ref;
+      s32 num_steps_ahead = SEQ_CORE_PlayedStepGet(track, timestamp, &new_step, NULL, &timestamp_next_step_ref);
 
       ui_selected_step = new_step;
 
       // take next step if it will be reached "soon" (>80% of current step)
       if( SEQ_BPM_IsRunning() ) {
-	u32 timestamp = SEQ_BPM_TickGet();
 	u8 shift_event = 0;
-	if( t->timestamp_next_step_ref <= timestamp )
+	if( timestamp_next_step_ref <= timestamp )
 	  shift_event = 1;
 	else {
-	  s32 diff = (s32)t->timestamp_next_step_ref - (s32)timestamp;
+	  s32 diff = (s32)timestamp_next_step_ref - (s32)timestamp;
 	  u32 tolerance = (t->step_length * seq_record_quantize) / 100; // usually 20% of 96 ticks -> 19 ticks
 	  // TODO: we could vary the tolerance depending on the BPM rate: than slower the clock, than lower the tolerance
 	  // as a simple replacement for constant time measuring
@@ -591,7 +604,14 @@ s32 SEQ_RECORD_Receive(mios32_midi_package_t midi_package, u8 track)
 	  MIOS32_MIDI_SendDebugMessage("Shifted step %d -> %d\n", ui_selected_step, next_step);
 #endif
 	  ui_selected_step = next_step;
-	  t->state.REC_DONT_OVERWRITE_NEXT_STEP = 1; // next step won't be overwritten
+
+	  if( num_steps_ahead <= 0 ) {
+	    t->state.REC_DONT_OVERWRITE_NEXT_STEP = 1; // next step won't be overwritten
+	  } else {
+	    // the next step has already been generated ahead of time, the flag would affect a later step
+	    // instead its events are withdrawn, so that the recorded note won't be played twice
+	    SEQ_CORE_LookaheadCancel(1 << track);
+	  }
 	}
       }
 
@@ -886,7 +906,8 @@ s32 SEQ_RECORD_CtrlCC(u8 track, u8 cc_internal, u8 value)
       }
 
       if( !step_record_mode ) {
-	u8 new_step = t->step;
+	u8 new_step;
+	SEQ_CORE_PlayedStepGet(track, SEQ_BPM_TickGet(), &new_step, NULL, NULL);
 	ui_selected_step = new_step;
       }
 
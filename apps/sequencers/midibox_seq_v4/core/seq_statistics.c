@@ -21,6 +21,20 @@
 #include "tasks.h"
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Local definitions
+/////////////////////////////////////////////////////////////////////////////
+
+// DWT cycle counter of the Cortex-M3/M4 core
+// it's free running, therefore (in difference to MIOS32_STOPWATCH) it can
+// be used by multiple tasks at the same time
+#define DWT_DEMCR        (*(volatile u32 *)0xe000edfc)
+#define DWT_DEMCR_TRCENA (1 << 24)
+#define DWT_CTRL         (*(volatile u32 *)0xe0001000)
+#define DWT_CTRL_CYCCNTENA (1 << 0)
+#define DWT_CYCCNT       (*(volatile u32 *)0xe0001004)
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Local variables
 /////////////////////////////////////////////////////////////////////////////
@@ -30,6 +44,19 @@ static s32 cpu_load_in_percent;
 static u32 stopwatch_value;
 static u32 stopwatch_value_max;
 
+static seq_statistics_profile_t profile[SEQ_STATISTICS_PROFILE_NUM];
+
+static const char profile_name[SEQ_STATISTICS_PROFILE_NUM][20] = {
+  "SEQ_CORE_Tick",
+  "SEQ_MIDI_OUT_Handler",
+  "SEQ_LCD_Update",
+  "SEQ_UI_LED_Handler",
+};
+
+static const u16 profile_histogram_limit[SEQ_STATISTICS_PROFILE_HISTOGRAM_SIZE] = {
+  50, 100, 200, 500, 1000, 0xffff
+};
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Initialisation
@@ -147,3 +174,135 @@ extern u32 SEQ_STATISTICS_StopwatchGetValueMax(void)
   return stopwatch_value_max;
 }
 
+
+/////////////////////////////////////////////////////////////////////////////
+// Profiling of the main handlers
+// Usage:
+//   u32 begin = SEQ_STATISTICS_ProfileBegin();
+//   SEQ_CORE_Tick(...);
+//   SEQ_STATISTICS_ProfileEnd(SEQ_STATISTICS_PROFILE_CORE_TICK, begin);
+// Note: handlers which are executed by a low priority task can be interrupted
+// by higher priority tasks; the interruption is part of the measured time!
+/////////////////////////////////////////////////////////////////////////////
+s32 SEQ_STATISTICS_ProfileInit(void)
+{
+#if SEQ_STATISTICS_PROFILING
+  // enable the cycle counter
+  DWT_DEMCR |= DWT_DEMCR_TRCENA;
+  DWT_CYCCNT = 0;
+  DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+#endif
+
+  return SEQ_STATISTICS_ProfileReset();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Resets all profiling results
+/////////////////////////////////////////////////////////////////////////////
+s32 SEQ_STATISTICS_ProfileReset(void)
+{
+  int id;
+
+  portENTER_CRITICAL();
+  for(id=0; id<SEQ_STATISTICS_PROFILE_NUM; ++id) {
+    seq_statistics_profile_t *p = &profile[id];
+    int i;
+
+    p->calls = 0;
+    p->min_us = 0xffffffff;
+    p->max_us = 0;
+    p->sum_us = 0;
+    for(i=0; i<SEQ_STATISTICS_PROFILE_HISTOGRAM_SIZE; ++i)
+      p->histogram[i] = 0;
+  }
+  portEXIT_CRITICAL();
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the current cycle counter, has to be passed to
+// SEQ_STATISTICS_ProfileEnd() after the measured function
+/////////////////////////////////////////////////////////////////////////////
+u32 SEQ_STATISTICS_ProfileBegin(void)
+{
+#if SEQ_STATISTICS_PROFILING
+  return DWT_CYCCNT;
+#else
+  return 0;
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Adds the time since SEQ_STATISTICS_ProfileBegin() to the results
+/////////////////////////////////////////////////////////////////////////////
+s32 SEQ_STATISTICS_ProfileEnd(seq_statistics_profile_id_t id, u32 begin)
+{
+#if SEQ_STATISTICS_PROFILING
+  if( id >= SEQ_STATISTICS_PROFILE_NUM )
+    return -1; // invalid id
+
+  // note: the difference is also valid on counter overruns
+  u32 us = (DWT_CYCCNT - begin) / (MIOS32_SYS_CPU_FREQUENCY / 1000000);
+
+  int range;
+  for(range=0; range<(SEQ_STATISTICS_PROFILE_HISTOGRAM_SIZE-1); ++range)
+    if( us < profile_histogram_limit[range] )
+      break;
+
+  seq_statistics_profile_t *p = &profile[id];
+  portENTER_CRITICAL();
+  // restart the average calculation before the sum overruns
+  if( p->sum_us >= 0x80000000 ) {
+    p->sum_us /= 2;
+    p->calls /= 2;
+  }
+  ++p->calls;
+  p->sum_us += us;
+  if( us < p->min_us )
+    p->min_us = us;
+  if( us > p->max_us )
+    p->max_us = us;
+  ++p->histogram[range];
+  portEXIT_CRITICAL();
+#endif
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns a copy of the profiling results
+/////////////////////////////////////////////////////////////////////////////
+s32 SEQ_STATISTICS_ProfileGet(seq_statistics_profile_id_t id, seq_statistics_profile_t *result)
+{
+  if( id >= SEQ_STATISTICS_PROFILE_NUM )
+    return -1; // invalid id
+
+  portENTER_CRITICAL();
+  *result = profile[id];
+  portEXIT_CRITICAL();
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the name of the profiled function
+/////////////////////////////////////////////////////////////////////////////
+const char *SEQ_STATISTICS_ProfileNameGet(seq_statistics_profile_id_t id)
+{
+  return (id < SEQ_STATISTICS_PROFILE_NUM) ? profile_name[id] : "invalid";
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the upper limit of a histogram range in uS (0xffff for the last range)
+/////////////////////////////////////////////////////////////////////////////
+u32 SEQ_STATISTICS_ProfileHistogramLimitGet(u8 range)
+{
+  return (range < SEQ_STATISTICS_PROFILE_HISTOGRAM_SIZE) ? profile_histogram_limit[range] : 0xffff;
+}
@@ -19,11 +19,40 @@
 // Global definitions
 /////////////////////////////////////////////////////////////////////////////
 
+// measures the execution time of the main handlers with the DWT cycle counter
+// of the Cortex-M core (results: see "profile" command of the MIOS Terminal)
+#ifndef SEQ_STATISTICS_PROFILING
+#if defined(MIOS32_FAMILY_EMULATION)
+#define SEQ_STATISTICS_PROFILING 0
+#else
+#define SEQ_STATISTICS_PROFILING 1
+#endif
+#endif
+
+// histogram ranges in uS: <50, <100, <200, <500, <1000, >=1000
+#define SEQ_STATISTICS_PROFILE_HISTOGRAM_SIZE 6
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Global Types
 /////////////////////////////////////////////////////////////////////////////
 
+typedef enum {
+  SEQ_STATISTICS_PROFILE_CORE_TICK,
+  SEQ_STATISTICS_PROFILE_MIDI_OUT,
+  SEQ_STATISTICS_PROFILE_LCD_UPDATE,
+  SEQ_STATISTICS_PROFILE_LED_HANDLER,
+  SEQ_STATISTICS_PROFILE_NUM
+} seq_statistics_profile_id_t;
+
+typedef struct {
+  u32 calls;
+  u32 min_us;
+  u32 max_us;
+  u32 sum_us; // sum of all measured values, divide by calls for the average
+  u32 histogram[SEQ_STATISTICS_PROFILE_HISTOGRAM_SIZE];
+} seq_statistics_profile_t;
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Prototypes
@@ -41,6 +70,14 @@ extern s32 SEQ_STATISTICS_StopwatchCapture(void);
 extern u32 SEQ_STATISTICS_StopwatchGetValue(void);
 extern u32 SEQ_STATISTICS_StopwatchGetValueMax(void);
 
+extern s32 SEQ_STATISTICS_ProfileInit(void);
+extern s32 SEQ_STATISTICS_ProfileReset(void);
+extern u32 SEQ_STATISTICS_ProfileBegin(void);
+extern s32 SEQ_STATISTICS_ProfileEnd(seq_statistics_profile_id_t id, u32 begin);
+extern s32 SEQ_STATISTICS_ProfileGet(seq_statistics_profile_id_t id, seq_statistics_profile_t *profile);
+extern const char *SEQ_STATISTICS_ProfileNameGet(seq_statistics_profile_id_t id);
+extern u32 SEQ_STATISTICS_ProfileHistogramLimitGet(u8 range);
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Export global variables
@@ -326,6 +326,14 @@ s32 SEQ_TERMINAL_ParseLine(char *input, void *_output_function)
       SEQ_TERMINAL_PrintHelp(out);
     } else if( strcmp(parameter, "system") == 0 ) {
       SEQ_TERMINAL_PrintSystem(out);
+    } else if( strcmp(parameter, "profile") == 0 ) {
+      char *arg;
+      if( (arg = strtok_r(NULL, separators, &brkt)) && strcmp(arg, "reset") == 0 ) {
+	SEQ_STATISTICS_ProfileReset();
+	out("Profiling results have been reset.");
+      } else {
+	SEQ_TERMINAL_PrintProfile(out);
+      }
     } else if( strcmp(parameter, "memory") == 0 ) {
       // new: expert option (therefore not documented in help page):
       // "memory <from-address> <to-address> dumps any memory region (not protected against bus errors - potential hard fault!)
@@ -667,6 +675,20 @@ s32 SEQ_TERMINAL_ParseLine(char *input, void *_output_function)
 	      out("Enter 'store' to save this setting on SD Card.");
 	    }
 	  }
+	} else if( strcmp(parameter, "lookahead") == 0 ) {
+	  char *arg;
+	  int value;
+	  if( !(arg = strtok_r(NULL, separators, &brkt)) ) {
+	    out("Please specify number of lookahead ticks between 0..%d (default: %d, current: %d)\n", SEQ_CORE_LOOKAHEAD_TICKS_MAX, SEQ_CORE_LOOKAHEAD_TICKS, seq_core_lookahead_ticks);
+	  } else {
+	    if( (value=get_dec(arg)) < 0 || value > SEQ_CORE_LOOKAHEAD_TICKS_MAX ) {
+	      out("Lookahead should be between 0..%d ticks!", SEQ_CORE_LOOKAHEAD_TICKS_MAX);
+	    } else {
+	      seq_core_lookahead_ticks = value;
+	      out("Lookahead set to %d ticks\n", seq_core_lookahead_ticks);
+	      out("Enter 'store' to save this setting on SD Card.");
+	    }
+	  }
 	} else if( strcmp(parameter, "seq_pattern_log_load_time") == 0 ) {
           int on_off = -1;
           if( (parameter = strtok_r(NULL, separators, &brkt)) )
@@ -907,6 +929,7 @@ s32 SEQ_TERMINAL_PrintHelp(void *_output_function)
   out("Welcome to " MIOS32_LCD_BOOT_MSG_LINE1 "!");
   out("Following commands are available:");
   out("  system:         print system info");
+  out("  profile:        print execution times of the main handlers (profile reset: clear results)");
   out("  memory:         print memory allocation info");
   out("  sdcard:         print SD Card info");
   out("  sdcard_format:  formats the SD Card (you will be asked for confirmation)");
@@ -929,6 +952,7 @@ s32 SEQ_TERMINAL_PrintHelp(void *_output_function)
   out("  set din_testmode <on|off>: change DIN (button/encoder) testmode (current: %s)", app_din_testmode ? "on" : "off");
   out("  set blm_port <off|in-port>: change BLM input port (same port is used for output)");
   out("  set rec_quantisation <1..100>: change record quantisation (default: 10%%, current: %d%%)\n", seq_record_quantize);
+  out("  set lookahead <0..%d>: number of ticks which are generated ahead of time (current: %d)\n", SEQ_CORE_LOOKAHEAD_TICKS_MAX, seq_core_lookahead_ticks);
   out("  set seq_pattern_log_load_time <on|off>: log pattern load time (current: %s)", seq_pattern_log_load_time ? "on" : "off");
 
   MUTEX_MIDIOUT_TAKE;
@@ -1036,6 +1060,13 @@ s32 SEQ_TERMINAL_PrintSystem(void *_output_function)
   out("CPU Load: %d%%\n", SEQ_STATISTICS_CurrentCPULoad());
   out("MIDI Scheduler: Alloc %3d/%3d Drops: %3d",
 	    seq_midi_out_allocated, seq_midi_out_max_allocated, seq_midi_out_dropouts);
+#if SEQ_MIDI_OUT_SCHEDULER_ANALYSIS
+  out("MIDI Scheduler: Insert %d avg/%d max steps, Dispatch %d avg/%d max steps",
+      seq_midi_out_sched_inserts ? (seq_midi_out_sched_insert_steps / seq_midi_out_sched_inserts) : 0,
+      seq_midi_out_sched_insert_steps_max,
+      seq_midi_out_sched_dispatches ? (seq_midi_out_sched_dispatch_steps / seq_midi_out_sched_dispatches) : 0,
+      seq_midi_out_sched_dispatch_steps_max);
+#endif
 
   u32 stopwatch_value_max = SEQ_STATISTICS_StopwatchGetValueMax();
   u32 stopwatch_value = SEQ_STATISTICS_StopwatchGetValue();
@@ -1067,6 +1098,58 @@ s32 SEQ_TERMINAL_PrintSystem(void *_output_function)
 }
 
 
+s32 SEQ_TERMINAL_PrintProfile(void *_output_function)
+{
+  void (*out)(char *format, ...) = _output_function;
+  char str_buffer[128];
+
+  out("Profiling Results:");
+  out("==================");
+#if !SEQ_STATISTICS_PROFILING
+  out("Profiling not enabled in this build (SEQ_STATISTICS_PROFILING)");
+#else
+  {
+    int i;
+
+    sprintf(str_buffer, "Function             |  Calls   |  Min uS |  Avg uS |  Max uS |");
+    for(i=0; i<SEQ_STATISTICS_PROFILE_HISTOGRAM_SIZE; ++i) {
+      if( i < (SEQ_STATISTICS_PROFILE_HISTOGRAM_SIZE-1) )
+	sprintf((char *)(str_buffer + strlen(str_buffer)), "  <%-5d|", (int)SEQ_STATISTICS_ProfileHistogramLimitGet(i));
+      else
+	sprintf((char *)(str_buffer + strlen(str_buffer)), " >=%-5d|", (int)SEQ_STATISTICS_ProfileHistogramLimitGet(i-1));
+    }
+    out(str_buffer);
+
+    int id;
+    for(id=0; id<SEQ_STATISTICS_PROFILE_NUM; ++id) {
+      seq_statistics_profile_t profile;
+      SEQ_STATISTICS_ProfileGet(id, &profile);
+
+      if( !profile.calls ) {
+	sprintf(str_buffer, "%-20s | no calls yet", SEQ_STATISTICS_ProfileNameGet(id));
+      } else {
+	sprintf(str_buffer, "%-20s | %8u | %7u | %7u | %7u |",
+		SEQ_STATISTICS_ProfileNameGet(id),
+		(unsigned)profile.calls,
+		(unsigned)profile.min_us,
+		(unsigned)(profile.sum_us / profile.calls),
+		(unsigned)profile.max_us);
+	for(i=0; i<SEQ_STATISTICS_PROFILE_HISTOGRAM_SIZE; ++i)
+	  sprintf((char *)(str_buffer + strlen(str_buffer)), " %7u|", (unsigned)profile.histogram[i]);
+      }
+      out(str_buffer);
+    }
+
+    out("Note: handlers of low priority tasks (LCD/LED) include the time of interruptions by higher priority tasks");
+  }
+#endif
+
+  out("done.");
+
+  return 0; // no error
+}
+
+
 s32 SEQ_TERMINAL_PrintGlobalConfig(void *_output_function)
 {
   void (*out)(char *format, ...) = _output_function;
@@ -35,6 +35,7 @@ extern s32 SEQ_TERMINAL_ParseLine(char *input, void *_output_function);
 
 extern s32 SEQ_TERMINAL_PrintHelp(void *_output_function);
 extern s32 SEQ_TERMINAL_PrintSystem(void *_output_function);
+extern s32 SEQ_TERMINAL_PrintProfile(void *_output_function);
 extern s32 SEQ_TERMINAL_PrintGlobalConfig(void *_output_function);
 extern s32 SEQ_TERMINAL_PrintBookmarks(void *_output_function);
 extern s32 SEQ_TERMINAL_PrintSessionConfig(void *_output_function);
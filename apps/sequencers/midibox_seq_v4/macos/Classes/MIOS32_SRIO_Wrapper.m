@@ -33,6 +33,7 @@ volatile u8 mios32_srio_din_buffer[MIOS32_SRIO_NUM_SR];
 
 // change notification flags
 volatile u8 mios32_srio_din_changed[MIOS32_SRIO_NUM_SR];
+volatile u32 mios32_srio_din_changed_sr[MIOS32_SRIO_NUM_SR_WORDS];
 
 //////////////////////////////////////////////////////////////////////////////
 // local variables to bridge objects to C functions
@@ -73,6 +74,8 @@ s32 MIOS32_SRIO_Init(u32 mode)
 		mios32_srio_din_buffer[i] = 0xff; // passive state (Buttons depressed)
 		mios32_srio_din_changed[i] = 0;   // no change
 	}
+	for(i=0; i<MIOS32_SRIO_NUM_SR_WORDS; ++i)
+		mios32_srio_din_changed_sr[i] = 0;
 
 	return 0;
 }
@@ -95,7 +98,11 @@ s32 MIOS32_SRIO_ScanStart(void *_notify_hook)
 	// copy/or buffered DIN values/changed flags
 	int i;
 	for(i=0; i<MIOS32_SRIO_NUM_SR; ++i) {
-		mios32_srio_din_changed[i] |= mios32_srio_din[i] ^ mios32_srio_din_buffer[i];
+		u8 change_mask = mios32_srio_din[i] ^ mios32_srio_din_buffer[i];
+		if( change_mask ) {
+			mios32_srio_din_changed[i] |= change_mask;
+			mios32_srio_din_changed_sr[i >> 5] |= (1 << (i & 31));
+		}
 		mios32_srio_din[i] = mios32_srio_din_buffer[i];
 	}
 
@@ -81,6 +81,14 @@ extern void APP_SendDebugMessage(char *format, ...);
 # define MIOS32_HEAP_SIZE 13*1024
 #endif
 
+// event index of the MIDI file player (see $MIOS32_PATH/modules/midifile/mid_parser.h)
+// small and medium sized .mid files are played from RAM, bigger files are still read from SD Card
+#if defined(MIOS32_FAMILY_STM32F4xx)
+# define MID_PARSER_EVENT_BUFFER_SIZE 16*1024
+#endif
+// SEQ_MIDPLY_PlayEvent() schedules SysEx packages like any other event
+#define MID_PARSER_SYSEX_PACKAGES 1
+
 // for LPC17: simplify allocation of large arrays
 #if defined(MIOS32_FAMILY_LPC17xx)
 # define AHB_SECTION __attribute__ ((section (".bss_ahb")))
@@ -37,6 +37,11 @@
 // selected Model (could be variable later)
 #define RESID_MODEL MOS8580
 
+// 1: all SIDs are rendered in blocks between two MBSID updates
+// 0: sample by sample (previous implementation)
+// see also ../benchmark for a performance comparison
+#define RESID_BLOCK_RENDERING 1
+
 // play testtone at startup?
 // nice for first checks of the emulation w/o MIDI input
 #define RESID_PLAY_TESTTONE 0
@@ -359,6 +364,39 @@ void MidiboxSidAudioProcessor::processBlock (AudioSampleBuffer& buffer, MidiBuff
         int numSamples = buffer.getNumSamples();
     
         // add SID sound(s) to output(s)
+#if RESID_BLOCK_RENDERING
+        // all samples between two MBSID updates are rendered in one block, so that all SIDs are still in lock-step
+        int numSidChannels = (numChannels < SID_NUM) ? numChannels : SID_NUM;
+        int blockBegin = 0;
+        for(int i=0; i<=numSamples; ++i) {
+            bool update = false;
+            if( i < numSamples ) {
+                mbSidUpdateCounter += (double)MBSID_UPDATE_FRQ / reSidSampleRate;
+                if( mbSidUpdateCounter >= 1.0 ) {
+                    mbSidUpdateCounter -= 1.0;
+                    update = true;
+                }
+            }
+
+            // render pending samples before the update, at the end of the buffer, or if the block is full
+            int blockSize = i - blockBegin;
+            if( blockSize > 0 && (update || i == numSamples || blockSize >= SID_BLOCK_RENDERER_MAX_SAMPLES) ) {
+                for(int channel = 0; channel < numSidChannels; ++channel) {
+                    SidBlockRenderer::renderBlock(reSID[channel], reSidBlockBuffer, blockSize);
+                    SidBlockRenderer::convertBlock(buffer.getSampleData(channel, blockBegin), reSidBlockBuffer, blockSize);
+                }
+                blockBegin = i;
+            }
+
+#if RESID_PLAY_TESTTONE == 0
+            // update sound engine
+            if( update ) {
+                mbSidEnvironment.tick();
+                RESID_Update(0);
+            }
+#endif
+        }
+#else
         // TK: this nested loop isn't optimal for CPU load, but we have to ensure that all SIDs are in lock-step
         for(int i=0; i<numSamples; ++i) {
             // update sound engine
@@ -383,6 +421,7 @@ void MidiboxSidAudioProcessor::processBlock (AudioSampleBuffer& buffer, MidiBuff
                 *buffer.getSampleData(channel, i) = currentSample;
             }
         }
+#endif
     }
 #endif
 
@@ -15,6 +15,7 @@
 #include <JuceHeader.h>
 
 #include "../resid/resid.h"
+#include "SidBlockRenderer.h"
 #include "MbSidEnvironment.h"
 #include "MidiProcessing.h"
 
@@ -114,6 +115,9 @@ public:
     MbSidEnvironment mbSidEnvironment;
 #endif
   
+    // temporary buffer for block rendering
+    short reSidBlockBuffer[SID_BLOCK_RENDERER_MAX_SAMPLES];
+  
     int reSidEnabled;
     double reSidSampleRate;
     double reSidDeltaCycleCounter;
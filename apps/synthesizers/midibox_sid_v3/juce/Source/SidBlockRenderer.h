@@ -0,0 +1,82 @@
+/* -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*- */
+// $Id$
+/*
+ * Block based rendering of reSID instances
+ *
+ * The per-sample path clocks each reSID instance with delta_t=1 until a
+ * sample is available, which means one SID::clock() call per SID cycle.
+ * SidBlockRenderer::renderBlock() lets reSID generate all samples of a
+ * block in a single call instead. The resulting samples are identical,
+ * since reSID advances the same cycles and interpolates the same way.
+ *
+ * Used by PluginProcessor.cpp (RESID_BLOCK_RENDERING) and the offline
+ * render benchmark in ../benchmark
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2010 Thorsten Klose (tk@midibox.org)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+#ifndef _SID_BLOCK_RENDERER_H
+#define _SID_BLOCK_RENDERER_H
+
+#include "../resid/resid.h"
+
+
+// max. number of samples which are rendered in one block
+#define SID_BLOCK_RENDERER_MAX_SAMPLES 256
+
+
+class SidBlockRenderer
+{
+public:
+    //==========================================================================
+    // renders a single sample (reference implementation, 1 cycle per call)
+    static inline short renderSample(SID *sid)
+    {
+        short sample;
+        cycle_count delta_t = 1;
+        while( !sid->clock(delta_t, &sample, 1) )
+            if( !delta_t ) // delta_t can be changed by clock()
+                delta_t = 1;
+        return sample;
+    }
+
+    //==========================================================================
+    // renders numSamples samples into dst
+    static inline void renderBlock(SID *sid, short *dst, int numSamples)
+    {
+        int rendered = 0;
+        while( rendered < numSamples ) {
+            // more cycles than needed: clock() returns as soon as the requested
+            // number of samples is available, the remaining cycles are not executed
+            cycle_count delta_t = 1 << 20;
+            rendered += sid->clock(delta_t, &dst[rendered], numSamples - rendered);
+        }
+    }
+
+    //==========================================================================
+    // converts rendered samples into float values (-1.0..1.0)
+    // simple loop without dependencies, so that the compiler can vectorize it
+    static inline void convertBlock(float *dst, const short *src, int numSamples, float gain = 1.0f)
+    {
+        const float scale = gain / 32768.0f;
+        for(int i=0; i<numSamples; ++i)
+            dst[i] = (float)src[i] * scale;
+    }
+
+    //==========================================================================
+    // adds rendered samples to a float buffer (e.g. to mix multiple SIDs into one channel)
+    static inline void mixBlock(float *dst, const short *src, int numSamples, float gain = 1.0f)
+    {
+        const float scale = gain / 32768.0f;
+        for(int i=0; i<numSamples; ++i)
+            dst[i] += (float)src[i] * scale;
+    }
+};
+
+#endif /* _SID_BLOCK_RENDERER_H */
@@ -0,0 +1,230 @@
+/* -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*- */
+// $Id$
+/*
+ * Offline render benchmark for the reSID emulation of the MIDIbox SID plugin
+ *
+ * Renders a test sequence with 1..8 SIDs sample by sample (previous plugin
+ * implementation) and in blocks (SidBlockRenderer, RESID_BLOCK_RENDERING),
+ * and reports the real-time factor of both methods.
+ *
+ * ==========================================================================
+ *
+ *  Copyright (C) 2010 Thorsten Klose (tk@midibox.org)
+ *  Licensed for personal non-commercial use only.
+ *  All other rights reserved.
+ *
+ * ==========================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../Source/SidBlockRenderer.h"
+
+
+// same settings like in PluginProcessor.cpp
+#define MBSID_UPDATE_FRQ 1000
+#define RESID_SAMPLING_METHOD SAMPLE_INTERPOLATE
+#define RESID_FREQUENCY 1000000
+#define RESID_MODEL MOS8580
+
+#define MAX_SIDS 8
+
+
+//==============================================================================
+// simple pseudo random generator, so that both methods get the same register writes
+static unsigned randomState;
+
+static unsigned randomGet(void)
+{
+    randomState = randomState * 1103515245 + 12345;
+    return (randomState >> 16) & 0x7fff;
+}
+
+
+//==============================================================================
+// initial patch: three voices with different waveforms, filter enabled
+static void sidInit(SID *sid, double sampleRate)
+{
+    sid->set_chip_model(RESID_MODEL);
+    sid->reset();
+    if( !sid->set_sampling_parameters(RESID_FREQUENCY, RESID_SAMPLING_METHOD, sampleRate) ) {
+        fprintf(stderr, "Initialisation of reSID failed at sample rate %7.2f Hz!\n", sampleRate);
+        exit(1);
+    }
+
+    static const unsigned char waveform[3] = { 0x41, 0x21, 0x11 }; // pulse, saw, triangle + gate
+    for(int voice=0; voice<3; ++voice) {
+        int offset = 7*voice;
+        sid->write(offset + 2, 0x00); // pulsewidth low
+        sid->write(offset + 3, 0x08); // pulsewidth high
+        sid->write(offset + 5, 0x22); // attack/decay
+        sid->write(offset + 6, 0xa8); // sustain/release
+        sid->write(offset + 4, waveform[voice]);
+    }
+    sid->write(0x15, 0x00); // cutoff low
+    sid->write(0x16, 0x40); // cutoff high
+    sid->write(0x17, 0xf7); // resonance, all voices filtered
+    sid->write(0x18, 0x1f); // lowpass, volume
+}
+
+
+//==============================================================================
+// emulates a MBSID update cycle: frequency and pulsewidth modulation, filter sweep, retriggers
+static void sidUpdate(SID *sid, int sidNum, unsigned updateCounter)
+{
+    for(int voice=0; voice<3; ++voice) {
+        int offset = 7*voice;
+        unsigned frq = 0x0800 + ((sidNum*3 + voice) << 9) + (randomGet() & 0x3f);
+        sid->write(offset + 0, frq & 0xff);
+        sid->write(offset + 1, frq >> 8);
+        sid->write(offset + 2, updateCounter & 0xff);
+    }
+
+    unsigned cutoff = (updateCounter * 4) & 0x7ff;
+    sid->write(0x15, cutoff & 0x07);
+    sid->write(0x16, cutoff >> 3);
+
+    // retrigger all voices each 250 mS
+    if( (updateCounter % 250) == 0 ) {
+        static const unsigned char waveform[3] = { 0x41, 0x21, 0x11 };
+        for(int voice=0; voice<3; ++voice)
+            sid->write(7*voice + 4, waveform[voice] & 0xfe);
+    } else if( (updateCounter % 250) == 1 ) {
+        static const unsigned char waveform[3] = { 0x41, 0x21, 0x11 };
+        for(int voice=0; voice<3; ++voice)
+            sid->write(7*voice + 4, waveform[voice]);
+    }
+}
+
+
+//==============================================================================
+// renders the test sequence into a stereo buffer (even SIDs: left, odd SIDs: right)
+// returns the consumed CPU time in seconds
+static double render(int numSids, bool blockRendering, double sampleRate, int numSamples, float *outL, float *outR)
+{
+    SID *sid[MAX_SIDS];
+    short blockBuffer[SID_BLOCK_RENDERER_MAX_SAMPLES];
+
+    for(int i=0; i<numSids; ++i) {
+        sid[i] = new SID;
+        sidInit(sid[i], sampleRate);
+    }
+
+    memset(outL, 0, numSamples*sizeof(float));
+    memset(outR, 0, numSamples*sizeof(float));
+
+    randomState = 1;
+    double updateCounter = 0;
+    unsigned updates = 0;
+
+    clock_t begin = clock();
+
+    if( blockRendering ) {
+        int blockBegin = 0;
+        for(int i=0; i<=numSamples; ++i) {
+            bool update = false;
+            if( i < numSamples ) {
+                updateCounter += (double)MBSID_UPDATE_FRQ / sampleRate;
+                if( updateCounter >= 1.0 ) {
+                    updateCounter -= 1.0;
+                    update = true;
+                }
+            }
+
+            int blockSize = i - blockBegin;
+            if( blockSize > 0 && (update || i == numSamples || blockSize >= SID_BLOCK_RENDERER_MAX_SAMPLES) ) {
+                for(int s=0; s<numSids; ++s) {
+                    SidBlockRenderer::renderBlock(sid[s], blockBuffer, blockSize);
+                    SidBlockRenderer::mixBlock((s & 1) ? &outR[blockBegin] : &outL[blockBegin], blockBuffer, blockSize);
+                }
+                blockBegin = i;
+            }
+
+            if( update ) {
+                ++updates;
+                for(int s=0; s<numSids; ++s)
+                    sidUpdate(sid[s], s, updates);
+            }
+        }
+    } else {
+        for(int i=0; i<numSamples; ++i) {
+            updateCounter += (double)MBSID_UPDATE_FRQ / sampleRate;
+            if( updateCounter >= 1.0 ) {
+                updateCounter -= 1.0;
+                ++updates;
+                for(int s=0; s<numSids; ++s)
+                    sidUpdate(sid[s], s, updates);
+            }
+
+            for(int s=0; s<numSids; ++s) {
+                short sample = SidBlockRenderer::renderSample(sid[s]);
+                float *out = (s & 1) ? outR : outL;
+                out[i] += (float)sample / 32768.0f;
+            }
+        }
+    }
+
+    double seconds = (double)(clock() - begin) / CLOCKS_PER_SEC;
+
+    for(int i=0; i<numSids; ++i)
+        delete sid[i];
+
+    return seconds;
+}
+
+
+//==============================================================================
+int main(int argc, char *argv[])
+{
+    double sampleRate = 44100.0;
+    double audioSeconds = 10.0;
+
+    if( argc >= 2 )
+        audioSeconds = atof(argv[1]);
+    if( argc >= 3 )
+        sampleRate = atof(argv[2]);
+
+    if( audioSeconds <= 0 || sampleRate < 8000 ) {
+        fprintf(stderr, "SYNTAX: %s [<seconds> [<sample rate>]]\n", argv[0]);
+        return 1;
+    }
+
+    int numSamples = (int)(audioSeconds * sampleRate);
+    float *refL = new float[numSamples];
+    float *refR = new float[numSamples];
+    float *blkL = new float[numSamples];
+    float *blkR = new float[numSamples];
+
+    printf("reSID render benchmark: %.1f seconds @ %.0f Hz, MBSID updates @ %d Hz\n", audioSeconds, sampleRate, MBSID_UPDATE_FRQ);
+    printf("real-time factor = rendered audio time / consumed CPU time (higher is better)\n\n");
+    printf("SIDs | per sample: CPU [s]  RT factor | block: CPU [s]  RT factor | speedup | identical\n");
+    printf("-----+---------------------------------+----------------------------+---------+----------\n");
+
+    int failed = 0;
+    for(int numSids=1; numSids<=MAX_SIDS; numSids *= 2) {
+        double refSeconds = render(numSids, false, sampleRate, numSamples, refL, refR);
+        double blkSeconds = render(numSids, true, sampleRate, numSamples, blkL, blkR);
+
+        bool identical = memcmp(refL, blkL, numSamples*sizeof(float)) == 0 &&
+                         memcmp(refR, blkR, numSamples*sizeof(float)) == 0;
+        if( !identical )
+            failed = 1;
+
+        printf("%4d |            %8.3f  %9.2f |       %8.3f  %9.2f | %6.2fx | %s\n",
+               numSids,
+               refSeconds, refSeconds > 0 ? audioSeconds / refSeconds : 0,
+               blkSeconds, blkSeconds > 0 ? audioSeconds / blkSeconds : 0,
+               blkSeconds > 0 ? refSeconds / blkSeconds : 0,
+               identical ? "yes" : "NO");
+    }
+
+    delete[] refL;
+    delete[] refR;
+    delete[] blkL;
+    delete[] blkR;
+
+    return failed;
+}
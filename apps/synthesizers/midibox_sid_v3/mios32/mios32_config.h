@@ -95,6 +95,7 @@
 // MBNet Config:
 // relevant if configured as master: how many nodes should be scanned maximum
 #define SID_USE_MBNET           1
+#define SID_USE_CHANGE_LIST     1
 #define MBNET_SLAVE_NODES_MAX   4
 #define MBNET_SLAVE_NODES_BEGIN 0x00
 #define MBNET_SLAVE_NODES_END   0x03
@@ -14,5 +14,12 @@
 #define MIOS32_LCD_BOOT_MSG_LINE1 "Tutorial #019"
 #define MIOS32_LCD_BOOT_MSG_LINE2 "(C) 2009 T.Klose"
 
+// decode the MIDI file into RAM, so that no SD Card access is required during playback
+// files which don't fit into this buffer are read from SD Card
+#define MID_PARSER_EVENT_BUFFER_SIZE 16*1024
+
+// SEQ_PlayEvent() schedules SysEx packages like any other event
+#define MID_PARSER_SYSEX_PACKAGES 1
+
 
 #endif /* _MIOS32_CONFIG_H */
@@ -20,11 +20,22 @@
 // Global definitions
 /////////////////////////////////////////////////////////////////////////////
 
+// max. number of pin changes which are passed to the MIOS32_DIN_BatchHandler callback at once
+// (the change list is located on the stack of the calling task)
+#ifndef MIOS32_DIN_BATCH_SIZE
+#define MIOS32_DIN_BATCH_SIZE 32
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Global Types
 /////////////////////////////////////////////////////////////////////////////
 
+typedef struct {
+  u16 pin;
+  u8  value;
+} mios32_din_change_t;
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Prototypes
@@ -36,6 +47,7 @@ extern s32 MIOS32_DIN_PinGet(u32 pin);
 extern s32 MIOS32_DIN_SRGet(u32 sr);
 extern u8 MIOS32_DIN_SRChangedGetAndClear(u32 sr, u8 mask);
 extern s32 MIOS32_DIN_Handler(void *callback);
+extern s32 MIOS32_DIN_BatchHandler(void *callback);
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -30,6 +30,26 @@
 #endif
 
 
+// 1: MIOS32_MIDI_Receive_Handler fetches the packages of all interfaces into
+//    per-port receive queues, and dispatches realtime, system common and channel
+//    messages before SysEx streams
+// 0: packages are dispatched in the order of the interfaces (default)
+#ifndef MIOS32_MIDI_RX_QUEUES
+#define MIOS32_MIDI_RX_QUEUES 0
+#endif
+
+// size of each receive queue (two queues per port: messages and SysEx)
+// must be a power of two!
+#ifndef MIOS32_MIDI_RX_QUEUE_SIZE
+#define MIOS32_MIDI_RX_QUEUE_SIZE 16 // packages
+#endif
+
+// default number of packages which are dispatched from a port before the next port is serviced
+#ifndef MIOS32_MIDI_RX_QUEUE_DEFAULT_WEIGHT
+#define MIOS32_MIDI_RX_QUEUE_DEFAULT_WEIGHT 4
+#endif
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Uses by MIOS32 SysEx parser
 /////////////////////////////////////////////////////////////////////////////
@@ -190,6 +210,15 @@ typedef union {
 } mios32_midi_package_t;
 
 
+// statistics of a receive queue (only available if MIOS32_MIDI_RX_QUEUES enabled)
+typedef struct {
+  u32 received;          // number of packages which have been fetched from the interface
+  u32 overruns;          // number of packages which bypassed the queue since it was full
+  u16 msg_level_max;     // max number of queued realtime/system common/channel messages
+  u16 sysex_level_max;   // max number of queued SysEx packages
+} mios32_midi_rx_queue_stats_t;
+
+
 // command states
 typedef enum {
   MIOS32_MIDI_SYSEX_CMD_STATE_BEGIN,
@@ -212,6 +241,7 @@ extern s32 MIOS32_MIDI_RS_Reset(mios32_midi_port_t port);
 
 extern s32 MIOS32_MIDI_SendPackage_NonBlocking(mios32_midi_port_t port, mios32_midi_package_t package);
 extern s32 MIOS32_MIDI_SendPackage(mios32_midi_port_t port, mios32_midi_package_t package);
+extern s32 MIOS32_MIDI_SendPackages(mios32_midi_port_t port, const mios32_midi_package_t *packages, u32 num);
 
 extern s32 MIOS32_MIDI_SendEvent(mios32_midi_port_t port, u8 evnt0, u8 evnt1, u8 evnt2);
 extern s32 MIOS32_MIDI_SendNoteOff(mios32_midi_port_t port, mios32_midi_chn_t chn, u8 note, u8 vel);
@@ -248,6 +278,11 @@ extern s32 MIOS32_MIDI_Receive_Handler(void *callback_event);
 
 extern s32 MIOS32_MIDI_Periodic_mS(void);
 
+extern s32 MIOS32_MIDI_RxQueueWeightSet(mios32_midi_port_t port, u8 weight);
+extern s32 MIOS32_MIDI_RxQueueWeightGet(mios32_midi_port_t port);
+extern s32 MIOS32_MIDI_RxQueueStatsGet(mios32_midi_port_t port, mios32_midi_rx_queue_stats_t *stats);
+extern s32 MIOS32_MIDI_RxQueueStatsClear(void);
+
 extern s32 MIOS32_MIDI_DirectTxCallback_Init(s32 (*callback_tx)(mios32_midi_port_t port, mios32_midi_package_t package));
 extern s32 MIOS32_MIDI_DirectRxCallback_Init(s32 (*callback_rx)(mios32_midi_port_t port, u8 midi_byte));
 
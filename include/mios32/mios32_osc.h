@@ -29,6 +29,48 @@
 #define MIOS32_OSC_MAX_ARGS 8
 #endif
 
+// OSC: max. nesting depth of bundles in a packet
+#ifndef MIOS32_OSC_MAX_BUNDLE_NESTING
+#define MIOS32_OSC_MAX_BUNDLE_NESTING 4
+#endif
+
+// OSC: search trees can be compiled into a hash table with MIOS32_OSC_CompileSearchTree()
+// number of hash table entries (power of 2, 3/4 can be used for address parts without wildcards)
+// 0 disables the compiler to save RAM (8 bytes per entry)
+#ifndef MIOS32_OSC_SEARCH_HASH_SIZE
+# if defined(MIOS32_FAMILY_STM32F4xx) || defined(MIOS32_FAMILY_EMULATION)
+#  define MIOS32_OSC_SEARCH_HASH_SIZE 128
+# else
+#  define MIOS32_OSC_SEARCH_HASH_SIZE 0
+# endif
+#endif
+
+// OSC: max. number of different search tree arrays (levels) in compiled search trees
+#ifndef MIOS32_OSC_SEARCH_MAX_LEVELS
+#define MIOS32_OSC_SEARCH_MAX_LEVELS 16
+#endif
+
+// OSC: max. number of address parts with wildcards (e.g. "note_*") in compiled search trees
+#ifndef MIOS32_OSC_SEARCH_MAX_PATTERNS
+#define MIOS32_OSC_SEARCH_MAX_PATTERNS 16
+#endif
+
+// OSC: limits for address parts with wildcards, since they are matched against received packets
+// max. length of an address part (pattern and matched string)
+#ifndef MIOS32_OSC_MAX_PATTERN_LEN
+#define MIOS32_OSC_MAX_PATTERN_LEN 63
+#endif
+
+// max. number of wildcards ('*', '?', "[..]", "{..}") in an address part
+#ifndef MIOS32_OSC_MAX_PATTERN_WILDCARDS
+#define MIOS32_OSC_MAX_PATTERN_WILDCARDS 8
+#endif
+
+// max. number of alternatives in the "{..}" groups of an address part
+#ifndef MIOS32_OSC_MAX_PATTERN_ALTERNATIVES
+#define MIOS32_OSC_MAX_PATTERN_ALTERNATIVES 16
+#endif
+
 // the output function which is used to print debug messages
 // could be replaced by printf (e.g. for emulations)
 #ifndef MIOS32_OSC_DEBUG_MSG
@@ -103,6 +145,7 @@ extern u8 *MIOS32_OSC_PutChar(u8 *buffer, char c);
 extern mios32_midi_package_t MIOS32_OSC_GetMIDI(u8 *buffer);
 extern u8 *MIOS32_OSC_PutMIDI(u8 *buffer, mios32_midi_package_t p);
 
+extern s32 MIOS32_OSC_CompileSearchTree(const mios32_osc_search_tree_t *search_tree);
 extern s32 MIOS32_OSC_ParsePacket(u8 *packet, u32 len, const mios32_osc_search_tree_t *search_tree);
 
 extern s32 MIOS32_OSC_SendDebugMessage(mios32_osc_args_t *osc_args, u32 method_arg);
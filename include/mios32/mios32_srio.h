@@ -26,6 +26,10 @@
 #endif
 
 
+// number of 32bit words of the mios32_srio_din_changed_sr bitmap
+#define MIOS32_SRIO_NUM_SR_WORDS ((MIOS32_SRIO_NUM_SR+31)/32)
+
+
 // how many DOUT pages are supported (used for dimmed LED and optimized matrix handling support)
 #ifndef MIOS32_SRIO_NUM_DOUT_PAGES
 #define MIOS32_SRIO_NUM_DOUT_PAGES 1
@@ -96,6 +100,7 @@ extern volatile u8 mios32_srio_dout[MIOS32_SRIO_NUM_DOUT_PAGES][MIOS32_SRIO_NUM_
 extern volatile u8 mios32_srio_din[MIOS32_SRIO_NUM_SR];
 extern volatile u8 mios32_srio_din_buffer[MIOS32_SRIO_NUM_SR]; // only required for emulation
 extern volatile u8 mios32_srio_din_changed[MIOS32_SRIO_NUM_SR];
+extern volatile u32 mios32_srio_din_changed_sr[MIOS32_SRIO_NUM_SR_WORDS]; // one bit per SR with change flags
 
 // the current DOUT page
 #if MIOS32_SRIO_NUM_DOUT_PAGES > 1
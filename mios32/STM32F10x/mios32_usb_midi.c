@@ -198,6 +198,107 @@ s32 MIOS32_USB_MIDI_PackageSend(mios32_midi_package_t package)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+//! This function puts multiple MIDI packages into the Tx buffer in one pass
+//! \param[in] cable cable number which will be inserted into the packages
+//! \param[in] packages pointer to the MIDI packages
+//! \param[in] num number of packages
+//! \return >= 0: number of packages which have been put into the buffer
+//!          (can be less than num if the buffer is full - caller should
+//!          retry with the remaining packages)
+//! \return -1: USB not connected
+//! \return -2: buffer is full
+//!             caller should retry until buffer is free again
+//! \note Applications shouldn't call this function directly, instead please use \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_USB_MIDI_PackagesSend_NonBlocking(u8 cable, const mios32_midi_package_t *packages, u32 num)
+{
+  u32 i;
+  u16 head;
+  u16 num_free;
+
+  // device available?
+  if( !transfer_possible )
+    return -1;
+
+  // buffer full?
+  if( tx_buffer_size >= (MIOS32_USB_MIDI_TX_BUFFER_SIZE-1) ) {
+    // call USB handler, so that we are able to get the buffer free again on next execution
+    // (this call simplifies polling loops!)
+    MIOS32_USB_MIDI_TxBufferHandler();
+
+    // device still available?
+    // (ensures that polling loop terminates if cable has been disconnected)
+    if( !transfer_possible )
+      return -1;
+
+    // notify that buffer was full (request retry)
+    return -2;
+  }
+
+  // limit to the number of free entries
+  num_free = (MIOS32_USB_MIDI_TX_BUFFER_SIZE-1) - tx_buffer_size;
+  if( num > num_free )
+    num = num_free;
+
+  // put packages into buffer - this operation should be atomic!
+  // (the Tx handler can only free entries meanwhile, so the number of free entries is still valid)
+  MIOS32_IRQ_Disable();
+  head = tx_buffer_head;
+  for(i=0; i<num; ++i) {
+    mios32_midi_package_t package = packages[i];
+    package.cable = cable;
+    tx_buffer[head] = package.ALL;
+    if( ++head >= MIOS32_USB_MIDI_TX_BUFFER_SIZE )
+      head = 0;
+  }
+  tx_buffer_head = head;
+  tx_buffer_size += num;
+  MIOS32_IRQ_Enable();
+
+  // start the transfer immediately if the IN endpoint is idle
+  MIOS32_USB_MIDI_TxBufferHandler();
+
+  return num;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//! This function puts multiple MIDI packages into the Tx buffer
+//! (blocking function)
+//! \param[in] cable cable number which will be inserted into the packages
+//! \param[in] packages pointer to the MIDI packages
+//! \param[in] num number of packages
+//! \return 0: no error
+//! \return -1: USB not connected
+//! \return -2: timeout, not all packages have been sent
+//! \note Applications shouldn't call this function directly, instead please use \ref MIOS32_MIDI layer functions
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_USB_MIDI_PackagesSend(u8 cable, const mios32_midi_package_t *packages, u32 num)
+{
+  static u16 timeout_ctr = 0;
+  // same timeout handling like for MIOS32_USB_MIDI_PackageSend
+
+  while( num ) {
+    s32 sent;
+
+    while( (sent=MIOS32_USB_MIDI_PackagesSend_NonBlocking(cable, packages, num)) == -2 ) {
+      if( timeout_ctr >= 10000 )
+        return -2;
+      ++timeout_ctr;
+    }
+
+    if( sent < 0 )
+      return sent;
+
+    timeout_ctr = 0; // no error: reset timeout counter
+    packages += sent;
+    num -= sent;
+  }
+
+  return 0; // no error
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 //! This function checks for a new package
 //! \param[out] package pointer to MIDI package (received package will be put into the given variable)
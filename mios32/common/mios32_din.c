@@ -41,6 +41,9 @@ s32 MIOS32_DIN_Init(u32 mode)
     mios32_srio_din[i] = 0xff; // passive state
     mios32_srio_din_changed[i] = 0;
   }
+  for(i=0; i<MIOS32_SRIO_NUM_SR_WORDS; ++i) {
+    mios32_srio_din_changed_sr[i] = 0;
+  }
 
   return 0;
 }
@@ -129,20 +132,17 @@ u8 MIOS32_DIN_SRChangedGetAndClear(u32 sr, u8 mask)
 
 
 /////////////////////////////////////////////////////////////////////////////
-//! Checks for pin changes, and calls given callback function with following parameters:
-//! \code
-//!   void DIN_NotifyToggle(u32 pin, u32 value)
-//! \endcode
-//! \param[in] _callback pointer to callback function
-//! \return < 0 on errors
+// Visits all DIN pin changes and forwards them either to a toggle callback,
+// or collects them for a batch callback.
+// Only SRs flagged in mios32_srio_din_changed_sr are checked, and only the
+// changed pins of these SRs (count-trailing-zeros instead of 8 pin checks)
 /////////////////////////////////////////////////////////////////////////////
-s32 MIOS32_DIN_Handler(void *_callback)
+static s32 MIOS32_DIN_Dispatch(void (*callback)(u32 pin, u32 value), void (*batch_callback)(u32 num_changes, mios32_din_change_t *changes))
 {
-  s32 sr;
-  s32 sr_pin;
-  u8 changed;
-  void (*callback)(u32 pin, u32 value) = _callback;
   u8 num_sr = MIOS32_SRIO_ScanNumGet();
+  mios32_din_change_t changes[MIOS32_DIN_BATCH_SIZE];
+  u32 num_changes = 0;
+  s32 word;
 
   // no SRIOs?
 #if MIOS32_SRIO_NUM_SR == 0
@@ -152,34 +152,96 @@ s32 MIOS32_DIN_Handler(void *_callback)
   if( num_sr == 0 )
     return -1;
 
-  // no callback function?
-  if( _callback == NULL )
-    return -1;
-
-  // check all shift registers for DIN pin changes
-  for(sr=0; sr<num_sr; ++sr) {
-    
-    // check if there are pin changes (mask all pins)
-    changed = MIOS32_DIN_SRChangedGetAndClear(sr, 0xff);
-
-    // any pin change at this SR?
-    if( !changed )
-      continue;
-
-    // check all 8 pins of the SR
-    for(sr_pin=0; sr_pin<8; ++sr_pin)
-      if( changed & (1 << sr_pin) ) {
-	// call the notification function
-	callback(8*sr+sr_pin, (mios32_srio_din[sr] & (1 << sr_pin)) ? 1 : 0);
+  for(word=0; word<MIOS32_SRIO_NUM_SR_WORDS; ++word) {
+    // get and clear SR flags - must be atomic!
+    MIOS32_IRQ_Disable();
+    u32 changed_sr = mios32_srio_din_changed_sr[word];
+    mios32_srio_din_changed_sr[word] = 0;
+    MIOS32_IRQ_Enable();
+
+    while( changed_sr ) {
+      u32 sr = 32*word + __builtin_ctz(changed_sr);
+      changed_sr &= changed_sr - 1; // clear lowest bit
+
+      // remaining flags are beyond the scanned SRs as well
+      if( sr >= num_sr )
+	break;
+
+      // check if there are pin changes (mask all pins)
+      // could have been taken by another handler meanwhile (e.g. encoders)
+      u8 changed = MIOS32_DIN_SRChangedGetAndClear(sr, 0xff);
+
+      while( changed ) {
+	u32 sr_pin = __builtin_ctz(changed);
+	changed &= changed - 1; // clear lowest bit
+
+	u32 value = (mios32_srio_din[sr] & (1 << sr_pin)) ? 1 : 0;
+
+	if( callback != NULL ) {
+	  // call the notification function
+	  callback(8*sr+sr_pin, value);
+	} else {
+	  changes[num_changes].pin = 8*sr+sr_pin;
+	  changes[num_changes].value = value;
+	  if( ++num_changes >= MIOS32_DIN_BATCH_SIZE ) {
+	    batch_callback(num_changes, changes);
+	    num_changes = 0;
+	  }
+	}
 
 	// start debouncing (if enabled in SRIO driver)
 	MIOS32_SRIO_DebounceStart();
       }
+    }
   }
 
+  if( num_changes )
+    batch_callback(num_changes, changes);
+
   return 0;
 }
 
+
+/////////////////////////////////////////////////////////////////////////////
+//! Checks for pin changes, and calls given callback function with following parameters:
+//! \code
+//!   void DIN_NotifyToggle(u32 pin, u32 value)
+//! \endcode
+//! \param[in] _callback pointer to callback function
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_DIN_Handler(void *_callback)
+{
+  // no callback function?
+  if( _callback == NULL )
+    return -1;
+
+  return MIOS32_DIN_Dispatch(_callback, NULL);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Checks for pin changes like MIOS32_DIN_Handler, but delivers all changes
+//! of the last scan with a single call of the given callback function:
+//! \code
+//!   void DIN_NotifyChanges(u32 num_changes, mios32_din_change_t *changes)
+//! \endcode
+//! changes[i].pin and changes[i].value correspond to the parameters of
+//! DIN_NotifyToggle. The callback won't be called if no pin has changed.
+//! If more than MIOS32_DIN_BATCH_SIZE pins have changed, the callback
+//! will be called multiple times.
+//! \param[in] _callback pointer to callback function
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_DIN_BatchHandler(void *_callback)
+{
+  // no callback function?
+  if( _callback == NULL )
+    return -1;
+
+  return MIOS32_DIN_Dispatch(NULL, _callback);
+}
+
 //! \}
 
 #endif /* MIOS32_DONT_USE_DIN */
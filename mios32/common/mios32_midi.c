@@ -128,6 +128,110 @@ typedef union {
 } sysex_timeout_ctr_flags_t;
 
 
+typedef struct {
+  mios32_midi_port_t port;
+  s32 (*receive_func)(u8 if_port, mios32_midi_package_t *package);
+} midi_intf_table_t;
+
+
+#if MIOS32_MIDI_RX_QUEUES
+typedef struct {
+  mios32_midi_package_t msg[MIOS32_MIDI_RX_QUEUE_SIZE];   // realtime, system common and channel messages
+  mios32_midi_package_t sysex[MIOS32_MIDI_RX_QUEUE_SIZE]; // SysEx streams
+  u16 msg_head;
+  u16 msg_tail;
+  u16 sysex_head;
+  u16 sysex_tail;
+  mios32_midi_port_t port;
+  u8 weight;
+  mios32_midi_rx_queue_stats_t stats;
+} midi_rx_queue_t;
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local definitions
+/////////////////////////////////////////////////////////////////////////////
+
+// IIC and UART based MIDI interfaces which are polled by MIOS32_MIDI_Receive_Handler
+static const midi_intf_table_t midi_intf_table[] = {
+#if !defined(MIOS32_DONT_USE_UART) && !defined(MIOS32_DONT_USE_UART_MIDI)
+#if MIOS32_UART_NUM >= 1
+  { UART0, MIOS32_UART_MIDI_PackageReceive },
+#endif
+#if MIOS32_UART_NUM >= 2
+  { UART1, MIOS32_UART_MIDI_PackageReceive },
+#endif
+#if MIOS32_UART_NUM >= 3
+  { UART2, MIOS32_UART_MIDI_PackageReceive },
+#endif
+#if MIOS32_UART_NUM >= 4
+  { UART3, MIOS32_UART_MIDI_PackageReceive },
+#endif
+#endif
+#if !defined(MIOS32_DONT_USE_IIC) && !defined(MIOS32_DONT_USE_IIC_MIDI)
+#if MIOS32_IIC_MIDI_NUM >= 1
+  { IIC0, MIOS32_IIC_MIDI_PackageReceive },
+#endif
+#if MIOS32_IIC_MIDI_NUM >= 2
+  { IIC1, MIOS32_IIC_MIDI_PackageReceive },
+#endif
+#if MIOS32_IIC_MIDI_NUM >= 3
+  { IIC2, MIOS32_IIC_MIDI_PackageReceive },
+#endif
+#if MIOS32_IIC_MIDI_NUM >= 4
+  { IIC3, MIOS32_IIC_MIDI_PackageReceive },
+#endif
+#if MIOS32_IIC_MIDI_NUM >= 5
+  { IIC4, MIOS32_IIC_MIDI_PackageReceive },
+#endif
+#if MIOS32_IIC_MIDI_NUM >= 6
+  { IIC5, MIOS32_IIC_MIDI_PackageReceive },
+#endif
+#if MIOS32_IIC_MIDI_NUM >= 7
+  { IIC6, MIOS32_IIC_MIDI_PackageReceive },
+#endif
+#if MIOS32_IIC_MIDI_NUM >= 8
+  { IIC7, MIOS32_IIC_MIDI_PackageReceive },
+#endif
+#endif
+  { 0, NULL } // end of table
+};
+
+
+#if MIOS32_MIDI_RX_QUEUES
+// number of receive queues for each interface type
+#if !defined(MIOS32_DONT_USE_USB) && !defined(MIOS32_DONT_USE_USB_MIDI)
+# define MIDI_RX_QUEUE_NUM_USB  MIOS32_USB_MIDI_NUM_PORTS
+#else
+# define MIDI_RX_QUEUE_NUM_USB  0
+#endif
+#if !defined(MIOS32_DONT_USE_UART) && !defined(MIOS32_DONT_USE_UART_MIDI)
+# define MIDI_RX_QUEUE_NUM_UART MIOS32_UART_NUM
+#else
+# define MIDI_RX_QUEUE_NUM_UART 0
+#endif
+#if !defined(MIOS32_DONT_USE_IIC) && !defined(MIOS32_DONT_USE_IIC_MIDI)
+# define MIDI_RX_QUEUE_NUM_IIC  MIOS32_IIC_MIDI_NUM
+#else
+# define MIDI_RX_QUEUE_NUM_IIC  0
+#endif
+#if !defined(MIOS32_DONT_USE_SPI) && !defined(MIOS32_DONT_USE_SPI_MIDI)
+# define MIDI_RX_QUEUE_NUM_SPI  MIOS32_SPI_MIDI_NUM_PORTS
+#else
+# define MIDI_RX_QUEUE_NUM_SPI  0
+#endif
+
+#define MIDI_RX_QUEUE_OFFSET_USB  0
+#define MIDI_RX_QUEUE_OFFSET_UART (MIDI_RX_QUEUE_OFFSET_USB + MIDI_RX_QUEUE_NUM_USB)
+#define MIDI_RX_QUEUE_OFFSET_IIC  (MIDI_RX_QUEUE_OFFSET_UART + MIDI_RX_QUEUE_NUM_UART)
+#define MIDI_RX_QUEUE_OFFSET_SPI  (MIDI_RX_QUEUE_OFFSET_IIC + MIDI_RX_QUEUE_NUM_IIC)
+#define MIDI_RX_QUEUE_NUM         (MIDI_RX_QUEUE_OFFSET_SPI + MIDI_RX_QUEUE_NUM_SPI)
+
+#define MIDI_RX_QUEUE_MASK        (MIOS32_MIDI_RX_QUEUE_SIZE-1)
+#endif
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Local variables
 /////////////////////////////////////////////////////////////////////////////
@@ -165,6 +269,10 @@ static mios32_midi_port_t last_sysex_port = DEFAULT;
 static u16 sysex_timeout_ctr;
 static sysex_timeout_ctr_flags_t sysex_timeout_ctr_flags;
 
+#if MIOS32_MIDI_RX_QUEUES
+static midi_rx_queue_t midi_rx_queue[MIDI_RX_QUEUE_NUM];
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Local prototypes
@@ -180,6 +288,13 @@ static s32 MIOS32_MIDI_SYSEX_SendAck(mios32_midi_port_t port, u8 ack_code, u8 ac
 static s32 MIOS32_MIDI_SYSEX_SendAckStr(mios32_midi_port_t port, char *str);
 static s32 MIOS32_MIDI_TimeOut(mios32_midi_port_t port);
 
+#if MIOS32_MIDI_RX_QUEUES
+static s32 MIOS32_MIDI_RxQueueInit(void);
+static s32 MIOS32_MIDI_RxQueueSlotGet(mios32_midi_port_t port);
+static s32 MIOS32_MIDI_RxQueueFetch(int *intf_budget, void *_callback_package);
+static s32 MIOS32_MIDI_RxQueueDispatch(u8 sysex, u8 single_round, void *_callback_package);
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 //! Initializes MIDI layer
@@ -243,6 +358,10 @@ s32 MIOS32_MIDI_Init(u32 mode)
   sysex_timeout_ctr = 0;
   sysex_timeout_ctr_flags.ALL = 0;
 
+#if MIOS32_MIDI_RX_QUEUES
+  MIOS32_MIDI_RxQueueInit();
+#endif
+
   return -ret;
 }
 
@@ -561,6 +680,76 @@ s32 MIOS32_MIDI_SendPackage(mios32_midi_port_t port, mios32_midi_package_t packa
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+//! Sends multiple packages over given port
+//!
+//! For USB ports, the packages are copied into the Tx buffer in one pass,
+//! which is much faster than sending them package by package with
+//! MIOS32_MIDI_SendPackage (e.g. for chords, CC bursts and SysEx dumps).
+//! Other ports are served package by package.
+//!
+//! The optional Tx Callback function will be called for each package.
+//! (blocking function)
+//! \param[in] port MIDI port (DEFAULT, USB0..USB7, UART0..UART3, IIC0..IIC7, SPIM0..SPIM7)
+//! \param[in] packages pointer to the MIDI packages
+//! \param[in] num number of packages
+//! \return -1 if port not available
+//! \return -3 Tx Callback reported an error
+//! \return 0 on success
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_MIDI_SendPackages(mios32_midi_port_t port, const mios32_midi_package_t *packages, u32 num)
+{
+  // if default/debug port: select mapped port
+  if( !(port & 0xf0) ) {
+    port = (port == MIDI_DEBUG) ? debug_port : default_port;
+  }
+
+#if !defined(MIOS32_DONT_USE_USB) && !defined(MIOS32_DONT_USE_USB_MIDI)
+  if( (port & 0xf0) == USB0 ) {
+    u8 cable = port & 0xf;
+    u32 first = 0;
+
+    // forward to Tx callback function, packages which haven't been filtered are sent in blocks
+    if( direct_tx_callback_func != NULL ) {
+      u32 i;
+      for(i=0; i<num; ++i) {
+	mios32_midi_package_t package = packages[i];
+	s32 status;
+
+	package.cable = cable;
+	if( (status=direct_tx_callback_func(port, package)) ) {
+	  if( i > first ) {
+	    s32 res = MIOS32_USB_MIDI_PackagesSend(cable, &packages[first], i - first);
+	    if( res < 0 )
+	      return res;
+	  }
+
+	  if( status < 0 )
+	    return status;
+
+	  first = i + 1; // package has been filtered
+	}
+      }
+    }
+
+    return (num > first) ? MIOS32_USB_MIDI_PackagesSend(cable, &packages[first], num - first) : 0;
+  }
+#endif
+
+  // all other ports: send package by package
+  {
+    u32 i;
+    for(i=0; i<num; ++i) {
+      s32 res = MIOS32_MIDI_SendPackage(port, packages[i]);
+      if( res < 0 )
+	return res;
+    }
+  }
+
+  return 0; // no error
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 //! Sends a MIDI Event
 //! This function is provided for a more comfortable use model
@@ -700,43 +889,49 @@ s32 MIOS32_MIDI_SendSysEx(mios32_midi_port_t port, u8 *stream, u32 count)
 {
   s32 res;
   u32 offset;
-  mios32_midi_package_t package;
-
-  // MEMO: have a look into the project.lss file - gcc optimizes this code pretty well :)
+  mios32_midi_package_t packages[16]; // sent in blocks of 16 packages
+  u32 num = 0;
 
   for(offset=0; offset<count;) {
+    mios32_midi_package_t *package = &packages[num];
+
     // package type depends on number of remaining bytes
     switch( count-offset ) {
       case 1: 
-	package.type = 0x5; // SysEx ends with following single byte. 
-	package.evnt0 = stream[offset++];
-	package.evnt1 = 0x00;
-	package.evnt2 = 0x00;
+	package->type = 0x5; // SysEx ends with following single byte. 
+	package->evnt0 = stream[offset++];
+	package->evnt1 = 0x00;
+	package->evnt2 = 0x00;
 	break;
       case 2:
-	package.type = 0x6; // SysEx ends with following two bytes.
-	package.evnt0 = stream[offset++];
-	package.evnt1 = stream[offset++];
-	package.evnt2 = 0x00;
+	package->type = 0x6; // SysEx ends with following two bytes.
+	package->evnt0 = stream[offset++];
+	package->evnt1 = stream[offset++];
+	package->evnt2 = 0x00;
 	break;
       case 3:
-	package.type = 0x7; // SysEx ends with following three bytes. 
-	package.evnt0 = stream[offset++];
-	package.evnt1 = stream[offset++];
-	package.evnt2 = stream[offset++];
+	package->type = 0x7; // SysEx ends with following three bytes. 
+	package->evnt0 = stream[offset++];
+	package->evnt1 = stream[offset++];
+	package->evnt2 = stream[offset++];
 	break;
       default:
-	package.type = 0x4; // SysEx starts or continues
-	package.evnt0 = stream[offset++];
-	package.evnt1 = stream[offset++];
-	package.evnt2 = stream[offset++];
+	package->type = 0x4; // SysEx starts or continues
+	package->evnt0 = stream[offset++];
+	package->evnt1 = stream[offset++];
+	package->evnt2 = stream[offset++];
     }
 
-    res=MIOS32_MIDI_SendPackage(port, package);
+    // send block if full, or if the end of stream has been reached
+    if( ++num >= (sizeof(packages)/sizeof(mios32_midi_package_t)) || offset >= count ) {
+      res=MIOS32_MIDI_SendPackages(port, packages, num);
+
+      // expection? (e.g., port not available)
+      if( res < 0 )
+	return res;
 
-    // expection? (e.g., port not available)
-    if( res < 0 )
-      return res;
+      num = 0;
+    }
   }
 
   return 0;
@@ -1224,6 +1419,19 @@ s32 MIOS32_MIDI_ReceivePackage(mios32_midi_port_t port, mios32_midi_package_t pa
 /////////////////////////////////////////////////////////////////////////////
 s32 MIOS32_MIDI_Receive_Handler(void *_callback_package)
 {
+#if MIOS32_MIDI_RX_QUEUES
+  // fetch packages of all interfaces into the receive queues, dispatch all
+  // realtime/system common/channel messages, and thereafter a limited number
+  // of SysEx packages per port, so that a big SysEx dump on one port doesn't
+  // delay messages (e.g. MIDI clock) received by other ports
+  int intf_budget = 10; // max 10 IIC and UART based packages because of possible timeouts
+  s32 fetched, dispatched_sysex;
+  do {
+    fetched = MIOS32_MIDI_RxQueueFetch(&intf_budget, _callback_package);
+    MIOS32_MIDI_RxQueueDispatch(0, 0, _callback_package);
+    dispatched_sysex = MIOS32_MIDI_RxQueueDispatch(1, 1, _callback_package);
+  } while( fetched > 0 || dispatched_sysex > 0 );
+#else
   // handle all USB MIDI packages
 #if !defined(MIOS32_DONT_USE_USB) && !defined(MIOS32_DONT_USE_USB_MIDI)
   {
@@ -1237,55 +1445,6 @@ s32 MIOS32_MIDI_Receive_Handler(void *_callback_package)
 
   // handle all IIC and UART based MIDI packages (round robin, max 10 packages because of possible timeouts)
   {
-    typedef struct {
-      mios32_midi_port_t port;
-      s32 (*receive_func)(u8 if_port, mios32_midi_package_t *package);
-    } midi_intf_table_t;
-
-    const midi_intf_table_t midi_intf_table[] = {
-#if !defined(MIOS32_DONT_USE_UART) && !defined(MIOS32_DONT_USE_UART_MIDI)
-#if MIOS32_UART_NUM >= 1
-      { UART0, MIOS32_UART_MIDI_PackageReceive },
-#endif
-#if MIOS32_UART_NUM >= 2
-      { UART1, MIOS32_UART_MIDI_PackageReceive },
-#endif
-#if MIOS32_UART_NUM >= 3
-      { UART2, MIOS32_UART_MIDI_PackageReceive },
-#endif
-#if MIOS32_UART_NUM >= 4
-      { UART3, MIOS32_UART_MIDI_PackageReceive },
-#endif
-#endif
-#if !defined(MIOS32_DONT_USE_IIC) && !defined(MIOS32_DONT_USE_IIC_MIDI)
-#if MIOS32_IIC_MIDI_NUM >= 1
-      { IIC0, MIOS32_IIC_MIDI_PackageReceive },
-#endif
-#if MIOS32_IIC_MIDI_NUM >= 2
-      { IIC1, MIOS32_IIC_MIDI_PackageReceive },
-#endif
-#if MIOS32_IIC_MIDI_NUM >= 3
-      { IIC2, MIOS32_IIC_MIDI_PackageReceive },
-#endif
-#if MIOS32_IIC_MIDI_NUM >= 4
-      { IIC3, MIOS32_IIC_MIDI_PackageReceive },
-#endif
-#if MIOS32_IIC_MIDI_NUM >= 5
-      { IIC4, MIOS32_IIC_MIDI_PackageReceive },
-#endif
-#if MIOS32_IIC_MIDI_NUM >= 6
-      { IIC5, MIOS32_IIC_MIDI_PackageReceive },
-#endif
-#if MIOS32_IIC_MIDI_NUM >= 7
-      { IIC6, MIOS32_IIC_MIDI_PackageReceive },
-#endif
-#if MIOS32_IIC_MIDI_NUM >= 8
-      { IIC7, MIOS32_IIC_MIDI_PackageReceive },
-#endif
-#endif
-      { 0, NULL } // end of table
-    };
-
     if( midi_intf_table[0].port != 0 ) {
       int packages_forwarded = 0;
       int packages_forwarded_this_round = 0;
@@ -1332,6 +1491,7 @@ s32 MIOS32_MIDI_Receive_Handler(void *_callback_package)
   }
 #endif
   
+#endif
 
   // SysEx timeout detected by this handler?
   if( sysex_timeout_ctr_flags.ALL && sysex_timeout_ctr > 1000 ) {
@@ -1372,6 +1532,357 @@ s32 MIOS32_MIDI_Receive_Handler(void *_callback_package)
 }
 
 
+#if MIOS32_MIDI_RX_QUEUES
+/////////////////////////////////////////////////////////////////////////////
+//! Sets the weight of a receive queue, which is the number of packages that
+//! are dispatched from the given port before the next port will be serviced.
+//!
+//! Only available if MIOS32_MIDI_RX_QUEUES is set in mios32_config.h
+//! \param[in] port MIDI port (USBx, UARTx, IICx, SPIMx)
+//! \param[in] weight number of packages (1..255)
+//! \return < 0 if port doesn't provide a receive queue
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_MIDI_RxQueueWeightSet(mios32_midi_port_t port, u8 weight)
+{
+  s32 slot = MIOS32_MIDI_RxQueueSlotGet(port);
+  if( slot < 0 )
+    return -1; // no queue for this port
+
+  midi_rx_queue[slot].weight = weight ? weight : 1;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Returns the weight of a receive queue
+//!
+//! Only available if MIOS32_MIDI_RX_QUEUES is set in mios32_config.h
+//! \param[in] port MIDI port (USBx, UARTx, IICx, SPIMx)
+//! \return < 0 if port doesn't provide a receive queue
+//! \return >= 1: the weight
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_MIDI_RxQueueWeightGet(mios32_midi_port_t port)
+{
+  s32 slot = MIOS32_MIDI_RxQueueSlotGet(port);
+  if( slot < 0 )
+    return -1; // no queue for this port
+
+  return midi_rx_queue[slot].weight;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Returns the statistics of a receive queue:
+//! <UL>
+//!   <LI>received: number of packages which have been queued
+//!   <LI>overruns: number of packages which had to be forwarded without queueing
+//!   <LI>msg_level_max: max. fill level of the message queue
+//!   <LI>sysex_level_max: max. fill level of the SysEx queue
+//! </UL>
+//!
+//! Only available if MIOS32_MIDI_RX_QUEUES is set in mios32_config.h
+//! \param[in] port MIDI port (USBx, UARTx, IICx, SPIMx)
+//! \param[out] stats pointer to the statistics structure
+//! \return < 0 if port doesn't provide a receive queue
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_MIDI_RxQueueStatsGet(mios32_midi_port_t port, mios32_midi_rx_queue_stats_t *stats)
+{
+  s32 slot = MIOS32_MIDI_RxQueueSlotGet(port);
+  if( slot < 0 )
+    return -1; // no queue for this port
+
+  *stats = midi_rx_queue[slot].stats;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Clears the statistics of all receive queues
+//!
+//! Only available if MIOS32_MIDI_RX_QUEUES is set in mios32_config.h
+//! \return < 0 on errors
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_MIDI_RxQueueStatsClear(void)
+{
+  int slot;
+  for(slot=0; slot<MIDI_RX_QUEUE_NUM; ++slot) {
+    midi_rx_queue_t *q = &midi_rx_queue[slot];
+    q->stats.received = 0;
+    q->stats.overruns = 0;
+    q->stats.msg_level_max = 0;
+    q->stats.sysex_level_max = 0;
+  }
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Initializes the receive queues
+/////////////////////////////////////////////////////////////////////////////
+static s32 MIOS32_MIDI_RxQueueInit(void)
+{
+  int slot;
+  for(slot=0; slot<MIDI_RX_QUEUE_NUM; ++slot) {
+    midi_rx_queue_t *q = &midi_rx_queue[slot];
+
+    if( slot >= MIDI_RX_QUEUE_OFFSET_SPI )
+      q->port = SPIM0 + (slot - MIDI_RX_QUEUE_OFFSET_SPI);
+    else if( slot >= MIDI_RX_QUEUE_OFFSET_IIC )
+      q->port = IIC0 + (slot - MIDI_RX_QUEUE_OFFSET_IIC);
+    else if( slot >= MIDI_RX_QUEUE_OFFSET_UART )
+      q->port = UART0 + (slot - MIDI_RX_QUEUE_OFFSET_UART);
+    else
+      q->port = USB0 + (slot - MIDI_RX_QUEUE_OFFSET_USB);
+
+    q->weight = MIOS32_MIDI_RX_QUEUE_DEFAULT_WEIGHT ? MIOS32_MIDI_RX_QUEUE_DEFAULT_WEIGHT : 1;
+    q->msg_head = q->msg_tail = 0;
+    q->sysex_head = q->sysex_tail = 0;
+  }
+
+  return MIOS32_MIDI_RxQueueStatsClear();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the receive queue slot of a port, or -1 if the port isn't queued
+/////////////////////////////////////////////////////////////////////////////
+static s32 MIOS32_MIDI_RxQueueSlotGet(mios32_midi_port_t port)
+{
+  u8 ix = port & 0x0f;
+
+  switch( port & 0xf0 ) {
+  case USB0:  if( ix < MIDI_RX_QUEUE_NUM_USB )  return MIDI_RX_QUEUE_OFFSET_USB + ix; break;
+  case UART0: if( ix < MIDI_RX_QUEUE_NUM_UART ) return MIDI_RX_QUEUE_OFFSET_UART + ix; break;
+  case IIC0:  if( ix < MIDI_RX_QUEUE_NUM_IIC )  return MIDI_RX_QUEUE_OFFSET_IIC + ix; break;
+  case SPIM0: if( ix < MIDI_RX_QUEUE_NUM_SPI )  return MIDI_RX_QUEUE_OFFSET_SPI + ix; break;
+  }
+
+  return -1; // no queue for this port
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns 1 if the package belongs to a SysEx stream
+// Realtime messages and system common messages (e.g. SPP, MTC) are
+// handled like channel messages to keep their order
+/////////////////////////////////////////////////////////////////////////////
+static u8 MIOS32_MIDI_RxQueueIsSysEx(mios32_midi_package_t package)
+{
+  switch( package.type ) {
+  case 0x4: // SysEx starts or continues
+  case 0x6: // SysEx ends with two bytes
+  case 0x7: // SysEx ends with three bytes
+    return 1;
+
+  case 0x5: // single-byte system common message or SysEx ends with single byte
+  case 0xf: // single byte
+    return package.evnt0 < 0x80 || package.evnt0 == 0xf0 || package.evnt0 == 0xf7;
+  }
+
+  return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Puts a package into the receive queue of the given slot
+// Returns -1 if the queue is full
+/////////////////////////////////////////////////////////////////////////////
+static s32 MIOS32_MIDI_RxQueuePut(s32 slot, mios32_midi_package_t package)
+{
+  midi_rx_queue_t *q = &midi_rx_queue[slot];
+  u16 level;
+
+  if( MIOS32_MIDI_RxQueueIsSysEx(package) ) {
+    level = (u16)(q->sysex_head - q->sysex_tail);
+    if( level >= MIOS32_MIDI_RX_QUEUE_SIZE )
+      return -1; // queue full
+    q->sysex[q->sysex_head++ & MIDI_RX_QUEUE_MASK] = package;
+    if( ++level > q->stats.sysex_level_max )
+      q->stats.sysex_level_max = level;
+  } else {
+    level = (u16)(q->msg_head - q->msg_tail);
+    if( level >= MIOS32_MIDI_RX_QUEUE_SIZE )
+      return -1; // queue full
+    q->msg[q->msg_head++ & MIDI_RX_QUEUE_MASK] = package;
+    if( ++level > q->stats.msg_level_max )
+      q->stats.msg_level_max = level;
+  }
+
+  ++q->stats.received;
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns 1 if one of the queues of the given slot can't take another package
+/////////////////////////////////////////////////////////////////////////////
+static u8 MIOS32_MIDI_RxQueueIsFull(s32 slot)
+{
+  midi_rx_queue_t *q = &midi_rx_queue[slot];
+  return (u16)(q->msg_head - q->msg_tail) >= MIOS32_MIDI_RX_QUEUE_SIZE ||
+         (u16)(q->sysex_head - q->sysex_tail) >= MIOS32_MIDI_RX_QUEUE_SIZE;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns 1 if any queue of the given port range is full
+// Used for interfaces which deliver packages of multiple ports (USB, SPI):
+// the port is only known after the package has been fetched, therefore
+// fetching is stopped as long as any of the queues is full
+/////////////////////////////////////////////////////////////////////////////
+static u8 MIOS32_MIDI_RxQueueAnyFull(s32 first_slot, s32 num_slots)
+{
+  s32 slot;
+  for(slot=first_slot; slot<(first_slot+num_slots); ++slot)
+    if( MIOS32_MIDI_RxQueueIsFull(slot) )
+      return 1;
+  return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Puts a package into a receive queue. If the port has no queue, the package
+// will be forwarded immediately.
+// The fetch loops ensure that queues are never full when a package is put.
+// Should this happen nevertheless, the queued packages of the port are
+// dispatched first, so that the order of the stream is kept.
+// Returns -1 if the package couldn't be queued
+/////////////////////////////////////////////////////////////////////////////
+static s32 MIOS32_MIDI_RxQueuePutOrForward(mios32_midi_port_t port, mios32_midi_package_t package, void *_callback_package)
+{
+  s32 slot = MIOS32_MIDI_RxQueueSlotGet(port);
+
+  if( slot >= 0 ) {
+    if( MIOS32_MIDI_RxQueuePut(slot, package) >= 0 )
+      return 0; // package queued
+
+    // flush the queues of this port before the package is forwarded
+    midi_rx_queue_t *q = &midi_rx_queue[slot];
+    ++q->stats.overruns;
+    while( q->msg_tail != q->msg_head )
+      MIOS32_MIDI_ReceivePackage(port, q->msg[q->msg_tail++ & MIDI_RX_QUEUE_MASK], _callback_package);
+    while( q->sysex_tail != q->sysex_head )
+      MIOS32_MIDI_ReceivePackage(port, q->sysex[q->sysex_tail++ & MIDI_RX_QUEUE_MASK], _callback_package);
+  }
+
+  MIOS32_MIDI_ReceivePackage(port, package, _callback_package);
+
+  return -1; // package not queued
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Fetches new packages from all MIDI interfaces into the receive queues
+// Returns the number of fetched packages
+/////////////////////////////////////////////////////////////////////////////
+static s32 MIOS32_MIDI_RxQueueFetch(int *intf_budget, void *_callback_package)
+{
+  s32 fetched = 0;
+
+  // USB MIDI packages: stop fetching once a queue is full, remaining packages stay
+  // in the driver buffer and are received after the queues have been dispatched
+#if !defined(MIOS32_DONT_USE_USB) && !defined(MIOS32_DONT_USE_USB_MIDI)
+  {
+    mios32_midi_package_t package;
+    while( !MIOS32_MIDI_RxQueueAnyFull(MIDI_RX_QUEUE_OFFSET_USB, MIDI_RX_QUEUE_NUM_USB) &&
+	   MIOS32_USB_MIDI_PackageReceive(&package) >= 0 ) {
+      ++fetched;
+      MIOS32_MIDI_RxQueuePutOrForward(USB0 + package.cable, package, _callback_package);
+    }
+  }
+#endif
+
+  // IIC and UART based MIDI packages: round robin, one package per interface and round
+  // an interface is only polled if both of its queues can take a package
+  if( midi_intf_table[0].port != 0 ) {
+    u8 fetched_this_round;
+    do {
+      int intf;
+
+      fetched_this_round = 0;
+      for(intf=0; midi_intf_table[intf].port && *intf_budget > 0; ++intf) {
+	mios32_midi_package_t package;
+	mios32_midi_port_t port = midi_intf_table[intf].port;
+	s32 slot = MIOS32_MIDI_RxQueueSlotGet(port);
+
+	if( slot >= 0 && MIOS32_MIDI_RxQueueIsFull(slot) )
+	  continue; // wait until the queue has been dispatched
+
+	// execute receive function
+	s32 status = midi_intf_table[intf].receive_func(port & 0x0f, &package);
+
+	if( status == -10 ) { // receive timeout?
+	  MIOS32_MIDI_TimeOut(port);
+	} else if( status >= 0 ) { // message received?
+	  ++fetched;
+	  ++fetched_this_round;
+	  --*intf_budget;
+
+	  MIOS32_MIDI_RxQueuePutOrForward(port, package, _callback_package);
+	}
+      }
+    } while( fetched_this_round && *intf_budget > 0 );
+  }
+
+  // SPI MIDI packages: same like USB
+#if !defined(MIOS32_DONT_USE_SPI) && !defined(MIOS32_DONT_USE_SPI_MIDI)
+  {
+    mios32_midi_package_t package;
+    while( !MIOS32_MIDI_RxQueueAnyFull(MIDI_RX_QUEUE_OFFSET_SPI, MIDI_RX_QUEUE_NUM_SPI) &&
+	   MIOS32_SPI_MIDI_PackageReceive(&package) >= 0 ) {
+      ++fetched;
+      MIOS32_MIDI_RxQueuePutOrForward(SPIM0 + package.cable, package, _callback_package);
+    }
+  }
+#endif
+
+  return fetched;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Dispatches queued packages to MIOS32_MIDI_ReceivePackage with weighted
+// round robin: each port forwards up to <weight> packages per round.
+// sysex == 0: message queues, sysex == 1: SysEx queues
+// single_round == 0: until all queues are empty, 1: only one round
+// Returns the number of dispatched packages
+/////////////////////////////////////////////////////////////////////////////
+static s32 MIOS32_MIDI_RxQueueDispatch(u8 sysex, u8 single_round, void *_callback_package)
+{
+  s32 dispatched = 0;
+
+  u8 pending;
+  do {
+    int slot;
+
+    pending = 0;
+    for(slot=0; slot<MIDI_RX_QUEUE_NUM; ++slot) {
+      midi_rx_queue_t *q = &midi_rx_queue[slot];
+      mios32_midi_package_t *ring = sysex ? q->sysex : q->msg;
+      u16 *head = sysex ? &q->sysex_head : &q->msg_head;
+      u16 *tail = sysex ? &q->sysex_tail : &q->msg_tail;
+      int n;
+
+      for(n=0; n<q->weight && *tail != *head; ++n) {
+	mios32_midi_package_t package = ring[(*tail)++ & MIDI_RX_QUEUE_MASK];
+	MIOS32_MIDI_ReceivePackage(q->port, package, _callback_package);
+	++dispatched;
+      }
+
+      if( *tail != *head )
+	pending = 1;
+    }
+  } while( pending && !single_round );
+
+  return dispatched;
+}
+#endif
+
+
 /////////////////////////////////////////////////////////////////////////////
 //! This function should be called periodically each mS to handle timeout
 //! and expire counters.
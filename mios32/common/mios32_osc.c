@@ -38,8 +38,13 @@
 //! address)
 //!
 //! OSC allows to use wildcards in the address path like *, ?, [] and {}.<BR>
-//! The MIOS32 implementation currently only supports '*' and '?'<BR>
-//! Examples: '/sid?/osc/finetune' or '/sid?/osc/fine*' or '/cs/led/*'
+//! All of them are supported in incoming addresses, nodes of the search tree
+//! can use them as well (e.g. "note_*" to get all notes)<BR>
+//! Examples: '/sid?/osc/finetune' or '/sid[1-4]/osc/fine*' or '/cs/{led,button}/*'
+//!
+//! Search trees can optionally be compiled into a hash table with
+//! MIOS32_OSC_CompileSearchTree(), so that the nodes of an address part are
+//! found without comparing the address with each node of the level.
 //! 
 //! While searching through the tree, the appr. functions of all matching methods 
 //! will be called with the OSC arguments which are part of the packet (+ the method argument):<BR>
@@ -144,12 +149,76 @@
 #if !defined(MIOS32_DONT_USE_OSC)
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Local definitions
+/////////////////////////////////////////////////////////////////////////////
+
+// OSC address pattern characters
+#define MIOS32_OSC_IS_WILDCARD(c) ((c) == '*' || (c) == '?' || (c) == '[' || (c) == '{')
+
+// next_level of nodes which are not compiled
+#define MIOS32_OSC_SEARCH_NO_LEVEL 0xff
+
+#if MIOS32_OSC_SEARCH_MAX_LEVELS >= MIOS32_OSC_SEARCH_NO_LEVEL
+# error "MIOS32_OSC_SEARCH_MAX_LEVELS too large"
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local types
+/////////////////////////////////////////////////////////////////////////////
+
+#if MIOS32_OSC_SEARCH_HASH_SIZE
+typedef struct {
+  const mios32_osc_search_tree_t *node; // NULL: free hash table slot
+  u16 hash;       // upper half of the hash, avoids most string compares on collisions
+  u8  level;      // level of the node
+  u8  next_level; // compiled level of node->next, or MIOS32_OSC_SEARCH_NO_LEVEL
+} mios32_osc_search_entry_t;
+
+typedef struct {
+  const mios32_osc_search_tree_t *tree; // search tree array of this level
+  u8  first_pattern; // nodes with wildcards in search_pattern[]
+  u8  num_patterns;
+  u8  is_root;       // search tree passed to MIOS32_OSC_CompileSearchTree()
+} mios32_osc_search_level_t;
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local variables
+/////////////////////////////////////////////////////////////////////////////
+
+#if MIOS32_OSC_SEARCH_HASH_SIZE
+#if (MIOS32_OSC_SEARCH_HASH_SIZE & (MIOS32_OSC_SEARCH_HASH_SIZE-1))
+# error "MIOS32_OSC_SEARCH_HASH_SIZE must be a power of 2"
+#endif
+static mios32_osc_search_entry_t search_hash[MIOS32_OSC_SEARCH_HASH_SIZE];
+static mios32_osc_search_entry_t search_pattern[MIOS32_OSC_SEARCH_MAX_PATTERNS];
+static mios32_osc_search_level_t search_level[MIOS32_OSC_SEARCH_MAX_LEVELS];
+static u8 num_search_levels;
+static u8 num_search_patterns;
+static u16 num_search_hash_entries;
+#endif
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Local prototypes
 /////////////////////////////////////////////////////////////////////////////
 
-static s32 MIOS32_OSC_SearchElement(u8 *buffer, u32 len, mios32_osc_args_t *osc_args, const mios32_osc_search_tree_t *search_tree);
+static u8 MIOS32_OSC_IsBundle(u8 *packet, u32 len);
+static s32 MIOS32_OSC_ParseBundle(u8 *packet, u32 len, mios32_osc_args_t *osc_args, const mios32_osc_search_tree_t *search_tree, s32 level, u8 nesting);
+static s32 MIOS32_OSC_SearchElement(u8 *buffer, u32 len, mios32_osc_args_t *osc_args, const mios32_osc_search_tree_t *search_tree, s32 level);
 static s32 MIOS32_OSC_SearchPath(char *path, mios32_osc_args_t *osc_args, u32 method_arg, const mios32_osc_search_tree_t *search_tree);
+static s32 MIOS32_OSC_SearchNode(char *next_path, mios32_osc_args_t *osc_args, u32 method_arg, const mios32_osc_search_tree_t *node, u8 next_level);
+static u8 MIOS32_OSC_MatchAddressPart(const char *part, size_t part_len, u8 part_wildcard, const char *address);
+static u8 MIOS32_OSC_MatchPattern(const char *pattern, const char *pattern_end, const char *str, const char *str_end);
+#if MIOS32_OSC_SEARCH_HASH_SIZE
+static u32 MIOS32_OSC_SearchHash(u8 level, const char *part, size_t part_len);
+static void MIOS32_OSC_CompileReset(void);
+static s32 MIOS32_OSC_CompileLevel(const mios32_osc_search_tree_t *search_tree, u8 depth);
+static s32 MIOS32_OSC_SearchPathCompiled(char *path, mios32_osc_args_t *osc_args, u32 method_arg, u8 level);
+#endif
 
 static size_t my_strnlen(char *str, size_t max_len);
 
@@ -164,6 +233,10 @@ s32 MIOS32_OSC_Init(u32 mode)
   if( mode > 0 )
     return -1; // only mode 0 supported yet
 
+#if MIOS32_OSC_SEARCH_HASH_SIZE
+  MIOS32_OSC_CompileReset();
+#endif
+
   return 0; // no error
 }
 
@@ -476,6 +549,54 @@ u8 *MIOS32_OSC_PutMIDI(u8 *buffer, mios32_midi_package_t p)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+//! Compiles a search tree into a hash table, so that MIOS32_OSC_ParsePacket()
+//! finds the nodes of address parts without wildcards with a single lookup
+//! instead of comparing the address with each node of the path levels.
+//!
+//! Should be called once during initialisation (e.g. in APP_Init()) with the
+//! same search tree which is passed to MIOS32_OSC_ParsePacket() later.
+//! The search tree itself isn't changed (it can still be located in flash).
+//! Arrays which are referenced by multiple nodes (e.g. the same methods for
+//! 16 MIDI channels) are compiled only once.
+//!
+//! Address parts with wildcards are handled as before: such nodes of the
+//! search tree are checked for each incoming address part, and incoming
+//! address parts with wildcards are compared with all nodes of a level.
+//!
+//! The table sizes are configured with MIOS32_OSC_SEARCH_HASH_SIZE,
+//! MIOS32_OSC_SEARCH_MAX_LEVELS and MIOS32_OSC_SEARCH_MAX_PATTERNS.
+//! If the search tree doesn't fit, all compiled trees are discarded and
+//! MIOS32_OSC_ParsePacket() searches without hash table (slower, but same result)
+//!
+//! \param[in] search_tree a tree which defines address parts and methods to be called
+//! \return 0 if search tree has been compiled
+//! \return -1 if the compiler is disabled (MIOS32_OSC_SEARCH_HASH_SIZE == 0)
+//! \return -2 if the hash table is full
+//! \return -3 if MIOS32_OSC_SEARCH_MAX_LEVELS has been exceeded
+//! \return -4 if MIOS32_OSC_SEARCH_MAX_PATTERNS has been exceeded
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_OSC_CompileSearchTree(const mios32_osc_search_tree_t *search_tree)
+{
+#if MIOS32_OSC_SEARCH_HASH_SIZE
+  s32 level = MIOS32_OSC_CompileLevel(search_tree, 0);
+
+  if( level < 0 ) {
+    // tables could be partly filled: discard all compiled trees
+    MIOS32_OSC_CompileReset();
+    return level;
+  }
+
+  // this tree can be used by MIOS32_OSC_ParsePacket() now
+  search_level[level].is_root = 1;
+
+  return 0; // no error
+#else
+  return -1; // compiler disabled
+#endif
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 //! Parses an incoming OSC packet and calls OSC methods defined in search_tree
 //! on matching addresses
@@ -493,48 +614,97 @@ s32 MIOS32_OSC_ParsePacket(u8 *packet, u32 len, const mios32_osc_search_tree_t *
   // store osc arguments (and more...) into osc_args variable
   mios32_osc_args_t osc_args;
 
+  // search tree compiled?
+  s32 level = -1;
+#if MIOS32_OSC_SEARCH_HASH_SIZE
+  {
+    int i;
+    for(i=0; i<num_search_levels; ++i) {
+      if( search_level[i].tree == search_tree && search_level[i].is_root ) {
+	level = i;
+	break;
+      }
+    }
+  }
+#endif
+
   // check if we got a bundle
-  if( strncmp((char *)packet, "#bundle", len) == 0 ) {
-    u32 pos = 8;
+  if( MIOS32_OSC_IsBundle(packet, len) ) {
+    return MIOS32_OSC_ParseBundle(packet, len, &osc_args, search_tree, level, 0);
+  } else {
+    // no timetag
+    osc_args.timetag.seconds = 0;
+    osc_args.timetag.fraction = 1;
 
-    // we expect at least 8 bytes for the timetag
-    if( (pos+8) > len )
-      return -1; // invalid format
+    s32 status = MIOS32_OSC_SearchElement(packet, len, &osc_args, search_tree, level);
+    if( status < 0 )
+      return status;
+  }
 
+  return 0; // no error
+}
 
-    // get timetag
-    osc_args.timetag = MIOS32_OSC_GetTimetag((u8 *)packet+pos);
-    pos += 8;
 
-    // parse elements
-    while( (pos+4) <= len ) {
-      // get element size
-      u32 elem_size = MIOS32_OSC_GetWord((u8 *)(packet+pos));
-      pos += 4;
+/////////////////////////////////////////////////////////////////////////////
+// Internal function:
+// returns 1 if the packet (or bundle element) contains a bundle
+/////////////////////////////////////////////////////////////////////////////
+static u8 MIOS32_OSC_IsBundle(u8 *packet, u32 len)
+{
+  return len >= 8 && memcmp(packet, "#bundle", 8) == 0; // including \0 terminator
+}
 
-      // invalid packet if elem_size exceeds packet length
-      if( (pos+elem_size) > len )
-	return -1; // invalid packet
 
-      // parse element if size > 0
-      if( elem_size ) {
-	s32 status = MIOS32_OSC_SearchElement((u8 *)(packet+pos), elem_size, &osc_args, search_tree);
-	if( status < 0 )
-	  return status;
+/////////////////////////////////////////////////////////////////////////////
+// Internal function:
+// parses the elements of a bundle (directly in the packet buffer)
+// bundles can be nested, each bundle element gets the timetag of its bundle
+// returns -1 if bundle format invalid
+// returns -3 if MIOS32_OSC_MAX_BUNDLE_NESTING has been exceeded
+// and the error codes of MIOS32_OSC_SearchElement()
+/////////////////////////////////////////////////////////////////////////////
+static s32 MIOS32_OSC_ParseBundle(u8 *packet, u32 len, mios32_osc_args_t *osc_args, const mios32_osc_search_tree_t *search_tree, s32 level, u8 nesting)
+{
+  u32 pos = 8;
+
+  if( nesting >= MIOS32_OSC_MAX_BUNDLE_NESTING )
+    return -3; // unsupported format
+
+  // we expect at least 8 bytes for the timetag
+  if( (pos+8) > len )
+    return -1; // invalid format
+
+  // get timetag
+  mios32_osc_timetag_t timetag = MIOS32_OSC_GetTimetag((u8 *)packet+pos);
+  pos += 8;
+
+  // parse elements
+  while( (pos+4) <= len ) {
+    // get element size
+    u32 elem_size = MIOS32_OSC_GetWord((u8 *)(packet+pos));
+    pos += 4;
+
+    // invalid packet if elem_size exceeds packet length
+    if( (pos+elem_size) > len )
+      return -1; // invalid packet
+
+    // parse element if size > 0
+    if( elem_size ) {
+      s32 status;
+
+      if( MIOS32_OSC_IsBundle((u8 *)(packet+pos), elem_size) ) {
+	status = MIOS32_OSC_ParseBundle((u8 *)(packet+pos), elem_size, osc_args, search_tree, level, nesting+1);
+      } else {
+	osc_args->timetag = timetag; // could have been overwritten by a nested bundle
+	status = MIOS32_OSC_SearchElement((u8 *)(packet+pos), elem_size, osc_args, search_tree, level);
       }
 
-      // switch to next element
-      pos += elem_size;
+      if( status < 0 )
+	return status;
     }
-    
-  } else {
-    // no timetag
-    osc_args.timetag.seconds = 0;
-    osc_args.timetag.fraction = 1;
 
-    s32 status = MIOS32_OSC_SearchElement(packet, len, &osc_args, search_tree);
-    if( status < 0 )
-      return status;
+    // switch to next element
+    pos += elem_size;
   }
 
   return 0; // no error
@@ -548,7 +718,7 @@ s32 MIOS32_OSC_ParsePacket(u8 *packet, u32 len, const mios32_osc_search_tree_t *
 // returns -3 if element contains an unsupported format
 // returns -4 if MIOS32_OSC_MAX_PATH_PARTS has been exceeded
 /////////////////////////////////////////////////////////////////////////////
-static s32 MIOS32_OSC_SearchElement(u8 *buffer, u32 len, mios32_osc_args_t *osc_args, const mios32_osc_search_tree_t *search_tree)
+static s32 MIOS32_OSC_SearchElement(u8 *buffer, u32 len, mios32_osc_args_t *osc_args, const mios32_osc_search_tree_t *search_tree, s32 level)
 {
   // exit immediately if element is empty
   if( !len )
@@ -677,6 +847,10 @@ static s32 MIOS32_OSC_SearchElement(u8 *buffer, u32 len, mios32_osc_args_t *osc_
 
   // finally parse for elements which are matching the OSC address
   osc_args->num_path_parts = 0;
+#if MIOS32_OSC_SEARCH_HASH_SIZE
+  if( level >= 0 )
+    return MIOS32_OSC_SearchPathCompiled((char *)&path[1], osc_args, 0x00000000, level);
+#endif
   return MIOS32_OSC_SearchPath((char *)&path[1], osc_args, 0x00000000, search_tree);
 }
 
@@ -691,70 +865,516 @@ static s32 MIOS32_OSC_SearchPath(char *path, mios32_osc_args_t *osc_args, u32 me
   if( osc_args->num_path_parts >= MIOS32_OSC_MAX_PATH_PARTS )
     return -4; // maximum number of path parts exceeded
 
+  // determine length of the address part, and check for wildcards
+  size_t sep_pos = 0;
+  u8 wildcard = 0;
+  for(; path[sep_pos] != 0 && path[sep_pos] != '/'; ++sep_pos) {
+    if( MIOS32_OSC_IS_WILDCARD(path[sep_pos]) )
+      wildcard = 1;
+  }
+  char *next_path = path[sep_pos] ? &path[sep_pos+1] : NULL;
+
   while( search_tree->address != NULL ) {
     // compare OSC address with name of tree item
-    u8 match = 1;
-    u8 wildcard = 0;
+    if( MIOS32_OSC_MatchAddressPart(path, sep_pos, wildcard, search_tree->address) ) {
+      s32 status = MIOS32_OSC_SearchNode(next_path, osc_args, method_arg, search_tree, MIOS32_OSC_SEARCH_NO_LEVEL);
+      if( status < 0 )
+	return status;
+    }
+
+    ++search_tree;
+  }
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Internal function:
+// adds the address part of a matching node to osc_args, and calls its method
+// or continues the search in the next hierarchy level
+// returns -4 if MIOS32_OSC_MAX_PATH_PARTS has been exceeded
+/////////////////////////////////////////////////////////////////////////////
+static s32 MIOS32_OSC_SearchNode(char *next_path, mios32_osc_args_t *osc_args, u32 method_arg, const mios32_osc_search_tree_t *node, u8 next_level)
+{
+  // store number of path parts in local variable, since content of osc_args is changed recursively
+  // we don't want to copy the whole structure to save (a lot of...) memory
+  u8 num_path_parts = osc_args->num_path_parts;
+  // add pointer to path part
+  osc_args->path_part[num_path_parts] = (char *)node->address;
+  osc_args->num_path_parts = num_path_parts + 1;
+
+  // OR method args of current node to the args to propagate optional parameters
+  u32 combined_method_arg = method_arg | node->method_arg;
+
+  if( node->osc_method ) {
+    s32 (*osc_method)(mios32_osc_args_t *osc_args, u32 method_arg) = node->osc_method;
+    osc_method(osc_args, combined_method_arg);
+  } else if( node->next && next_path ) {
+    // continue search in next hierarchy level
+    s32 status;
+#if MIOS32_OSC_SEARCH_HASH_SIZE
+    if( next_level != MIOS32_OSC_SEARCH_NO_LEVEL )
+      status = MIOS32_OSC_SearchPathCompiled(next_path, osc_args, combined_method_arg, next_level);
+    else
+#endif
+      status = MIOS32_OSC_SearchPath(next_path, osc_args, combined_method_arg, node->next);
+    if( status < 0 )
+      return status;
+  }
+
+  // restore number of path parts (which has been changed recursively)
+  osc_args->num_path_parts = num_path_parts;
 
-    char *str1 = path;
-    char *str2 = (char *)search_tree->address;
-    size_t sep_pos = 0;
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Internal function:
+// checks if an address part of the incoming path matches with the address of a node
+// wildcards can be part of the incoming address, or of the node address
+/////////////////////////////////////////////////////////////////////////////
+static u8 MIOS32_OSC_MatchAddressPart(const char *part, size_t part_len, u8 part_wildcard, const char *address)
+{
+  if( !part_wildcard ) {
+    // compare until the first different character
+    size_t pos;
+    for(pos=0; pos<part_len && address[pos] == part[pos]; ++pos);
 
-    while( *str1 != 0 && *str1 != '/' ) {
-      if( *str1 == '*' || *str2 == '*' ) {
-	// '*' wildcard: continue to end of address part
-	while( *str1 != 0 && *str1 != '/' ) {
-	  ++sep_pos;
-	  ++str1;
+    if( pos == part_len && address[pos] == 0 )
+      return 1; // identical
+
+    // the address can only match if it contains a wildcard at this position
+    // (characters in front of the first wildcard have to be identical)
+    if( MIOS32_OSC_IS_WILDCARD(address[pos]) )
+      return MIOS32_OSC_MatchPattern(address, address+strlen(address), part, part+part_len);
+
+    return 0;
+  }
+
+  size_t address_len = strlen(address);
+  if( MIOS32_OSC_MatchPattern(part, part+part_len, address, address+address_len) )
+    return 1;
+
+  // both with wildcards?
+  const char *str;
+  for(str=address; *str != 0; ++str) {
+    if( MIOS32_OSC_IS_WILDCARD(*str) )
+      return MIOS32_OSC_MatchPattern(address, address+address_len, part, part+part_len);
+  }
+
+  return 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Internal function:
+// matches a string against an OSC address pattern (OSC Spec v1.0):
+// '?' any single character, '*' any sequence of zero or more characters,
+// "[a-z]" / "[!a-z]" any (or none) of the listed characters or ranges,
+// "{foo,bar}" any of the comma separated strings
+// Strings are not zero terminated, the end pointers are passed instead.
+//
+// The pattern can be part of a received packet, therefore the matching
+// time has to be bounded: the pattern is converted into a list of tokens,
+// which are evaluated as a state machine with one state per token (all
+// possible positions in the pattern are tracked in parallel while the
+// string is scanned once). This needs no recursion or backtracking, the
+// time is proportional to pattern length * string length.
+// Patterns and strings which exceed MIOS32_OSC_MAX_PATTERN_LEN, patterns with
+// more than MIOS32_OSC_MAX_PATTERN_WILDCARDS wildcards or more than
+// MIOS32_OSC_MAX_PATTERN_ALTERNATIVES alternatives, nested or empty
+// alternatives never match.
+/////////////////////////////////////////////////////////////////////////////
+
+// token types
+#define MATCH_TOKEN_CHAR    0 // a single character
+#define MATCH_TOKEN_ANY     1 // '?'
+#define MATCH_TOKEN_STAR    2 // '*'
+#define MATCH_TOKEN_CLASS   3 // "[...]", next: position behind ']'
+#define MATCH_TOKEN_GROUP   4 // '{', next: position of '}'
+#define MATCH_TOKEN_ALT_END 5 // ',' or '}' of a group, next: position behind '}'
+
+// one state per pattern position + the final state
+#define MATCH_STATE_WORDS ((MIOS32_OSC_MAX_PATTERN_LEN+1+31) / 32)
+#define MATCH_STATE_GET(states, pos) ((states)[(pos) / 32] & (1UL << ((pos) % 32)))
+#define MATCH_STATE_SET(states, pos) ((states)[(pos) / 32] |= (1UL << ((pos) % 32)))
+
+static u8 MIOS32_OSC_MatchPattern(const char *pattern, const char *pattern_end, const char *str, const char *str_end)
+{
+  int pattern_len = pattern_end - pattern;
+  if( pattern_len > MIOS32_OSC_MAX_PATTERN_LEN || (str_end - str) > MIOS32_OSC_MAX_PATTERN_LEN )
+    return 0; // too long
+
+  // tokenize the pattern and check the syntax
+  u8 token[MIOS32_OSC_MAX_PATTERN_LEN];
+  u8 next[MIOS32_OSC_MAX_PATTERN_LEN];
+  {
+    int num_wildcards = 0;
+    int num_alternatives = 0;
+    int group = -1; // position of the '{' of the current group
+    int pos;
+    for(pos=0; pos<pattern_len; ++pos) {
+      char c = pattern[pos];
+
+      if( group >= 0 ) {
+	// inside a group: all characters except for ',' and '}' are taken literally
+	if( c == ',' || c == '}' ) {
+	  if( pattern[pos-1] == '{' || pattern[pos-1] == ',' )
+	    return 0; // empty alternative
+	  if( ++num_alternatives > MIOS32_OSC_MAX_PATTERN_ALTERNATIVES )
+	    return 0; // too many alternatives
+	  token[pos] = MATCH_TOKEN_ALT_END;
+	  if( c == '}' ) {
+	    // now we know the end of the group
+	    next[group] = pos;
+	    int i;
+	    for(i=group+1; i<=pos; ++i)
+	      if( token[i] == MATCH_TOKEN_ALT_END )
+		next[i] = pos + 1;
+	    group = -1;
+	  }
+	} else if( c == '{' ) {
+	  return 0; // nested groups not supported
+	} else {
+	  token[pos] = MATCH_TOKEN_CHAR;
 	}
-	wildcard = 1;
+	continue;
+      }
+
+      if( MIOS32_OSC_IS_WILDCARD(c) && ++num_wildcards > MIOS32_OSC_MAX_PATTERN_WILDCARDS )
+	return 0; // too many wildcards
+
+      switch( c ) {
+      case '?':
+	token[pos] = MATCH_TOKEN_ANY;
 	break;
-      } else {
-	// no wildcard: check for matching characters
-	++sep_pos;
-	if( *str2 == 0 || (*str2 != *str1 && *str1 != '?' && *str2 != '?') ) {
-	  match = 0;
-	  break;
+
+      case '*':
+	token[pos] = MATCH_TOKEN_STAR;
+	break;
+
+      case '[': {
+	token[pos] = MATCH_TOKEN_CLASS;
+	int close;
+	for(close=pos+1; close<pattern_len && pattern[close] != ']'; ++close);
+	if( close >= pattern_len )
+	  return 0; // missing ']'
+	next[pos] = close + 1;
+
+	// the characters of the class are only evaluated by the '[' token,
+	// these positions are never reached by a transition
+	for(++pos; pos<=close; ++pos)
+	  token[pos] = MATCH_TOKEN_CHAR;
+	pos = close; // continue behind ']'
+      } break;
+
+      case '{':
+	token[pos] = MATCH_TOKEN_GROUP;
+	group = pos;
+	break;
+
+      default:
+	token[pos] = MATCH_TOKEN_CHAR;
+      }
+    }
+
+    if( group >= 0 )
+      return 0; // missing '}'
+  }
+
+  // scan the string, the states are the pattern positions which can be reached
+  u32 states[MATCH_STATE_WORDS];
+  u32 next_states[MATCH_STATE_WORDS];
+  int i, pos;
+
+  for(i=0; i<MATCH_STATE_WORDS; ++i)
+    states[i] = 0;
+  MATCH_STATE_SET(states, 0);
+
+  while( 1 ) {
+    // follow the transitions which don't consume a character
+    // (they always point forward, so that a single pass is sufficient)
+    u8 any_state = 0;
+    for(pos=0; pos<pattern_len; ++pos) {
+      if( !MATCH_STATE_GET(states, pos) )
+	continue;
+      any_state = 1;
+
+      switch( token[pos] ) {
+      case MATCH_TOKEN_STAR:
+	MATCH_STATE_SET(states, pos+1); // '*' matches an empty string
+	break;
+
+      case MATCH_TOKEN_GROUP: {
+	// continue at the beginning of all alternatives
+	MATCH_STATE_SET(states, pos+1);
+	for(i=pos+1; i<next[pos]; ++i)
+	  if( token[i] == MATCH_TOKEN_ALT_END )
+	    MATCH_STATE_SET(states, i+1);
+      } break;
+
+      case MATCH_TOKEN_ALT_END:
+	MATCH_STATE_SET(states, next[pos]); // alternative completed
+	break;
+      }
+    }
+
+    if( str >= str_end )
+      return MATCH_STATE_GET(states, pattern_len) ? 1 : 0;
+
+    if( !any_state )
+      return 0; // no position left which could match
+
+    // consume the next character
+    char c = *str++;
+    for(i=0; i<MATCH_STATE_WORDS; ++i)
+      next_states[i] = 0;
+
+    for(pos=0; pos<pattern_len; ++pos) {
+      if( !MATCH_STATE_GET(states, pos) )
+	continue;
+
+      switch( token[pos] ) {
+      case MATCH_TOKEN_CHAR:
+	if( c == pattern[pos] )
+	  MATCH_STATE_SET(next_states, pos+1);
+	break;
+
+      case MATCH_TOKEN_ANY:
+	MATCH_STATE_SET(next_states, pos+1);
+	break;
+
+      case MATCH_TOKEN_STAR:
+	MATCH_STATE_SET(next_states, pos); // '*' takes the character and stays active
+	break;
+
+      case MATCH_TOKEN_CLASS: {
+	const char *p = &pattern[pos+1];
+	const char *class_end = &pattern[next[pos]-1]; // position of ']'
+	u8 negate = 0;
+	if( p < class_end && *p == '!' ) {
+	  negate = 1;
+	  ++p;
+	}
+
+	u8 found = 0;
+	while( p < class_end ) {
+	  if( (p+2) < class_end && p[1] == '-' ) {
+	    // range
+	    char lower = (p[0] < p[2]) ? p[0] : p[2];
+	    char upper = (p[0] < p[2]) ? p[2] : p[0];
+	    if( c >= lower && c <= upper )
+	      found = 1;
+	    p += 3;
+	  } else {
+	    if( c == *p )
+	      found = 1;
+	    ++p;
+	  }
 	}
-	++str1;
-	++str2;
+
+	if( found != negate )
+	  MATCH_STATE_SET(next_states, next[pos]);
+      } break;
       }
     }
-    
-    if( !wildcard && *str2 != 0 ) // we haven't parsed the complete string
-      match = 0;
-
-    if( match ) {
-      // store number of path parts in local variable, since content of osc_args is changed recursively
-      // we don't want to copy the whole structure to save (a lot of...) memory
-      u8 num_path_parts = osc_args->num_path_parts;
-      // add pointer to path part
-      osc_args->path_part[num_path_parts] = (char *)search_tree->address;
-      osc_args->num_path_parts = num_path_parts + 1;
-
-      // OR method args of current node to the args to propagate optional parameters
-      u32 combined_method_arg = method_arg | search_tree->method_arg;
-
-      if( search_tree->osc_method ) {
-	s32 (*osc_method)(mios32_osc_args_t *osc_args, u32 method_arg) = search_tree->osc_method;
-	osc_method(osc_args, combined_method_arg);
-      } else if( search_tree->next ) {
-
-	// continue search in next hierarchy level
-	s32 status = MIOS32_OSC_SearchPath((char *)&path[sep_pos+1], osc_args, combined_method_arg, search_tree->next);
-	if( status < 0 )
-	  return status;
+
+    for(i=0; i<MATCH_STATE_WORDS; ++i)
+      states[i] = next_states[i];
+  }
+}
+
+
+#if MIOS32_OSC_SEARCH_HASH_SIZE
+/////////////////////////////////////////////////////////////////////////////
+// Internal function:
+// hash of an address part (FNV-1a), the level is part of the key
+/////////////////////////////////////////////////////////////////////////////
+static u32 MIOS32_OSC_SearchHash(u8 level, const char *part, size_t part_len)
+{
+  u32 hash = 2166136261U ^ level;
+  size_t i;
+
+  for(i=0; i<part_len; ++i) {
+    hash ^= (u8)part[i];
+    hash *= 16777619U;
+  }
+
+  return hash;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Internal function:
+// discards all compiled search trees
+/////////////////////////////////////////////////////////////////////////////
+static void MIOS32_OSC_CompileReset(void)
+{
+  num_search_levels = 0;
+  num_search_patterns = 0;
+  num_search_hash_entries = 0;
+  memset(search_hash, 0, sizeof(search_hash));
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Internal function:
+// compiles a search tree array (and the arrays of the next hierarchy levels)
+// returns the level number, or < 0 on errors (see MIOS32_OSC_CompileSearchTree())
+/////////////////////////////////////////////////////////////////////////////
+static s32 MIOS32_OSC_CompileLevel(const mios32_osc_search_tree_t *search_tree, u8 depth)
+{
+  const mios32_osc_search_tree_t *node;
+  int i;
+
+  // already compiled?
+  for(i=0; i<num_search_levels; ++i) {
+    if( search_level[i].tree == search_tree )
+      return i;
+  }
+
+  if( num_search_levels >= MIOS32_OSC_SEARCH_MAX_LEVELS )
+    return -3; // too many levels
+
+  u8 level = num_search_levels++;
+  mios32_osc_search_level_t *l = &search_level[level];
+  l->tree = search_tree;
+  l->first_pattern = num_search_patterns;
+  l->num_patterns = 0;
+  l->is_root = 0;
+
+  // add the address parts of this level
+  for(node=search_tree; node->address != NULL; ++node) {
+    mios32_osc_search_entry_t *entry;
+    size_t address_len = strlen(node->address);
+    u8 wildcard = 0;
+    const char *str;
+
+    for(str=node->address; *str != 0; ++str) {
+      if( MIOS32_OSC_IS_WILDCARD(*str) )
+	wildcard = 1;
+    }
+
+    if( wildcard ) {
+      // checked for each incoming address part (the patterns of a level are stored in tree order)
+      if( num_search_patterns >= MIOS32_OSC_SEARCH_MAX_PATTERNS )
+	return -4; // too many patterns
+
+      entry = &search_pattern[num_search_patterns++];
+      ++l->num_patterns;
+      entry->hash = 0;
+    } else {
+      // keep at least 1/4 of the hash table free, so that the probe sequence is short
+      if( num_search_hash_entries >= (MIOS32_OSC_SEARCH_HASH_SIZE*3/4) )
+	return -2; // hash table full
+
+      u32 hash = MIOS32_OSC_SearchHash(level, node->address, address_len);
+      u32 slot = hash & (MIOS32_OSC_SEARCH_HASH_SIZE-1);
+      while( search_hash[slot].node != NULL )
+	slot = (slot + 1) & (MIOS32_OSC_SEARCH_HASH_SIZE-1);
+
+      entry = &search_hash[slot];
+      ++num_search_hash_entries;
+      entry->hash = hash >> 16;
+    }
+
+    entry->level = level;
+    entry->next_level = MIOS32_OSC_SEARCH_NO_LEVEL;
+    entry->node = node;
+  }
+
+  // compile the next hierarchy levels
+  // (deeper levels than MIOS32_OSC_MAX_PATH_PARTS can't be reached anyhow)
+  if( (depth+1) < MIOS32_OSC_MAX_PATH_PARTS ) {
+    for(node=search_tree; node->address != NULL; ++node) {
+      if( node->osc_method || !node->next )
+	continue;
+
+      s32 next_level = MIOS32_OSC_CompileLevel(node->next, depth+1);
+      if( next_level < 0 )
+	return next_level;
+
+      // search the entry of this node
+      for(i=0; i<MIOS32_OSC_SEARCH_HASH_SIZE; ++i) {
+	if( search_hash[i].node == node )
+	  search_hash[i].next_level = next_level;
       }
+      for(i=0; i<l->num_patterns; ++i) {
+	if( search_pattern[l->first_pattern+i].node == node )
+	  search_pattern[l->first_pattern+i].next_level = next_level;
+      }
+    }
+  }
+
+  return level;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Internal function:
+// searches in a compiled level for matching OSC addresses
+// returns -4 if MIOS32_OSC_MAX_PATH_PARTS has been exceeded
+/////////////////////////////////////////////////////////////////////////////
+static s32 MIOS32_OSC_SearchPathCompiled(char *path, mios32_osc_args_t *osc_args, u32 method_arg, u8 level)
+{
+  const mios32_osc_search_level_t *l = &search_level[level];
+
+  if( osc_args->num_path_parts >= MIOS32_OSC_MAX_PATH_PARTS )
+    return -4; // maximum number of path parts exceeded
 
-      // restore number of path parts (which has been changed recursively)
-      osc_args->num_path_parts = num_path_parts;
+  // determine length and hash of the address part, and check for wildcards
+  u32 hash = 2166136261U ^ level;
+  size_t sep_pos = 0;
+  for(; path[sep_pos] != 0 && path[sep_pos] != '/'; ++sep_pos) {
+    if( MIOS32_OSC_IS_WILDCARD(path[sep_pos]) ) {
+      // incoming address part with wildcards: compare with all nodes of this level
+      return MIOS32_OSC_SearchPath(path, osc_args, method_arg, l->tree);
     }
 
-    ++search_tree;
+    hash ^= (u8)path[sep_pos];
+    hash *= 16777619U;
+  }
+  char *next_path = path[sep_pos] ? &path[sep_pos+1] : NULL;
+
+  // methods are called in the same order like defined in the search tree:
+  // nodes with wildcards are checked while the matching nodes are searched in the hash table
+  // (nodes with the same address are found in tree order)
+  const mios32_osc_search_entry_t *pattern = &search_pattern[l->first_pattern];
+  const mios32_osc_search_entry_t *pattern_end = pattern + l->num_patterns;
+  u16 hash_check = hash >> 16;
+  u32 slot = hash & (MIOS32_OSC_SEARCH_HASH_SIZE-1);
+  s32 status;
+
+  for(; search_hash[slot].node != NULL; slot = (slot + 1) & (MIOS32_OSC_SEARCH_HASH_SIZE-1)) {
+    const mios32_osc_search_entry_t *entry = &search_hash[slot];
+
+    if( entry->level != level || entry->hash != hash_check ||
+	strncmp(entry->node->address, path, sep_pos) != 0 || entry->node->address[sep_pos] != 0 )
+      continue;
+
+    for(; pattern < pattern_end && pattern->node < entry->node; ++pattern) {
+      if( MIOS32_OSC_MatchAddressPart(path, sep_pos, 0, pattern->node->address) ) {
+	if( (status=MIOS32_OSC_SearchNode(next_path, osc_args, method_arg, pattern->node, pattern->next_level)) < 0 )
+	  return status;
+      }
+    }
+
+    if( (status=MIOS32_OSC_SearchNode(next_path, osc_args, method_arg, entry->node, entry->next_level)) < 0 )
+      return status;
+  }
+
+  for(; pattern < pattern_end; ++pattern) {
+    if( MIOS32_OSC_MatchAddressPart(path, sep_pos, 0, pattern->node->address) ) {
+      if( (status=MIOS32_OSC_SearchNode(next_path, osc_args, method_arg, pattern->node, pattern->next_level)) < 0 )
+	return status;
+    }
   }
 
   return 0; // no error
 }
+#endif
 
 
 /////////////////////////////////////////////////////////////////////////////
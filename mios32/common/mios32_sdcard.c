@@ -18,6 +18,10 @@
 //!
 //! MIOS32_SDCARD_SectorRead/SectorWrite allow to read/write a 512 byte sector.
 //!
+//! MIOS32_SDCARD_SectorsRead/SectorsWrite transfer consecutive sectors with
+//! a single multi-block command (CMD18/CMD25), so that the command handshake
+//! and (on writes) the erase is done only once for the whole transfer.
+//!
 //! If such an access returns an error, it can be assumed that the SD Card has
 //! been disconnected during the transfer.
 //!
@@ -108,6 +112,18 @@
 #define SDCMD_WRITE_SINGLE_BLOCK (0x40+24)
 #define SDCMD_WRITE_SINGLE_BLOCK_CRC 0xff
 
+#define SDCMD_READ_MULTIPLE_BLOCK (0x40+18)
+#define SDCMD_READ_MULTIPLE_BLOCK_CRC 0xff
+
+#define SDCMD_STOP_TRANSMISSION	(0x40+12)
+#define SDCMD_STOP_TRANSMISSION_CRC 0xff
+
+#define SDCMD_WRITE_MULTIPLE_BLOCK (0x40+25)
+#define SDCMD_WRITE_MULTIPLE_BLOCK_CRC 0xff
+
+#define SDCMD_SET_WR_BLK_ERASE_COUNT (0xC0+23)
+#define SDCMD_SET_WR_BLK_ERASE_COUNT_CRC 0xff
+
 
 /* Card type flags (CardType) */
 #define CT_MMC				0x01
@@ -367,6 +383,10 @@ s32 MIOS32_SDCARD_SendSDCCmd(u8 cmd, u32 addr, u8 crc)
 
   u8 timeout = 0;
 
+  // the card sends a stuff byte after CMD12 which has to be skipped
+  if( cmd == SDCMD_STOP_TRANSMISSION )
+    MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+
   if( cmd == SDCMD_SEND_STATUS ) {
 
   // one dummy read
@@ -579,6 +599,197 @@ error:
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+//! Reads consecutive 512 byte sectors with a single multi-block command (CMD18)
+//! \param[in] sector 32bit number of the first sector
+//! \param[in] *buffer pointer to a buffer which can hold count*512 bytes
+//! \param[in] count number of sectors
+//! \return 0 if all sectors have been successfully read
+//! \return -error if error occured during read operation (see MIOS32_SDCARD_SectorRead)
+//! \return -256 if timeout during command has been sent
+//! \return -257 if timeout while waiting for start token, or error token received
+//! \return -258 if timeout while stopping the transmission
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_SDCARD_SectorsRead(u32 sector, u8 *buffer, u32 count)
+{
+  s32 status = 0;
+  int i;
+
+  if( !count )
+    return 0; // nothing to do
+  if( count == 1 )
+    return MIOS32_SDCARD_SectorRead(sector, buffer);
+
+  if (!(CardType & CT_BLOCK)) 
+	sector *= 512;
+
+  MIOS32_SDCARD_MUTEX_TAKE;
+
+  // init SPI port for fast frequency access (ca. 18 MBit/s)
+  // this is required for the case that the SPI port is shared with other devices
+  MIOS32_SPI_TransferModeInit(MIOS32_SDCARD_SPI, MIOS32_SPI_MODE_CLK1_PHASE1, MIOS32_SDCARD_SPI_PRESCALER);
+
+  if( (status=MIOS32_SDCARD_SendSDCCmd(SDCMD_READ_MULTIPLE_BLOCK, sector, SDCMD_READ_MULTIPLE_BLOCK_CRC)) ) {
+    status=(status < 0) ? -256 : status; // return timeout indicator or error flags
+    goto error;
+  }
+
+  for(; count; --count, buffer += 512) {
+    // wait for start token of the data block
+    u8 token = 0xff;
+    for(i=0; i<65536; ++i) { // TODO: check if sufficient
+      if( (token=MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff)) != 0xff )
+	break;
+    }
+    if( token != 0xfe ) {
+      status= -257;
+      break; // stop transmission
+    }
+
+    // read 512 bytes via DMA
+#ifdef MIOS32_SDCARD_TASK_SUSPEND_HOOK
+    MIOS32_SPI_TransferBlock(MIOS32_SDCARD_SPI, NULL, buffer, 512, MIOS32_SDCARD_TASK_RESUME_HOOK);
+    MIOS32_SDCARD_TASK_SUSPEND_HOOK();
+#else
+    MIOS32_SPI_TransferBlock(MIOS32_SDCARD_SPI, NULL, buffer, 512, NULL);
+#endif
+
+    // read (and ignore) CRC
+    MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+    MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+  }
+
+  // stop transmission (chip select is still active)
+  if( MIOS32_SDCARD_SendSDCCmd(SDCMD_STOP_TRANSMISSION, 0, SDCMD_STOP_TRANSMISSION_CRC) < 0 ) {
+    status= -258;
+    goto error;
+  }
+
+  // wait until card isn't busy anymore
+  for(i=0; i<65536; ++i) {
+    if( MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff) == 0xff )
+      break;
+  }
+  if( i == 65536 && !status )
+    status= -258;
+
+error:
+  // deactivate chip select
+  MIOS32_SPI_RC_PinSet(MIOS32_SDCARD_SPI, MIOS32_SDCARD_SPI_RC_PIN, 1); // spi, rc_pin, pin_value
+
+  // Send dummy byte once deactivated to drop cards DO
+  MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+  MIOS32_SDCARD_MUTEX_GIVE;
+  return status; 
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Writes consecutive 512 byte sectors with a single multi-block command (CMD25)
+//!
+//! SD Cards are notified about the number of sectors before (ACMD23), so
+//! that they can pre-erase the blocks.
+//! \param[in] sector 32bit number of the first sector
+//! \param[in] *buffer pointer to count*512 bytes
+//! \param[in] count number of sectors
+//! \return 0 if all sectors have been successfully written
+//! \return -error if error occured during write operation (see MIOS32_SDCARD_SectorWrite)
+//! \return -256 if timeout during command has been sent
+//! \return -257 if write operation not accepted
+//! \return -258 if timeout during write operation
+/////////////////////////////////////////////////////////////////////////////
+s32 MIOS32_SDCARD_SectorsWrite(u32 sector, u8 *buffer, u32 count)
+{
+  s32 status = 0;
+  int i;
+
+  if( !count )
+    return 0; // nothing to do
+  if( count == 1 )
+    return MIOS32_SDCARD_SectorWrite(sector, buffer);
+
+  MIOS32_SDCARD_MUTEX_TAKE;
+
+  if (!(CardType & CT_BLOCK))
+	sector *= 512;
+
+  // init SPI port for fast frequency access (ca. 18 MBit/s)
+  // this is required for the case that the SPI port is shared with other devices
+  MIOS32_SPI_TransferModeInit(MIOS32_SDCARD_SPI, MIOS32_SPI_MODE_CLK1_PHASE1, MIOS32_SDCARD_SPI_PRESCALER);
+
+  // pre-erase (only supported by SD Cards, the response can be ignored)
+  if( CardType & CT_SDC ) {
+    if( MIOS32_SDCARD_SendSDCCmd(SDCMD_SET_WR_BLK_ERASE_COUNT, count, SDCMD_SET_WR_BLK_ERASE_COUNT_CRC) < 0 ) {
+      status= -256;
+      goto error;
+    }
+  }
+
+  if( (status=MIOS32_SDCARD_SendSDCCmd(SDCMD_WRITE_MULTIPLE_BLOCK, sector, SDCMD_WRITE_MULTIPLE_BLOCK_CRC)) ) {
+    status=(status < 0) ? -256 : status; // return timeout indicator or error flags
+    goto error;
+  }
+
+  for(; count; --count, buffer += 512) {
+    // send start token of multi-block write
+    MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xfc);
+
+    // send 512 bytes of data via DMA
+#ifdef MIOS32_SDCARD_TASK_SUSPEND_HOOK
+    MIOS32_SPI_TransferBlock(MIOS32_SDCARD_SPI, buffer, NULL, 512, MIOS32_SDCARD_TASK_RESUME_HOOK);
+    MIOS32_SDCARD_TASK_SUSPEND_HOOK();
+#else
+    MIOS32_SPI_TransferBlock(MIOS32_SDCARD_SPI, buffer, NULL, 512, NULL);
+#endif
+
+    // send CRC
+    MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+    MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+
+    // read response
+    u8 response = MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+    if( (response & 0x0f) != 0x5 ) {
+      status= -257;
+      break; // stop transmission
+    }
+
+    // wait for write completion
+    for(i=0; i<32*65536; ++i) { // TODO: check if sufficient
+      if( MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff) != 0x00 )
+	break;
+    }
+    if( i == 32*65536 ) {
+      status= -258;
+      goto error;
+    }
+  }
+
+  // send stop token
+  MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xfd);
+
+  // required for clocking (see spec)
+  MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+
+  // wait for completion of the programming
+  for(i=0; i<32*65536; ++i) { // TODO: check if sufficient
+    if( MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff) != 0x00 )
+      break;
+  }
+  if( i == 32*65536 && !status )
+    status= -258;
+
+error:
+  // deactivate chip select
+  MIOS32_SPI_RC_PinSet(MIOS32_SDCARD_SPI, MIOS32_SDCARD_SPI_RC_PIN, 1); // spi, rc_pin, pin_value
+  // Send dummy byte once deactivated to drop cards DO
+  MIOS32_SPI_TransferByte(MIOS32_SDCARD_SPI, 0xff);
+
+  MIOS32_SDCARD_MUTEX_GIVE;
+
+  return status;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 //! Reads the CID informations from SD Card
 //! \param[in] *cid pointer to buffer which holds the CID informations
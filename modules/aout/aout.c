@@ -40,6 +40,13 @@
 //!
 //! (**) currently only supported for MBHP_AOUT, since MAX525 provides such a digital output pin
 //!
+//! AOUT_UpdateDMA() can be used instead of AOUT_Update() if the outputs are
+//! updated at a high rate (e.g. from a timer interrupt). The DAC words are
+//! prepared in a buffer and sent via SPI DMA in background, chip select
+//! and RC pulses are handled by the DMA callback. Digital pin changes are
+//! sent as an additional word group of the same transfer, so that the
+//! function never waits for SPI transfers.
+//!
 //!
 //! Supported interface types:
 //! <UL>
@@ -238,6 +245,15 @@ static u16 cali_wave_value;
 
 static u8 suspend_mode;
 
+// for AOUT_UpdateDMA(): max. 8 channel groups (TLV5630), each with aout_num_devices words
+// + one group for the digital pins of MAX525 devices
+#define AOUT_DMA_BUFFER_SIZE (2*(AOUT_NUM_CHANNELS+7) + 2*((AOUT_NUM_CHANNELS+3)/4))
+static u8 aout_dma_buffer[AOUT_DMA_BUFFER_SIZE];
+static u8 aout_dma_group_len;
+static u8 aout_dma_num_groups;
+static volatile u8 aout_dma_group;
+static volatile u8 aout_dma_busy;
+
 // include generate file which declares hz_v_table[128]
 #include "aout_hz_v_table.inc"
 
@@ -247,6 +263,8 @@ static u8 suspend_mode;
 /////////////////////////////////////////////////////////////////////////////
 
 static u16 caliValue(u8 pin);
+static void updateSlewRates(void);
+static void AOUT_DMA_Callback(void);
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -1170,6 +1188,7 @@ u16 *AOUT_CaliPointsPtrGet(u8 cv)
 //! Should be called, whenever changes have been requested via AOUT_Pin*Set
 //! or AOUT_DigitalPin*Set
 //! \return < 0 on errors
+//! \return -5 if an AOUT_UpdateDMA() transfer is in progress
 /////////////////////////////////////////////////////////////////////////////
 s32 AOUT_Update(void)
 {
@@ -1181,32 +1200,11 @@ s32 AOUT_Update(void)
   if( suspend_mode )
     return 0; // ignore in suspend mode
 
-  // handle slew rate
-  aout_channel_t *c = (aout_channel_t *)&aout_channel[0];
-  int pin;
-  for(pin=0; pin<AOUT_NUM_CHANNELS; ++pin, ++c) {
-    MIOS32_IRQ_Disable();
-    s32 inc = c->incrementer;
-    if( inc ) {
-      s32 new_value = c->value + inc;
-      if( (inc > 0 && new_value >= c->target_value) ||
-	  (inc < 0 && new_value <= c->target_value) ) {
-	new_value = c->target_value;
-	c->incrementer = 0;
-      }
-      c->value = new_value;
-      aout_update_req |= 1 << pin;
-    }
-    MIOS32_IRQ_Enable();
-  }
+  if( aout_dma_busy )
+    return -5; // AOUT_UpdateDMA() transfer in progress, requests will be sent with next call
 
-  // cali wave
-  if( cali_mode == AOUT_CALI_MODE_WAVE ) {
-    MIOS32_IRQ_Disable();
-    cali_wave_value += 256;
-    aout_update_req |= 1 << cali_pin;
-    MIOS32_IRQ_Enable();
-  }
+  // handle slew rate and cali wave
+  updateSlewRates();
 
   // check for AOUT channel update requests
   MIOS32_IRQ_Disable();
@@ -1441,6 +1439,251 @@ s32 AOUT_Update(void)
 
 
 
+/////////////////////////////////////////////////////////////////////////////
+//! Updates the output channels like AOUT_Update(), but the SPI transfer is
+//! done via DMA in background, so that the function returns immediately.
+//!
+//! Intended for high update rates, e.g. if the outputs are updated from a
+//! timer interrupt. If the previous transfer hasn't been finished yet, the
+//! requests are kept and will be sent with the next call.
+//!
+//! Changes of digital pins (MAX525) are appended to the DMA transfer.
+//! The AOUT_IF_INTDAC interface is handled by AOUT_Update(), it doesn't
+//! use SPI and therefore doesn't block.
+//!
+//! The CPU load of the calling interrupt is only the preparation of the DAC
+//! words (a loop over the requested channels), it doesn't depend on the SPI
+//! transfer time anymore.
+//! \return < 0 on errors
+//! \return -5 if the previous transfer is still in progress
+/////////////////////////////////////////////////////////////////////////////
+s32 AOUT_UpdateDMA(void)
+{
+  if( !aout_num_devices )
+    return -1; // no device available
+
+  if( suspend_mode )
+    return 0; // ignore in suspend mode
+
+  if( aout_dma_busy )
+    return -5; // transfer in progress
+
+  switch( aout_config.if_type ) {
+    case AOUT_IF_MAX525:
+    case AOUT_IF_74HC595:
+    case AOUT_IF_TLV5630:
+    case AOUT_IF_MCP4922_1:
+    case AOUT_IF_MCP4922_2:
+      break;
+
+    default:
+      return AOUT_Update(); // no SPI based interface
+  }
+
+  // handle slew rate and cali wave
+  updateSlewRates();
+
+  // check for AOUT channel and digital pin update requests
+  MIOS32_IRQ_Disable();
+  u32 req = aout_update_req;
+  aout_update_req = 0;
+  u32 dig_req = aout_dig_update_req;
+  aout_dig_update_req = 0;
+  MIOS32_IRQ_Enable();
+
+  if( !req && !dig_req )
+    return 0; // nothing to do
+
+  // prepare the DAC words, the format is the same like in AOUT_Update()
+  u8 *buffer = aout_dma_buffer;
+  aout_dma_num_groups = 0;
+  aout_dma_group_len = 2*aout_num_devices;
+
+  switch( aout_config.if_type ) {
+    case AOUT_IF_MAX525:
+    case AOUT_IF_TLV5630: {
+      // MAX525: 4 channels per device, TLV5630: 8 channels per device
+      int num_chn = (aout_config.if_type == AOUT_IF_MAX525) ? 4 : 8;
+      u32 chn_mask = (aout_config.if_type == AOUT_IF_MAX525) ? 0x11111111 : 0x01010101;
+      int chn;
+      for(chn=0; chn<num_chn; ++chn) {
+	if( req & (chn_mask << chn) ) {
+	  // loop through devices (value of last device has to be shifted first)
+	  int dev;
+	  for(dev=aout_num_devices-1; dev>=0; --dev) {
+	    u16 dac_value = currentValueGet(num_chn*dev + chn) >> 4; // 16bit -> 12bit
+	    u16 hword;
+	    if( aout_config.if_type == AOUT_IF_MAX525 )
+	      hword = (chn << 14) | (1 << 13) | (1 << 12) | dac_value; // A[10]: channel number, C1=1, C0=1
+	    else
+	      hword = (chn << 12) | dac_value; // [15]=0, [14:12] channel number, [11:0] DAC value
+	    *buffer++ = hword >> 8;
+	    *buffer++ = hword & 0xff;
+	  }
+	  ++aout_dma_num_groups;
+	}
+      }
+
+      // digital pins are sent as additional group (only supported by MAX525)
+      if( dig_req && aout_config.if_type == AOUT_IF_MAX525 ) {
+	int dev;
+	for(dev=aout_num_devices-1; dev>=0; --dev) {
+	  // same commands like in AOUT_Update()
+	  u16 a0 = (aout_dig_value & (1 << dev)) ? 1 : 0;
+	  u16 hword = (0 << 15) | (a0 << 14) | (1 << 13) | (0 << 12);
+	  *buffer++ = hword >> 8;
+	  *buffer++ = hword & 0xff;
+	}
+	++aout_dma_num_groups;
+      }
+    } break;
+
+    case AOUT_IF_74HC595: {
+      if( !req )
+	return 0; // no digital outputs supported
+
+      // the complete chain has to be updated!
+      int dev;
+      for(dev=aout_num_devices-1; dev>=0; --dev) {
+	u8 mode = (aout_config.if_option >> (2*dev)) & 3;
+	u8 chn_ix = 2*dev;
+	u16 hword;
+
+	if( mode ) {
+	  // 8/8 configuration
+	  hword = ((currentValueGet(chn_ix+1) >> 8) << 8) | (currentValueGet(chn_ix+0) >> 8);
+	} else {
+	  // 12/4 configuration
+	  hword = ((currentValueGet(chn_ix+1) >> 12) << 12) | (currentValueGet(chn_ix+0) >> 4);
+	}
+	*buffer++ = hword >> 8;
+	*buffer++ = hword & 0xff;
+      }
+      aout_dma_num_groups = 1;
+    } break;
+
+    default: { // AOUT_IF_MCP4922_1, AOUT_IF_MCP4922_2
+      // only 1 device can be connected to a CS line, and only 2 channels available
+      int chn;
+      for(chn=0; chn<2; ++chn) {
+	if( req & (1 << chn) ) {
+	  u16 dac_value = currentValueGet(chn) >> 4; // 16bit -> 12bit
+	  u16 hword = (chn << 15) | (1 << 14) | (1 << 12) | dac_value;
+	  if( aout_config.if_type == AOUT_IF_MCP4922_1 ) {
+	    hword |= (1 << 13); // Gain x1
+	  }
+	  *buffer++ = hword >> 8;
+	  *buffer++ = hword & 0xff;
+	  ++aout_dma_num_groups;
+	}
+      }
+    }
+  }
+
+  if( !aout_dma_num_groups )
+    return 0; // no channel of a connected device requested
+
+  // init SPI again
+  // we will do this here, so that other handlers (e.g. AINSER) could use SPI in different modes
+  s32 status;
+  if( aout_config.if_type == AOUT_IF_74HC595 || aout_config.if_type == AOUT_IF_TLV5630 )
+    status = MIOS32_SPI_TransferModeInit(AOUT_SPI, MIOS32_SPI_MODE_CLK0_PHASE1, MIOS32_SPI_PRESCALER_16); // ca. 5 MBit
+  else
+    status = MIOS32_SPI_TransferModeInit(AOUT_SPI, MIOS32_SPI_MODE_CLK0_PHASE0, MIOS32_SPI_PRESCALER_16); // ca. 5 MBit
+
+  if( status < 0 )
+    return -4; // SPI error
+
+  // start transfer of first group, the remaining groups are sent from the DMA callback
+  aout_dma_busy = 1;
+  aout_dma_group = 0;
+  if( aout_config.if_type != AOUT_IF_74HC595 )
+    MIOS32_SPI_RC_PinSet(AOUT_SPI, AOUT_SPI_RC_PIN, 0); // spi, rc_pin, pin_value
+  if( MIOS32_SPI_TransferBlock(AOUT_SPI, aout_dma_buffer, NULL, aout_dma_group_len, AOUT_DMA_Callback) < 0 ) {
+    if( aout_config.if_type != AOUT_IF_74HC595 )
+      MIOS32_SPI_RC_PinSet(AOUT_SPI, AOUT_SPI_RC_PIN, 1); // spi, rc_pin, pin_value
+    aout_dma_busy = 0;
+    return -4; // SPI transfer error
+  }
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! \return 1 while an AOUT_UpdateDMA() transfer is in progress
+/////////////////////////////////////////////////////////////////////////////
+s32 AOUT_UpdateDMABusy(void)
+{
+  return aout_dma_busy;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// DMA callback: a channel group has been sent
+/////////////////////////////////////////////////////////////////////////////
+static void AOUT_DMA_Callback(void)
+{
+  if( aout_config.if_type == AOUT_IF_74HC595 ) {
+    // toggle RCLK pin
+    MIOS32_SPI_RC_PinSet(AOUT_SPI, AOUT_SPI_RC_PIN, 1); // spi, rc_pin, pin_value
+    MIOS32_SPI_RC_PinSet(AOUT_SPI, AOUT_SPI_RC_PIN, 0); // spi, rc_pin, pin_value
+  } else {
+    // deactivate chip select
+    MIOS32_SPI_RC_PinSet(AOUT_SPI, AOUT_SPI_RC_PIN, 1); // spi, rc_pin, pin_value
+    if( aout_config.if_type == AOUT_IF_TLV5630 )
+      MIOS32_DELAY_Wait_uS(1); // short delay to ensure that RC will be pulsed by at least 1 uS
+  }
+
+  if( ++aout_dma_group >= aout_dma_num_groups ) {
+    aout_dma_busy = 0; // all groups sent
+    return;
+  }
+
+  // next group
+  MIOS32_SPI_RC_PinSet(AOUT_SPI, AOUT_SPI_RC_PIN, 0); // spi, rc_pin, pin_value
+  if( MIOS32_SPI_TransferBlock(AOUT_SPI, &aout_dma_buffer[aout_dma_group * aout_dma_group_len], NULL, aout_dma_group_len, AOUT_DMA_Callback) < 0 ) {
+    MIOS32_SPI_RC_PinSet(AOUT_SPI, AOUT_SPI_RC_PIN, 1); // spi, rc_pin, pin_value
+    aout_dma_busy = 0;
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// handles slew rate and cali wave, called by AOUT_Update() and AOUT_UpdateDMA()
+/////////////////////////////////////////////////////////////////////////////
+static void updateSlewRates(void)
+{
+  // handle slew rate
+  aout_channel_t *c = (aout_channel_t *)&aout_channel[0];
+  int pin;
+  for(pin=0; pin<AOUT_NUM_CHANNELS; ++pin, ++c) {
+    MIOS32_IRQ_Disable();
+    s32 inc = c->incrementer;
+    if( inc ) {
+      s32 new_value = c->value + inc;
+      if( (inc > 0 && new_value >= c->target_value) ||
+	  (inc < 0 && new_value <= c->target_value) ) {
+	new_value = c->target_value;
+	c->incrementer = 0;
+      }
+      c->value = new_value;
+      aout_update_req |= 1 << pin;
+    }
+    MIOS32_IRQ_Enable();
+  }
+
+  // cali wave
+  if( cali_mode == AOUT_CALI_MODE_WAVE ) {
+    MIOS32_IRQ_Disable();
+    cali_wave_value += 256;
+    aout_update_req |= 1 << cali_pin;
+    MIOS32_IRQ_Enable();
+  }
+}
+
+
+
 /////////////////////////////////////////////////////////////////////////////
 // help function which tests an AOUT pin
 /////////////////////////////////////////////////////////////////////////////
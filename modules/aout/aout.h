@@ -162,6 +162,8 @@ extern s32 AOUT_CaliCfgValueSet(u16 value);
 extern u16 AOUT_CaliCfgValueGet(void);
 
 extern s32 AOUT_Update(void);
+extern s32 AOUT_UpdateDMA(void);
+extern s32 AOUT_UpdateDMABusy(void);
 
 extern s32 AOUT_TerminalHelp(void *_output_function);
 extern s32 AOUT_TerminalParseLine(char *input, void *_output_function);
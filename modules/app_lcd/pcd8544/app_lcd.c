@@ -37,6 +37,14 @@
  *
  * The arrangement can be modified below the USER_LCD_Data_CS and USER_LCD_GCursorSet label
  *
+ * Optionally a framebuffer can be enabled with APP_LCD_FRAMEBUFFER in mios32_config.h:
+ * MIOS32_LCD_PrintChar() and MIOS32_LCD_BitmapPrint() only write into RAM then,
+ * and pages which have been modified are marked as dirty. The application has
+ * to call APP_LCD_Flush() periodically (e.g. at the end of the display update
+ * routine) to transfer the dirty pages.
+ * With APP_LCD_FRAMEBUFFER_SPI >= 0 the pages are sent via SPI DMA in background,
+ * so that a display update doesn't block the calling task anymore.
+ *
  *
  * ==========================================================================
  *
@@ -63,6 +71,7 @@
 /////////////////////////////////////////////////////////////////////////////
 
 #include <mios32.h>
+#include <string.h>
 
 #include <glcd_font.h>
 
@@ -79,6 +88,15 @@
 // MEMO: PCD8544 works at 3.3V, level shifting (and open drain mode) not required
 // TODO: try this out later
 
+#define APP_LCD_NUM_DISPLAYS (APP_LCD_NUM_X*APP_LCD_NUM_Y)
+#define APP_LCD_NUM_PAGES    (APP_LCD_HEIGHT/8)
+
+#if APP_LCD_FRAMEBUFFER && APP_LCD_FRAMEBUFFER_SPI >= 0
+# define APP_LCD_FLUSH_VIA_SPI 1
+#else
+# define APP_LCD_FLUSH_VIA_SPI 0
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Local variables
@@ -86,6 +104,80 @@
 
 static u32 display_available = 0;
 
+#if APP_LCD_FRAMEBUFFER
+static u8 lcd_framebuffer[APP_LCD_NUM_DISPLAYS][APP_LCD_NUM_PAGES][APP_LCD_WIDTH];
+static volatile u8 lcd_dirty_pages[APP_LCD_NUM_DISPLAYS]; // one flag per page
+
+#if APP_LCD_FLUSH_VIA_SPI
+static volatile u8 flush_busy;
+static u8 flush_display;
+static u8 flush_page;
+static u8 flush_cmd[2];
+#endif
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+#if APP_LCD_FLUSH_VIA_SPI
+static void APP_LCD_FlushNextPage(void);
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns the CS line of a display
+/////////////////////////////////////////////////////////////////////////////
+static inline u8 APP_LCD_DisplayCS(u8 display)
+{
+  // THIS PART COULD BE CHANGED TO ARRANGE THE 8 DISPLAYS ON ANOTHER WAY
+  return 3*(display / APP_LCD_NUM_X) + (display % APP_LCD_NUM_X);
+}
+
+
+#if APP_LCD_FRAMEBUFFER
+/////////////////////////////////////////////////////////////////////////////
+// Writes <len> bytes into a page of the framebuffer, starting at the
+// graphical cursor position x/y
+// Modified pages are marked as dirty
+/////////////////////////////////////////////////////////////////////////////
+static s32 APP_LCD_FramebufferWrite(u16 x, u16 y, u8 *data, u16 len)
+{
+  u16 line = y / APP_LCD_HEIGHT;
+  if( line >= APP_LCD_NUM_Y )
+    return -1; // outside the framebuffer
+
+  u8 page = (y % APP_LCD_HEIGHT) / 8;
+  while( len && x < APP_LCD_NUM_X*APP_LCD_WIDTH ) {
+    // bytes which are written into the same display
+    u8 display = line*APP_LCD_NUM_X + (x / APP_LCD_WIDTH);
+    u8 *ptr = &lcd_framebuffer[display][page][x % APP_LCD_WIDTH];
+    u16 segment_len = APP_LCD_WIDTH - (x % APP_LCD_WIDTH);
+    if( segment_len > len )
+      segment_len = len;
+    x += segment_len;
+    len -= segment_len;
+
+    u8 modified = 0;
+    for(; segment_len; --segment_len, ++ptr, ++data) {
+      if( *ptr != *data ) {
+	*ptr = *data;
+	modified = 1;
+      }
+    }
+
+    if( modified ) {
+      MIOS32_IRQ_Disable(); // must be atomic, flag could be cleared by DMA callback
+      lcd_dirty_pages[display] |= (1 << page);
+      MIOS32_IRQ_Enable();
+    }
+  }
+
+  return 0; // no error
+}
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Initializes application specific LCD driver
@@ -107,6 +199,12 @@ s32 APP_LCD_Init(u32 mode)
   // set LCD type
   mios32_lcd_parameters.lcd_type = MIOS32_LCD_TYPE_GLCD_CUSTOM;
 
+#if APP_LCD_FLUSH_VIA_SPI
+  // SCLK is high when idle, data is taken with the rising edge
+  MIOS32_SPI_IO_Init(APP_LCD_FRAMEBUFFER_SPI, APP_LCD_OUTPUT_MODE ? MIOS32_SPI_PIN_DRIVER_STRONG_OD : MIOS32_SPI_PIN_DRIVER_STRONG);
+  MIOS32_SPI_TransferModeInit(APP_LCD_FRAMEBUFFER_SPI, MIOS32_SPI_MODE_CLK1_PHASE1, APP_LCD_FRAMEBUFFER_SPI_PRESCALER);
+#endif
+
   // initialize LCD
 #ifdef MIOS32_DONT_USE_DELAY
   u32 delay;
@@ -121,6 +219,14 @@ s32 APP_LCD_Init(u32 mode)
   APP_LCD_Cmd(0x20); // PD=0 and V=0, select normal instruction set (H=1 mode)
   APP_LCD_Cmd(0x0c); // enter normal mode (D=1 and E=0)
 
+#if APP_LCD_FRAMEBUFFER
+  // transfer the complete framebuffer with the next flush
+  {
+    int display;
+    for(display=0; display<APP_LCD_NUM_DISPLAYS; ++display)
+      lcd_dirty_pages[display] = (1 << APP_LCD_NUM_PAGES) - 1;
+  }
+#endif
 
   return (display_available & (1 << mios32_lcd_device)) ? 0 : -1; // return -1 if display not available
 }
@@ -133,6 +239,14 @@ s32 APP_LCD_Init(u32 mode)
 /////////////////////////////////////////////////////////////////////////////
 s32 APP_LCD_Data(u8 data)
 {
+#if APP_LCD_FRAMEBUFFER
+  s32 status = APP_LCD_FramebufferWrite(mios32_lcd_x, mios32_lcd_y, &data, 1);
+
+  // increment graphical cursor
+  ++mios32_lcd_x;
+
+  return status;
+#else
   // select LCD depending on current cursor position
   // THIS PART COULD BE CHANGED TO ARRANGE THE 8 DISPLAYS ON ANOTHER WAY
   u8 line = 0;
@@ -166,6 +280,7 @@ s32 APP_LCD_Data(u8 data)
     return APP_LCD_Cmd(0x80); // set X=0
 
   return 0; // no error
+#endif
 }
 
 
@@ -176,12 +291,21 @@ s32 APP_LCD_Data(u8 data)
 /////////////////////////////////////////////////////////////////////////////
 s32 APP_LCD_Cmd(u8 cmd)
 {
+#if APP_LCD_FLUSH_VIA_SPI
+  // wait until the framebuffer has been sent, CS/DC and the SPI are used by the DMA transfer
+  while( flush_busy );
+#endif
+
   // select all LCDs
   MIOS32_BOARD_J15_DataSet(0x00);
   MIOS32_BOARD_J15_RS_Set(0); // RS pin used to control DC
 
   // send command
+#if APP_LCD_FLUSH_VIA_SPI
+  MIOS32_SPI_TransferByte(APP_LCD_FRAMEBUFFER_SPI, cmd);
+#else
   MIOS32_BOARD_J15_SerDataShift(cmd);
+#endif
 
   return 0; // no error
 }
@@ -195,11 +319,22 @@ s32 APP_LCD_Cmd(u8 cmd)
 s32 APP_LCD_Clear(void)
 {
   s32 error = 0;
-  u8 x, y;
 
   // use default font
   MIOS32_LCD_FontInit((u8 *)GLCD_FONT_NORMAL);
 
+#if APP_LCD_FRAMEBUFFER
+  memset(lcd_framebuffer, 0x00, sizeof(lcd_framebuffer));
+
+  // all pages will be transfered with the next flush
+  int display;
+  MIOS32_IRQ_Disable();
+  for(display=0; display<APP_LCD_NUM_DISPLAYS; ++display)
+    lcd_dirty_pages[display] = (1 << APP_LCD_NUM_PAGES) - 1;
+  MIOS32_IRQ_Enable();
+#else
+  u8 x, y;
+
   // send data
   for(y=0; y<6; ++y) {
     error |= MIOS32_LCD_CursorSet(0, y);
@@ -211,6 +346,7 @@ s32 APP_LCD_Clear(void)
     for(x=0; x<84; ++x)
       MIOS32_BOARD_J15_SerDataShift(0x00);
   }
+#endif
 
   // set X=0, Y=0
   error |= MIOS32_LCD_CursorSet(0, 0);
@@ -255,6 +391,10 @@ s32 APP_LCD_CursorSet(u16 column, u16 line)
 /////////////////////////////////////////////////////////////////////////////
 s32 APP_LCD_GCursorSet(u16 x, u16 y)
 {
+#if APP_LCD_FRAMEBUFFER
+  // the position is taken from mios32_lcd_x/y when the framebuffer is written
+  return 0; // no error
+#else
   s32 error = 0;
 
   // set X position
@@ -264,6 +404,7 @@ s32 APP_LCD_GCursorSet(u16 x, u16 y)
   error |= APP_LCD_Cmd(0x40 | ((y>>3) % 6));
 
   return error;
+#endif
 }
 
 
@@ -337,6 +478,14 @@ s32 APP_LCD_BitmapPrint(mios32_lcd_bitmap_t bitmap)
   int line;
   int y_lines = (bitmap.height >> 3);
 
+#if APP_LCD_FRAMEBUFFER
+  for(line=0; line<y_lines; ++line)
+    APP_LCD_FramebufferWrite(mios32_lcd_x, mios32_lcd_y + 8*line, bitmap.memory + line * bitmap.line_offset, bitmap.width);
+
+  // the graphical cursor is placed behind the bitmap
+  mios32_lcd_x += bitmap.width;
+#else
+
   for(line=0; line<y_lines; ++line) {
 
     // calculate pointer to bitmap line
@@ -360,6 +509,163 @@ s32 APP_LCD_BitmapPrint(mios32_lcd_bitmap_t bitmap)
     mios32_lcd_y = mios32_lcd_y - (bitmap.height-8);
     APP_LCD_GCursorSet(mios32_lcd_x, mios32_lcd_y);
   }
+#endif
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Transfers the dirty pages of the framebuffer to the displays
+// Only available if APP_LCD_FRAMEBUFFER has been enabled
+// With APP_LCD_FRAMEBUFFER_SPI >= 0 the function returns immediately, and
+// the pages are sent via DMA in background
+// IN: <force>: if 1, all pages will be transfered
+// OUT: returns < 0 on errors
+//      returns 1 if the previous flush is still in progress. Pages which
+//      have been modified meanwhile will be sent with the next call
+/////////////////////////////////////////////////////////////////////////////
+s32 APP_LCD_Flush(u8 force)
+{
+#if !APP_LCD_FRAMEBUFFER
+  return -1; // framebuffer not enabled
+#else
+  int display;
+
+  if( force ) {
+    MIOS32_IRQ_Disable();
+    for(display=0; display<APP_LCD_NUM_DISPLAYS; ++display)
+      lcd_dirty_pages[display] = (1 << APP_LCD_NUM_PAGES) - 1;
+    MIOS32_IRQ_Enable();
+  }
+
+#if APP_LCD_FLUSH_VIA_SPI
+  if( flush_busy )
+    return 1; // previous flush still in progress
+
+  flush_busy = 1;
+  flush_display = 0;
+  flush_page = 0;
+  APP_LCD_FlushNextPage();
+#else
+  for(display=0; display<APP_LCD_NUM_DISPLAYS; ++display) {
+    u8 cs = APP_LCD_DisplayCS(display);
+    if( cs >= 8 )
+      continue; // invalid CS line
+
+    u8 page;
+    for(page=0; page<APP_LCD_NUM_PAGES; ++page) {
+      u8 mask = 1 << page;
+      if( !(lcd_dirty_pages[display] & mask) )
+	continue;
+
+      MIOS32_IRQ_Disable();
+      lcd_dirty_pages[display] &= ~mask;
+      MIOS32_IRQ_Enable();
+
+      // set X=0 and Y=page
+      APP_LCD_Cmd(0x80);
+      APP_LCD_Cmd(0x40 | page);
+
+      // chip select and DC
+      MIOS32_BOARD_J15_DataSet(~(1 << cs));
+      MIOS32_BOARD_J15_RS_Set(1); // RS pin used to control DC
+
+      // send data
+      u8 *ptr = &lcd_framebuffer[display][page][0];
+      int x;
+      for(x=0; x<APP_LCD_WIDTH; ++x)
+	MIOS32_BOARD_J15_SerDataShift(*ptr++);
+    }
+  }
+#endif
 
   return 0; // no error
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Returns 1 while the framebuffer is sent via SPI DMA
+// OUT: 0 if no flush is in progress
+/////////////////////////////////////////////////////////////////////////////
+s32 APP_LCD_FlushBusy(void)
+{
+#if APP_LCD_FLUSH_VIA_SPI
+  return flush_busy ? 1 : 0;
+#else
+  return 0; // transfers are blocking
+#endif
+}
+
+
+#if APP_LCD_FLUSH_VIA_SPI
+/////////////////////////////////////////////////////////////////////////////
+// DMA callback: the page data has been sent
+/////////////////////////////////////////////////////////////////////////////
+static void APP_LCD_FlushDataCallback(void)
+{
+  ++flush_page;
+  APP_LCD_FlushNextPage();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// DMA callback: the page address has been sent, continue with the data
+/////////////////////////////////////////////////////////////////////////////
+static void APP_LCD_FlushCmdCallback(void)
+{
+  // chip select and DC
+  MIOS32_BOARD_J15_DataSet(~(1 << APP_LCD_DisplayCS(flush_display)));
+  MIOS32_BOARD_J15_RS_Set(1); // RS pin used to control DC
+
+  if( MIOS32_SPI_TransferBlock(APP_LCD_FRAMEBUFFER_SPI, &lcd_framebuffer[flush_display][flush_page][0], NULL, APP_LCD_WIDTH, APP_LCD_FlushDataCallback) < 0 ) {
+    // SPI not available: try again with next flush
+    MIOS32_IRQ_Disable();
+    lcd_dirty_pages[flush_display] |= (1 << flush_page);
+    MIOS32_IRQ_Enable();
+    flush_busy = 0;
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Searches for the next dirty page and sends its address
+// Called from APP_LCD_Flush() and from the DMA callback
+/////////////////////////////////////////////////////////////////////////////
+static void APP_LCD_FlushNextPage(void)
+{
+  for(; flush_display<APP_LCD_NUM_DISPLAYS; ++flush_display, flush_page=0) {
+    if( APP_LCD_DisplayCS(flush_display) >= 8 )
+      continue; // invalid CS line
+
+    for(; flush_page<APP_LCD_NUM_PAGES; ++flush_page) {
+      u8 mask = 1 << flush_page;
+
+      MIOS32_IRQ_Disable(); // must be atomic
+      u8 dirty = lcd_dirty_pages[flush_display] & mask;
+      lcd_dirty_pages[flush_display] &= ~mask;
+      MIOS32_IRQ_Enable();
+
+      if( dirty ) {
+	// select all LCDs and set X=0 and Y=page
+	MIOS32_BOARD_J15_DataSet(0x00);
+	MIOS32_BOARD_J15_RS_Set(0); // RS pin used to control DC
+
+	flush_cmd[0] = 0x80;
+	flush_cmd[1] = 0x40 | flush_page;
+	if( MIOS32_SPI_TransferBlock(APP_LCD_FRAMEBUFFER_SPI, flush_cmd, NULL, 2, APP_LCD_FlushCmdCallback) >= 0 )
+	  return; // continue in callback
+
+	// SPI not available: try again with next flush
+	MIOS32_IRQ_Disable();
+	lcd_dirty_pages[flush_display] |= mask;
+	MIOS32_IRQ_Enable();
+	flush_busy = 0;
+	return;
+      }
+    }
+  }
+
+  // all dirty pages have been sent
+  flush_busy = 0;
 }
+#endif
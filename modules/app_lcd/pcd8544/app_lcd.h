@@ -36,6 +36,26 @@
 #define APP_LCD_COLOUR_DEPTH 1
 #define APP_LCD_BITMAP_SIZE ((APP_LCD_NUM_X*APP_LCD_WIDTH * APP_LCD_NUM_Y*APP_LCD_HEIGHT * APP_LCD_COLOUR_DEPTH) / 8)
 
+// optional framebuffer (APP_LCD_BITMAP_SIZE bytes):
+// if enabled, characters and bitmaps are only written into RAM, and modified
+// pages (8 pixel rows of a display) are transfered with APP_LCD_Flush()
+// can be changed from mios32_config.h
+#ifndef APP_LCD_FRAMEBUFFER
+#define APP_LCD_FRAMEBUFFER 0
+#endif
+
+// only relevant if APP_LCD_FRAMEBUFFER enabled:
+// -1: the framebuffer is flushed via J15 (serial data shift, blocking)
+// 0 (J16), 1 (J8/9) or 2 (J19): the framebuffer is flushed via given SPI peripheral with DMA in background,
+// SCLK/MOSI of the displays have to be connected to this port, CS and DC lines are still driven from J15
+#ifndef APP_LCD_FRAMEBUFFER_SPI
+#define APP_LCD_FRAMEBUFFER_SPI -1
+#endif
+
+#ifndef APP_LCD_FRAMEBUFFER_SPI_PRESCALER
+#define APP_LCD_FRAMEBUFFER_SPI_PRESCALER MIOS32_SPI_PRESCALER_16 // ca. 5 MBit
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Global Types
@@ -59,6 +79,10 @@ extern s32 APP_LCD_FColourSet(u32 rgb);
 extern s32 APP_LCD_BitmapPixelSet(mios32_lcd_bitmap_t bitmap, u16 x, u16 y, u32 colour);
 extern s32 APP_LCD_BitmapPrint(mios32_lcd_bitmap_t bitmap);
 
+// only available if APP_LCD_FRAMEBUFFER enabled
+extern s32 APP_LCD_Flush(u8 force);
+extern s32 APP_LCD_FlushBusy(void);
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Export global variables
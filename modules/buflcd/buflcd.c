@@ -12,6 +12,9 @@
 //! Only changed characters (marked with flag 7 of each buffer byte) will be 
 //! transfered to the LCD. This greatly improves performance as well, especially
 //! if a graphical display is connected.
+//! In addition, lines with changed characters are flagged, so that untouched
+//! lines don't need to be scanned at all, and consecutive changed characters
+//! are transfered with a single cursor/font selection.
 //!
 //! Another advantage: LCD access works independent from the physical dimension
 //! of the LCDs. E.g. two 2x40 LCDs can be combined to one large 2x80 display,
@@ -55,6 +58,9 @@
 
 static u8 lcd_buffer[BUFLCD_BUFFER_SIZE];
 
+// one flag per line which contains changed characters
+static u32 lcd_dirty_lines[(BUFLCD_NUM_DIRTY_LINES+31)/32];
+
 static u16 lcd_cursor_x;
 static u8 lcd_cursor_y;
 
@@ -299,6 +305,9 @@ s32 BUFLCD_Clear(void)
   lcd_current_font = 'n';
 #endif
 
+  for(i=0; i<(BUFLCD_NUM_DIRTY_LINES+31)/32; ++i)
+    lcd_dirty_lines[i] = 0xffffffff;
+
   lcd_cursor_x = 0;
   lcd_cursor_y = 0;
 
@@ -342,19 +351,29 @@ s32 BUFLCD_PrintChar(char c)
     return -1; // invalid line
 
   u8 *ptr = &lcd_buffer[bufpos];
-  if( (*ptr & 0x7f) != c )
+  u8 changed = 0;
+  if( (*ptr & 0x7f) != c ) {
     *ptr = c;
+    changed = 1;
+  }
 
 #if BUFLCD_SUPPORT_GLCD_FONTS
   if( glcd_font_handling ) {
     u8 *font_ptr = &lcd_buffer[bufpos + (BUFLCD_BUFFER_SIZE/2)];
-    if( *font_ptr != lcd_current_font ) {
+    if( (*font_ptr & 0x7f) != lcd_current_font ) { // bit 7 is set by BUFLCD_Update()
       *font_ptr = lcd_current_font;
       *ptr &= 0x7f; // new font: ensure that character will be updated
+      changed = 1;
     }
   }
 #endif
 
+  if( changed && lcd_cursor_y < BUFLCD_NUM_DIRTY_LINES ) {
+    MIOS32_IRQ_Disable(); // must be atomic
+    lcd_dirty_lines[lcd_cursor_y / 32] |= (1UL << (lcd_cursor_y % 32));
+    MIOS32_IRQ_Enable();
+  }
+
   ++lcd_cursor_x;
 
   return 0; // no error
@@ -384,97 +403,132 @@ s32 BUFLCD_Update(u8 force)
   int next_y = -1;
   int x, y;
 
+#if BUFLCD_SUPPORT_GLCD_FONTS
+  u8 font_handling = glcd_font_handling;
+#else
+  u8 font_handling = 0;
+#endif
+
   u32 bufpos_len = BUFLCD_MaxBufferGet();
+  u32 line_len = buflcd_device_num_x * buflcd_device_width;
   int phys_y = buflcd_offset_y;
   for(y=0; y<buflcd_device_num_y*buflcd_device_height; ++y, ++phys_y) {
-    u32 bufpos = y * buflcd_device_num_x * buflcd_device_width;
+    u32 bufpos = y * line_len;
     if( bufpos >= bufpos_len )
       break;
 
+    // skip lines without changes
+    // the flag is cleared before the line is scanned, so that characters which are print meanwhile won't get lost
+    if( y < BUFLCD_NUM_DIRTY_LINES ) {
+      u32 mask = 1UL << (y % 32);
+      MIOS32_IRQ_Disable(); // must be atomic
+      u8 dirty = (lcd_dirty_lines[y / 32] & mask) ? 1 : 0;
+      lcd_dirty_lines[y / 32] &= ~mask;
+      MIOS32_IRQ_Enable();
+
+      if( !dirty && !force )
+	continue;
+    }
+
     u8 *ptr = (u8 *)&lcd_buffer[bufpos];
 #if BUFLCD_SUPPORT_GLCD_FONTS
     u8 *font_ptr = (u8 *)&lcd_buffer[bufpos + (BUFLCD_BUFFER_SIZE/2)];
+#else
+    u8 *font_ptr = NULL; // not used
 #endif
     int phys_x = buflcd_offset_x;
     int device = (buflcd_device_num_x * (phys_y / buflcd_device_height)) - 1;
-    for(x=0; x<(buflcd_device_num_x * buflcd_device_width) && bufpos < bufpos_len; ++x, ++phys_x, ++bufpos) {
+    for(x=0; x<line_len && bufpos < bufpos_len; ++x, ++phys_x, ++bufpos, ++ptr, ++font_ptr) {
       if( (phys_x % buflcd_device_width) == 0 )
 	++device;
 
-      if( force || !(*ptr & 0x80)
-#if BUFLCD_SUPPORT_GLCD_FONTS
-	  || (glcd_font_handling && !(*font_ptr & 0x80))
-#endif
-	  ) {
-#if BUFLCD_SUPPORT_GLCD_FONTS
-	u8 *glcd_font = NULL;
-	if( glcd_font_handling ) {
-	  switch( *font_ptr & 0x7f ) {
-	  case 'n': glcd_font = (u8 *)GLCD_FONT_NORMAL; break;
-	  case 'i': glcd_font = (u8 *)GLCD_FONT_NORMAL_INV; break;
-	  case 'b': glcd_font = (u8 *)GLCD_FONT_BIG; break;
-	  case 's': glcd_font = (u8 *)GLCD_FONT_SMALL; break;
-	  case 't': glcd_font = (u8 *)GLCD_FONT_TINY; break;
-	  case 'k': glcd_font = (u8 *)GLCD_FONT_KNOB_ICONS; break;
-	  case 'h': glcd_font = (u8 *)GLCD_FONT_METER_ICONS_H; break;
-	  case 'v': glcd_font = (u8 *)GLCD_FONT_METER_ICONS_V; break;
-	  default:
-	    glcd_font = NULL; // no character will be print
-	  }
+      if( !force && (ptr[0] & 0x80) && (!font_handling || (font_ptr[0] & 0x80)) )
+	continue;
 
-	  MIOS32_LCD_FontInit(glcd_font);
+      // determine the run of changed characters which are print with the same font on the same device
+      int run_len = 1;
+      while( (x + run_len) < line_len && (bufpos + run_len) < bufpos_len &&
+	     ((phys_x + run_len) % buflcd_device_width) != 0 &&
+	     (force || !(ptr[run_len] & 0x80) || (font_handling && !(font_ptr[run_len] & 0x80))) &&
+	     (!font_handling || (font_ptr[run_len] & 0x7f) == (font_ptr[0] & 0x7f)) )
+	++run_len;
+
+#if BUFLCD_SUPPORT_GLCD_FONTS
+      u8 *glcd_font = NULL;
+      if( glcd_font_handling ) {
+	switch( *font_ptr & 0x7f ) {
+	case 'n': glcd_font = (u8 *)GLCD_FONT_NORMAL; break;
+	case 'i': glcd_font = (u8 *)GLCD_FONT_NORMAL_INV; break;
+	case 'b': glcd_font = (u8 *)GLCD_FONT_BIG; break;
+	case 's': glcd_font = (u8 *)GLCD_FONT_SMALL; break;
+	case 't': glcd_font = (u8 *)GLCD_FONT_TINY; break;
+	case 'k': glcd_font = (u8 *)GLCD_FONT_KNOB_ICONS; break;
+	case 'h': glcd_font = (u8 *)GLCD_FONT_METER_ICONS_H; break;
+	case 'v': glcd_font = (u8 *)GLCD_FONT_METER_ICONS_V; break;
+	default:
+	  glcd_font = NULL; // no character will be print
 	}
+
+	MIOS32_LCD_FontInit(glcd_font);
+      }
 #endif
 
-	if( x != next_x || y != next_y ) {
+      if( x != next_x || y != next_y ) {
 #if BUFLCD_SUPPORT_GLCD_FONTS
-	  if( glcd_font_handling && glcd_font ) {
-	    // temporary use pseudo-font to ensure that Y is handled equaly for all fonts
-	    u8 pseudo_font[4];
-	    // just to ensure...
+	if( glcd_font_handling && glcd_font ) {
+	  // temporary use pseudo-font to ensure that Y is handled equaly for all fonts
+	  u8 pseudo_font[4];
+	  // just to ensure...
 #if MIOS32_LCD_FONT_WIDTH_IX != 0 || MIOS32_LCD_FONT_HEIGHT_IX != 1 || MIOS32_LCD_FONT_X0_IX != 2 || MIOS32_LCD_FONT_OFFSET_IX != 3
 # error "Please adapt this part for new LCD Font parameter positions!"
 #endif
-	    pseudo_font[MIOS32_LCD_FONT_WIDTH_IX] = glcd_font[MIOS32_LCD_FONT_WIDTH_IX];
-	    pseudo_font[MIOS32_LCD_FONT_HEIGHT_IX] = 1*8; // forced!
-	    pseudo_font[MIOS32_LCD_FONT_X0_IX] = glcd_font[MIOS32_LCD_FONT_X0_IX];
-	    pseudo_font[MIOS32_LCD_FONT_OFFSET_IX] = glcd_font[MIOS32_LCD_FONT_OFFSET_IX];
-	    MIOS32_LCD_FontInit((u8 *)&pseudo_font);
-	  }
+	  pseudo_font[MIOS32_LCD_FONT_WIDTH_IX] = glcd_font[MIOS32_LCD_FONT_WIDTH_IX];
+	  pseudo_font[MIOS32_LCD_FONT_HEIGHT_IX] = 1*8; // forced!
+	  pseudo_font[MIOS32_LCD_FONT_X0_IX] = glcd_font[MIOS32_LCD_FONT_X0_IX];
+	  pseudo_font[MIOS32_LCD_FONT_OFFSET_IX] = glcd_font[MIOS32_LCD_FONT_OFFSET_IX];
+	  MIOS32_LCD_FontInit((u8 *)&pseudo_font);
+	}
 #endif
-	  MIOS32_LCD_DeviceSet(device);
-	  MIOS32_LCD_CursorSet(phys_x % buflcd_device_width, phys_y % buflcd_device_height);
+	MIOS32_LCD_DeviceSet(device);
+	MIOS32_LCD_CursorSet(phys_x % buflcd_device_width, phys_y % buflcd_device_height);
 #if BUFLCD_SUPPORT_GLCD_FONTS
-	  if( glcd_font_handling ) {
-	    // switch back to original font
-	    MIOS32_LCD_FontInit(glcd_font);
-	  }
-#endif
+	if( glcd_font_handling ) {
+	  // switch back to original font
+	  MIOS32_LCD_FontInit(glcd_font);
 	}
+#endif
+      }
 
+      // transfer the run
+      int i;
 #if BUFLCD_SUPPORT_GLCD_FONTS
-	if( !glcd_font_handling || glcd_font )
+      if( !glcd_font_handling || glcd_font )
 #endif
-	  MIOS32_LCD_PrintChar(*ptr & 0x7f);
+	for(i=0; i<run_len; ++i)
+	  MIOS32_LCD_PrintChar(ptr[i] & 0x7f);
 
-	MIOS32_IRQ_Disable(); // must be atomic
-	*ptr |= 0x80;
+      MIOS32_IRQ_Disable(); // must be atomic
+      for(i=0; i<run_len; ++i) {
+	ptr[i] |= 0x80;
 #if BUFLCD_SUPPORT_GLCD_FONTS
-	*font_ptr |= 0x80;
+	font_ptr[i] |= 0x80;
 #endif
-	MIOS32_IRQ_Enable();
+      }
+      MIOS32_IRQ_Enable();
 
-	next_y = y;
-	next_x = x+1;
+      // continue with the character after the run
+      x += run_len - 1;
+      phys_x += run_len - 1;
+      bufpos += run_len - 1;
+      ptr += run_len - 1;
+      font_ptr += run_len - 1;
 
-	// for multiple LCDs: ensure that cursor is set when we reach the next partition
-	if( (next_x % buflcd_device_width) == 0 )
-	  next_x = -1;
-      }
-      ++ptr;
-#if BUFLCD_SUPPORT_GLCD_FONTS
-      ++font_ptr;
-#endif
+      next_y = y;
+      next_x = x+1;
+
+      // for multiple LCDs: ensure that cursor is set when we reach the next partition
+      if( (next_x % buflcd_device_width) == 0 )
+	next_x = -1;
     }
   }
 
@@ -40,6 +40,12 @@ extern "C" {
 # define BUFLCD_SUPPORT_GLCD_FONTS   0
 #endif
 
+// number of lines for which BUFLCD_Update() tracks changes
+// Lines beyond this number are checked character by character on each update
+#ifndef BUFLCD_NUM_DIRTY_LINES
+# define BUFLCD_NUM_DIRTY_LINES      64
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Global Types
@@ -89,6 +89,20 @@ DRESULT disk_read (
 )
 {
   if( drv == SDCARD ) {
+    // multiple sectors: transfer them with a single command
+    if( count > 1 ) {
+#if DEBUG_VERBOSE_LEVEL >= 2
+      MIOS32_MIDI_SendDebugMessage("[disk_read] sectors %d..%d\n", sector, sector+count-1);
+#endif
+      if( MIOS32_SDCARD_SectorsRead(sector, buff, count) < 0 ) {
+#if DEBUG_VERBOSE_LEVEL >= 1
+	MIOS32_MIDI_SendDebugMessage("[disk_read] error while reading sectors %d..%d\n", sector, sector+count-1);
+#endif
+	return RES_ERROR;
+      }
+      return RES_OK;
+    }
+
     int i;
 
     for(i=0; i<count; ++i) {
@@ -128,6 +142,20 @@ DRESULT disk_write (
 )
 {
   if( drv == SDCARD ) {
+    // multiple sectors: transfer them with a single command
+    if( count > 1 ) {
+#if DEBUG_VERBOSE_LEVEL >= 2
+      MIOS32_MIDI_SendDebugMessage("[disk_write] sectors %d..%d\n", sector, sector+count-1);
+#endif
+      if( MIOS32_SDCARD_SectorsWrite(sector, (u8 *)buff, count) < 0 ) {
+#if DEBUG_VERBOSE_LEVEL >= 1
+	MIOS32_MIDI_SendDebugMessage("[disk_write] error while writing to sectors %d..%d\n", sector, sector+count-1);
+#endif
+	return RES_ERROR;
+      }
+      return RES_OK;
+    }
+
     int i;
 
     for(i=0; i<count; ++i) {
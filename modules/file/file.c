@@ -15,6 +15,11 @@
 //! so that no directory access is required to find the first sector of the
 //! file (again).
 //!
+//! Files which are read from several tasks in parallel (e.g. streamed) can
+//! be mapped with FILE_ReadClusterMapCreate(). FILE_ReadClusterMapBuffer()
+//! reads from such a file without re-opening it and without following the
+//! FAT chain.
+//!
 //! NOTE: before accessing the SD Card, the upper level function should
 //! synchronize with a SD Card semaphore!
 //! E.g. (defined in tasks.h in various projects):
@@ -110,6 +115,9 @@ typedef struct
 
 static s32 FILE_MountFS(void);
 
+// from ff.c (not exported by ff.h)
+extern DWORD get_fat(FATFS *fs, DWORD clst);
+
 static s32 FILE_CreateTarRecursive(char *filename, char *src_path, u8 exclude_tar_files, u8 depth, u8 max_depth, u32 *num_dirs, u32 *num_files);
 static s32 FILE_CreateTarHeader(char *filename, char *src_path, u8 is_dir, u32 filesize);
 
@@ -133,6 +141,17 @@ static u8 file_read_is_open; // only for safety purposes
 static FIL file_write;
 static u8 file_write_is_open; // only for safety purposes
 
+// last sector which has been partially read by FILE_ReadClusterMapBuffer()
+static u8 cluster_map_sector_buffer[SECTOR_SIZE];
+static u32 cluster_map_sector;
+
+// sector size of the read file (see SS() in ff.c)
+#if _MAX_SS == 512
+#define FILE_READ_SECTOR_SIZE 512
+#else
+#define FILE_READ_SECTOR_SIZE (file_read.fs->s_size)
+#endif
+
 // SD Card status
 static u8 sdcard_available;
 static u8 volume_available;
@@ -158,6 +177,7 @@ s32 FILE_Init(u32 mode)
 {
   file_read_is_open = 0;
   file_write_is_open = 0;
+  cluster_map_sector = 0xffffffff;
   sdcard_available = 0;
   volume_available = 0;
   volume_free_bytes = 0;
@@ -243,6 +263,7 @@ static s32 FILE_MountFS(void)
 
   file_read_is_open = 0;
   file_write_is_open = 0;
+  cluster_map_sector = 0xffffffff;
 
   if( (res=f_mount(0, &fs)) != FR_OK ) {
     DEBUG_MSG("[FILE] Failed to mount SD Card - error status: %d\n", res);
@@ -528,6 +549,162 @@ u32 FILE_ReadGetCurrentPosition(void)
 
 
 
+/////////////////////////////////////////////////////////////////////////////
+//! Creates a cluster map of a file which has been opened with FILE_ReadOpen().
+//!
+//! The map contains the fragments of the cluster chain as pairs of
+//! <number of clusters> <first cluster>, and is terminated with 0.
+//! With this map FILE_ReadClusterMapBuffer() can read from any position of
+//! the file without following the FAT chain, and without re-opening the file.
+//! Accordingly it's possible to read from multiple files in parallel (e.g. by
+//! several streaming tasks).
+//!
+//! The FAT chain is only walked once by this function.
+//! If map is NULL, or map_size too small, only the required size is returned,
+//! so that the map can be allocated before the function is called again.
+//! \param[in] file the file reference which has been returned by FILE_ReadOpen()
+//! \param[out] map the map (can be NULL)
+//! \param[in] map_size the number of words which are available in the map
+//! \return < 0 on errors (error codes are documented in file.h)
+//! \return the number of required words (incl. terminator)
+/////////////////////////////////////////////////////////////////////////////
+s32 FILE_ReadClusterMapCreate(file_t* file, u32 *map, u32 map_size)
+{
+  // exit if volume not available
+  if( !volume_available )
+    return FILE_ERR_NO_VOLUME;
+
+  u32 num_words = 0;
+  u32 clst = file->org_clust;
+  u32 num_clusters = file->fsize ? ((file->fsize - 1) / ((u32)fs.csize * SECTOR_SIZE) + 1) : 0;
+
+  while( num_clusters ) {
+    // determine length of fragment
+    u32 first_clst = clst;
+    u32 fragment_len = 0;
+    do {
+      if( clst < 2 || clst >= fs.max_clust )
+	return FILE_ERR_READ; // invalid cluster
+
+      ++fragment_len;
+      if( --num_clusters == 0 )
+	break;
+
+      u32 next_clst = get_fat(&fs, clst);
+      if( next_clst == 0xffffffff )
+	return FILE_ERR_SD_CARD;
+
+      if( next_clst != (clst+1) ) {
+	clst = next_clst;
+	break; // new fragment
+      }
+      clst = next_clst;
+    } while( 1 );
+
+    if( map != NULL && (num_words+2) < map_size ) {
+      map[num_words+0] = fragment_len;
+      map[num_words+1] = first_clst;
+    }
+    num_words += 2;
+  }
+
+  // terminator
+  if( map != NULL && num_words < map_size )
+    map[num_words] = 0;
+  ++num_words;
+
+  return num_words;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Reads from a file at the given position via a cluster map which has been
+//! created with FILE_ReadClusterMapCreate().
+//!
+//! The file doesn't need to be (re-)opened, and the file position of the
+//! read file isn't changed. Complete sectors are read directly into the buffer
+//! (with multi-block transfers if possible), the last partially read sector
+//! is kept in a buffer, so that continuous reads only access it once.
+//! \param[in] file the file reference which has been returned by FILE_ReadOpen()
+//! \param[in] map the cluster map
+//! \param[in] offset the file position
+//! \param[out] buffer the read bytes
+//! \param[in] len the number of bytes which should be read
+//! \return < 0 on errors (error codes are documented in file.h)
+//! \return FILE_ERR_READCOUNT if the end of file has been reached before len bytes have been read
+/////////////////////////////////////////////////////////////////////////////
+s32 FILE_ReadClusterMapBuffer(file_t* file, u32 *map, u32 offset, u8 *buffer, u32 len)
+{
+  // exit if volume not available
+  if( !volume_available )
+    return FILE_ERR_NO_VOLUME;
+
+  s32 status = 0;
+  if( offset >= file->fsize )
+    return FILE_ERR_READCOUNT;
+  if( len > (file->fsize - offset) ) {
+    len = file->fsize - offset;
+    status = FILE_ERR_READCOUNT;
+  }
+
+  u32 cluster_size = (u32)fs.csize * SECTOR_SIZE;
+  while( len ) {
+    // search cluster in map
+    u32 clst_ix = offset / cluster_size;
+    u32 *fragment = map;
+    while( fragment[0] && clst_ix >= fragment[0] ) {
+      clst_ix -= fragment[0];
+      fragment += 2;
+    }
+    if( !fragment[0] )
+      return FILE_ERR_READ; // map doesn't match to file
+
+    u32 sector = FILE_VolumeCluster2Sector(fragment[1] + clst_ix);
+    if( !sector )
+      return FILE_ERR_READ; // invalid cluster
+    sector += (offset % cluster_size) / SECTOR_SIZE;
+
+    u32 sector_offset = offset % SECTOR_SIZE;
+    if( sector_offset == 0 && len >= SECTOR_SIZE ) {
+      // read complete sectors until the end of fragment
+      u32 num_sectors = len / SECTOR_SIZE;
+      u32 fragment_sectors = (fragment[0] - clst_ix) * fs.csize - ((offset % cluster_size) / SECTOR_SIZE);
+      if( num_sectors > fragment_sectors )
+	num_sectors = fragment_sectors;
+      if( num_sectors > 255 )
+	num_sectors = 255; // limited by disk_read()
+
+      if( disk_read(fs.drive, buffer, sector, num_sectors) != RES_OK )
+	return FILE_ERR_READ;
+
+      u32 num_bytes = num_sectors * SECTOR_SIZE;
+      buffer += num_bytes;
+      offset += num_bytes;
+      len -= num_bytes;
+    } else {
+      // partial sector: read via sector buffer
+      if( sector != cluster_map_sector ) {
+	cluster_map_sector = 0xffffffff;
+	if( disk_read(fs.drive, cluster_map_sector_buffer, sector, 1) != RES_OK )
+	  return FILE_ERR_READ;
+	cluster_map_sector = sector;
+      }
+
+      u32 num_bytes = SECTOR_SIZE - sector_offset;
+      if( num_bytes > len )
+	num_bytes = len;
+      memcpy(buffer, &cluster_map_sector_buffer[sector_offset], num_bytes);
+
+      buffer += num_bytes;
+      offset += num_bytes;
+      len -= num_bytes;
+    }
+  }
+
+  return status;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 //! Read from file
 //! \return < 0 on errors (error codes are documented in file.h)
@@ -582,31 +759,114 @@ s32 FILE_ReadBufferUnknownLen(u8 *buffer, u32 len)
 
 
 /////////////////////////////////////////////////////////////////////////////
-//! Read a string (terminated with CR) from file
+//! Returns the next part of a line without copying it: the returned pointer
+//! points into the sector buffer of the read file.
+//!
+//! The part ends with a newline (CR or LF), or at the end of the currently
+//! buffered sector. In the second case the line continues with the next call.
+//! The pointer is only valid until the next read operation, and the
+//! characters must not be modified!
+//!
+//! Accordingly the SD Card is only accessed once per sector, and not for
+//! each character like it would be done with FILE_ReadByte()
+//! \param[out] part pointer to the first character
+//! \param[out] len number of characters (without the newline)
 //! \return < 0 on errors (error codes are documented in file.h)
+//! \return 0 if the end of file has been reached
+//! \return 1 if the part has been terminated by a newline
+//! \return 2 if the line continues (or the file ends without newline)
 /////////////////////////////////////////////////////////////////////////////
-s32 FILE_ReadLine(u8 *buffer, u32 max_len)
+s32 FILE_ReadLinePart(u8 **part, u32 *len)
 {
-  s32 status;
-  u32 num_read = 0;
+  *len = 0;
 
-  while( file_read.fptr < file_read.fsize ) {
-    status = FILE_ReadBuffer(buffer, 1);
+  // exit if volume not available
+  if( !volume_available )
+    return FILE_ERR_NO_VOLUME;
 
-    if( status < 0 )
+  u32 fptr = file_read.fptr;
+  if( fptr >= file_read.fsize )
+    return 0; // end of file
+
+#if _FS_TINY
+  // no file specific sector buffer available: read character by character
+  static u8 c;
+  s32 status;
+  if( (status=FILE_ReadBuffer(&c, 1)) < 0 )
+    return status;
+  *part = &c;
+  if( c == '\n' || c == '\r' )
+    return 1;
+  *len = 1;
+  return 2;
+#else
+  u32 offset = fptr % FILE_READ_SECTOR_SIZE;
+
+  // on a sector boundary the next sector has to be loaded
+  // this is done by FatFs when the first character is read
+  if( offset == 0 ) {
+    u8 c;
+    s32 status;
+    if( (status=FILE_ReadBuffer(&c, 1)) < 0 )
       return status;
+  }
 
-    ++num_read;
+  // search for newline within the sector (or until end of file)
+  u32 end = FILE_READ_SECTOR_SIZE;
+  if( (file_read.fsize - fptr) < (end - offset) )
+    end = offset + (file_read.fsize - fptr);
 
-    if( *buffer == '\n' || *buffer == '\r' )
-      break;
+  u8 *start = &file_read.buf[offset];
+  u8 *ptr = start;
+  u8 *ptr_end = &file_read.buf[end];
+  while( ptr < ptr_end && *ptr != '\n' && *ptr != '\r' )
+    ++ptr;
+
+  *part = start;
+  *len = ptr - start;
 
-    if( num_read < max_len )
-      ++buffer;
+  // consume characters (+ newline)
+  // the sector remains in the buffer, FatFs continues with the next sector once the boundary is reached
+  u8 eol = ptr < ptr_end;
+  file_read.fptr = fptr + *len + eol;
+
+  return eol ? 1 : 2;
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+//! Read a string (terminated with CR) from file
+//! \return < 0 on errors (error codes are documented in file.h)
+/////////////////////////////////////////////////////////////////////////////
+s32 FILE_ReadLine(u8 *buffer, u32 max_len)
+{
+  s32 status;
+  u32 num_read = 0;
+  u32 num_stored = 0;
+  u8 *part;
+  u32 len;
+
+  while( (status=FILE_ReadLinePart(&part, &len)) > 0 ) {
+    // copy as many characters as fit into the buffer (terminator considered)
+    u32 copy_len = len;
+    if( (num_stored + copy_len) >= max_len )
+      copy_len = (max_len > (num_stored + 1)) ? (max_len - 1 - num_stored) : 0;
+    memcpy(&buffer[num_stored], part, copy_len);
+    num_stored += copy_len;
+
+    num_read += len;
+    if( status == 1 ) {
+      ++num_read; // newline
+      break;
+    }
   }
 
-  // replace newline by terminator
-  *buffer = 0;
+  if( status < 0 )
+    return status;
+
+  // terminate string
+  buffer[num_stored] = 0;
 
   return num_read;
 }
@@ -688,6 +948,9 @@ s32 FILE_WriteClose(void)
 
   file_write_is_open = 0;
 
+  // the buffered sector of FILE_ReadClusterMapBuffer() could have been changed
+  cluster_map_sector = 0xffffffff;
+
   return status;
 }
 
@@ -41,12 +41,33 @@ u32 timeout_counter;
 genesis_t genesis[GENESIS_COUNT];
 u32 genesis_clock_opn2;
 u32 genesis_clock_psg;
+genesis_opn2_queuestats_t genesis_opn2_queuestats[GENESIS_COUNT];
 
 
 /////////////////////////////////////////////////////////////////////////////
 // Local variables
 /////////////////////////////////////////////////////////////////////////////
 
+//OPN2 write queue
+typedef struct {
+    u8 addrhi;
+    u8 address;
+    u8 data;
+    u8 dummy;
+} opn2_queue_entry_t;
+
+static opn2_queue_entry_t opn2_queue[GENESIS_COUNT][GENESIS_OPN2_QUEUE_LENGTH];
+static u8 opn2_queue_start[GENESIS_COUNT];
+static u8 opn2_queue_depth[GENESIS_COUNT];
+static u8 opn2_queue_barrier[GENESIS_COUNT]; //Entries (from start) up to and including the last barrier
+
+//Last value written or queued for each register, bank 1 at 0x100
+static u8 opn2_shadow[GENESIS_COUNT][0x200];
+static u32 opn2_shadow_valid[GENESIS_COUNT][0x200 / 32];
+
+//Register currently latched in the OPN2 address register, 0xFFFF if unknown
+static u16 opn2_latchedaddr[GENESIS_COUNT];
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Lookup tables
@@ -64,6 +85,33 @@ static const u8 OPN2Ch3Regs[8] = {
         13,    9,   11, 0xFF,   14,   10,   12, 0xFF
 };
 
+//How the write queue may treat a register
+#define OPN2_QUEUE_NODROP     0x01 //Write has an effect even if the value doesn't change
+#define OPN2_QUEUE_NOCOALESCE 0x02 //Every write has to reach the chip, in order
+#define OPN2_QUEUE_BARRIER    0x04 //Nothing may be coalesced across this write
+
+static u8 Genesis_OPN2QueueRegFlags(u8 addrhi, u8 address){
+    if(!addrhi){
+        //Key On, timer control (reset bits), test registers
+        if(address == 0x28 || address == 0x27 || address == 0x21 || address == 0x2C){
+            return OPN2_QUEUE_NODROP | OPN2_QUEUE_NOCOALESCE | OPN2_QUEUE_BARRIER;
+        }
+        //DAC data: a stream of samples
+        if(address == 0x2A) return OPN2_QUEUE_NOCOALESCE;
+        //DAC enable: must stay in order with the samples around it
+        if(address == 0x2B) return OPN2_QUEUE_NOCOALESCE | OPN2_QUEUE_BARRIER;
+        //Channel 3 extra frequency: high byte latched, low byte applies it
+        //The FNUM2/BLOCK latch is shared by all channels, so the high byte
+        //must reach the chip even if its shadow value didn't change
+        if(address >= 0xA8 && address <= 0xAA) return OPN2_QUEUE_NODROP | OPN2_QUEUE_NOCOALESCE;
+        if(address >= 0xAC && address <= 0xAE) return OPN2_QUEUE_NODROP | OPN2_QUEUE_NOCOALESCE;
+    }
+    //Frequency: high byte latched (shared latch, see above), low byte applies it
+    if(address >= 0xA0 && address <= 0xA2) return OPN2_QUEUE_NODROP | OPN2_QUEUE_NOCOALESCE;
+    if(address >= 0xA4 && address <= 0xA6) return OPN2_QUEUE_NODROP | OPN2_QUEUE_NOCOALESCE;
+    return 0;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // Functions
 /////////////////////////////////////////////////////////////////////////////
@@ -115,10 +163,10 @@ void Genesis_Init(){
     genesis_clock_psg = 3579545;
 }
 
-void Genesis_OPN2Write(u8 board, u8 addrhi, u8 address, u8 data){
-    board &= 0x03;
-    addrhi &= 0x01;
-    //Save chip state
+static void Genesis_OPN2SaveState(u8 board, u8 addrhi, u8 address, u8 data){
+    u16 r = ((u16)addrhi << 8) | address;
+    opn2_shadow[board][r] = data;
+    opn2_shadow_valid[board][r >> 5] |= (1 << (r & 31));
     u8 chan, op, reg;
     if(address <= 0x2F){
         if(address >= 0x20 && !addrhi){
@@ -163,28 +211,37 @@ void Genesis_OPN2Write(u8 board, u8 addrhi, u8 address, u8 data){
             genesis[board].opn2.chan[chan].ALL[reg] = data;
         }
     }//else { not a register; }
-    //Perform chip write
+}
+
+static void Genesis_OPN2BusWrite(u8 board, u8 addrhi, u8 address, u8 data){
+    u16 r = ((u16)addrhi << 8) | address;
     MIOS32_IRQ_Disable(); //Turn off interrupts
     GPIOE->MODER &= 0x0000FFFF; //Set data pins to inputs (in case not already)
     u32 porte = GPIOE->ODR;
     porte &= 0xFFFF000B; //Mask out the things we will set
-    u32 a = address;
-    a <<= 2; //Make room for board number
-    a |= board;
+    u32 a = board;
     a <<= 2; //A2 = 0 for OPN2 write, A1 = addrhi
     a |= addrhi;
     a <<= 4; //Move over into place, A0 = 0 for address write
     porte |= a; //Write to our temp copy
-    GPIOE->ODR = porte; //Write address bits and data
-    GPIOE->MODER |= 0x55550000; //Set data pins to outputs
-    GENESIS_SHORTWAIT;
-    GPIOC->ODR &= 0xFFFF5FFF; //Write /CS and /WR low
-    GENESIS_OPN2_WRITEWAIT; //Wait for 1 OPN2 internal cycle
-    GPIOC->ODR |= 0x0000A000; //Write /CS and /WR high
-    porte &= 0xFFFF00FF; //Get rid of address value
+    if(opn2_latchedaddr[board] != r){
+        porte |= ((u32)address << 8); //Put in address value
+        GPIOE->ODR = porte; //Write address bits and data
+        GPIOE->MODER |= 0x55550000; //Set data pins to outputs
+        GENESIS_SHORTWAIT;
+        GPIOC->ODR &= 0xFFFF5FFF; //Write /CS and /WR low
+        GENESIS_OPN2_WRITEWAIT; //Wait for 1 OPN2 internal cycle
+        GPIOC->ODR |= 0x0000A000; //Write /CS and /WR high
+        porte &= 0xFFFF00FF; //Get rid of address value
+        opn2_latchedaddr[board] = r;
+    }else{
+        //The OPN2 still has this register selected, only the data cycle is needed
+        ++genesis_opn2_queuestats[board].addrskipped;
+    }
     porte |= ((u32)data << 8); //Put in data value
     porte |= 4; //A0 = 1 for data write
     GPIOE->ODR = porte; //Write address bits and data
+    GPIOE->MODER |= 0x55550000; //Set data pins to outputs
     GENESIS_SHORTWAIT;
     GPIOC->ODR &= 0xFFFF5FFF; //Write /CS and /WR low
     GENESIS_OPN2_WRITEWAIT; //Wait for 1 OPN2 internal cycle
@@ -193,6 +250,76 @@ void Genesis_OPN2Write(u8 board, u8 addrhi, u8 address, u8 data){
     MIOS32_IRQ_Enable(); //Turn on interrupts
 }
 
+void Genesis_OPN2Write(u8 board, u8 addrhi, u8 address, u8 data){
+    board &= 0x03;
+    addrhi &= 0x01;
+    //Save chip state
+    Genesis_OPN2SaveState(board, addrhi, address, data);
+    //Perform chip write
+    Genesis_OPN2BusWrite(board, addrhi, address, data);
+}
+
+u8 Genesis_OPN2QueueWrite(u8 board, u8 addrhi, u8 address, u8 data){
+    board &= 0x03;
+    addrhi &= 0x01;
+    genesis_opn2_queuestats_t* stats = &genesis_opn2_queuestats[board];
+    u8 flags = Genesis_OPN2QueueRegFlags(addrhi, address);
+    u16 r = ((u16)addrhi << 8) | address;
+    //Drop writes which don't change anything
+    if(!(flags & OPN2_QUEUE_NODROP) && (opn2_shadow_valid[board][r >> 5] & (1 << (r & 31)))
+            && opn2_shadow[board][r] == data){
+        ++stats->dropped;
+        return 1;
+    }
+    //Replace a pending write to the same register, if there's no barrier in between
+    u8 i, depth = opn2_queue_depth[board];
+    opn2_queue_entry_t* e;
+    if(!(flags & OPN2_QUEUE_NOCOALESCE)){
+        for(i=depth; i>opn2_queue_barrier[board]; --i){
+            e = &opn2_queue[board][(opn2_queue_start[board] + i - 1) % GENESIS_OPN2_QUEUE_LENGTH];
+            if(e->address == address && e->addrhi == addrhi){
+                e->data = data;
+                Genesis_OPN2SaveState(board, addrhi, address, data);
+                ++stats->coalesced;
+                return 1;
+            }
+        }
+    }
+    //Append
+    if(depth >= GENESIS_OPN2_QUEUE_LENGTH) return 0; //Full, try again later
+    e = &opn2_queue[board][(opn2_queue_start[board] + depth) % GENESIS_OPN2_QUEUE_LENGTH];
+    e->addrhi = addrhi;
+    e->address = address;
+    e->data = data;
+    opn2_queue_depth[board] = ++depth;
+    if(flags & OPN2_QUEUE_BARRIER) opn2_queue_barrier[board] = depth;
+    Genesis_OPN2SaveState(board, addrhi, address, data);
+    ++stats->queued;
+    return 1;
+}
+
+u8 Genesis_OPN2QueueDrain(u8 board){
+    board &= 0x03;
+    opn2_queue_entry_t* e;
+    u8 address;
+    while(opn2_queue_depth[board]){
+        e = &opn2_queue[board][opn2_queue_start[board]];
+        address = e->address;
+        Genesis_OPN2BusWrite(board, e->addrhi, address, e->data);
+        ++genesis_opn2_queuestats[board].written;
+        if(++opn2_queue_start[board] >= GENESIS_OPN2_QUEUE_LENGTH) opn2_queue_start[board] = 0;
+        --opn2_queue_depth[board];
+        if(opn2_queue_barrier[board]) --opn2_queue_barrier[board];
+        //Only 0x2x writes (except Key On) don't make the chip busy
+        if(!(address >= 0x20 && address < 0x2F && address != 0x28)) return 1;
+    }
+    return 0;
+}
+
+u8 Genesis_OPN2QueueDepth(u8 board){
+    return opn2_queue_depth[board & 0x03];
+}
+
 void Genesis_PSGWrite(u8 board, u8 data){
     board &= 0x03;
     //Save chip state
@@ -331,6 +458,15 @@ void Genesis_Reset(u8 board){
     for(i=0; i<sizeof(genesis_t); i++){
         genesis[board].ALL[i] = 0;
     }
+    MIOS32_IRQ_Disable();
+    opn2_queue_start[board] = 0;
+    opn2_queue_depth[board] = 0;
+    opn2_queue_barrier[board] = 0;
+    for(i=0; i<(0x200 / 32); i++){
+        opn2_shadow_valid[board][i] = 0;
+    }
+    opn2_latchedaddr[board] = 0xFFFF;
+    MIOS32_IRQ_Enable();
     for(i=0; i<6; i++){
         genesis[board].opn2.chan[i].lfooutreg = 0xC0; //Output bits initialized to 1
     }
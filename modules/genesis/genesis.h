@@ -54,6 +54,11 @@ OPN2 Timeout Test Results
 #define GENESIS_RESETTIMEOUTUS 1000
 #endif
 
+//Number of pending writes per board in the OPN2 write queue
+#ifndef GENESIS_OPN2_QUEUE_LENGTH
+#define GENESIS_OPN2_QUEUE_LENGTH 64
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Global Types
@@ -410,6 +415,14 @@ typedef union {
     };
 } genesis_t;
 
+typedef struct {
+    u32 queued;      //Writes appended to the queue
+    u32 dropped;     //Writes dropped since the register already had that value
+    u32 coalesced;   //Writes which replaced a pending write to the same register
+    u32 written;     //Queued writes which went out to the chip
+    u32 addrskipped; //Address cycles saved, since the register was still selected
+} genesis_opn2_queuestats_t;
+
 //Sample use cases of these data structures:
 //u8 is_ssg_toggle = genesis[3].opn2.chan[4].op[0].ssg_toggle;
 //u16 psg_freq = genesis[2].psg.square[1].freq;
@@ -422,6 +435,7 @@ typedef union {
 extern genesis_t genesis[GENESIS_COUNT];
 extern u32 genesis_clock_opn2;
 extern u32 genesis_clock_psg;
+extern genesis_opn2_queuestats_t genesis_opn2_queuestats[GENESIS_COUNT];
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -435,6 +449,22 @@ extern void Genesis_Init(void);
 // Write a value to an OPN2.
 extern void Genesis_OPN2Write(u8 board, u8 addrhi, u8 address, u8 data);
 
+// Queue a write to an OPN2. Writes which don't change the register value are
+// dropped, and a pending write to the same register is replaced instead of
+// queueing another one (except for registers where every write matters, like
+// Key On, DAC data, and the frequency latches). The chip state in genesis[] is
+// updated right away. Returns 0 if the queue is full.
+extern u8 Genesis_OPN2QueueWrite(u8 board, u8 addrhi, u8 address, u8 data);
+
+// Write queued values to the OPN2, until one write makes the chip busy. Returns
+// 1 if the chip is busy now, 0 if the queue ran empty with only 0x2x writes
+// (which don't need the busy time). As with Genesis_OPN2Write(), the caller
+// has to make sure the chip isn't busy when calling this.
+extern u8 Genesis_OPN2QueueDrain(u8 board);
+
+// Number of writes pending in the OPN2 write queue.
+extern u8 Genesis_OPN2QueueDepth(u8 board);
+
 // Write a value to a PSG.
 extern void Genesis_PSGWrite(u8 board, u8 data);
 
@@ -2,6 +2,14 @@
 /*
  * MIDI file player
  *
+ * If MID_PARSER_EVENT_BUFFER_SIZE is > 0, MID_PARSER_Read() decodes all
+ * tracks into an event index in RAM, which is sorted by ticks. Each track
+ * is read sequentially, so that the file is only seeked once per track.
+ * MID_PARSER_FetchEvents() takes the events from this index, no file
+ * access is required during playback anymore.
+ * If the file doesn't fit into the buffer, events are read from the file
+ * like before.
+ *
  * ==========================================================================
  *
  *  Copyright (C) 2008 Thorsten Klose (tk@midibox.org)
@@ -46,6 +54,22 @@ typedef struct {
   u8   running_status;
 } midi_track_t;
 
+#if MID_PARSER_EVENT_BUFFER_SIZE
+typedef struct {
+  u32 tick;
+  union {
+    mios32_midi_package_t midi_package; // MIDI event
+    struct {
+      u32 data_offset:24; // Meta event: position of length and data in event buffer
+      u32 meta:8;
+    };
+  };
+  u16 seq;       // read order - keeps events with the same tick in file/track order
+  u8  track;
+  u8  is_meta;
+} mid_parser_event_t;
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Local prototypes
@@ -53,6 +77,10 @@ typedef struct {
 
 static u32 MID_PARSER_ReadWord(u8 len);
 static u32 MID_PARSER_ReadVarLen(u32 *pos);
+static void MID_PARSER_ParseEvent(u8 track, midi_track_t *mt, void *_playevent, void *_playmeta);
+#if MID_PARSER_EVENT_BUFFER_SIZE
+static s32 MID_PARSER_IndexBuild(void);
+#endif
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -69,6 +97,15 @@ static midi_track_t midi_tracks[MID_PARSER_MAX_TRACKS];
 
 static u8 meta_buffer[MID_PARSER_META_BUFFER_SIZE];
 
+#if MID_PARSER_EVENT_BUFFER_SIZE
+static u32 event_buffer[MID_PARSER_EVENT_BUFFER_SIZE/4]; // u32: ensure alignment
+static u8 index_valid;
+static u32 index_num_events;
+static u32 index_pos;
+static u32 index_data_top;
+static u32 index_track_end[MID_PARSER_MAX_TRACKS]; // position behind the last event of a track
+#endif
+
 // callback functions
 static u32 (*mid_parser_read_callback)(void *buffer, u32 len);
 static s32 (*mid_parser_eof_callback)(void);
@@ -84,6 +121,9 @@ s32 MID_PARSER_Init(u32 mode)
 {
   // initial values
   file_valid = 0;
+#if MID_PARSER_EVENT_BUFFER_SIZE
+  index_valid = 0;
+#endif
 
   midi_tracks_num = 0;
 
@@ -134,6 +174,9 @@ s32 MID_PARSER_Read(void)
 
   // invalidate current file
   file_valid = 0;
+#if MID_PARSER_EVENT_BUFFER_SIZE
+  index_valid = 0;
+#endif
 
   if( mid_parser_read_callback == NULL ||
       mid_parser_eof_callback == NULL ||
@@ -242,6 +285,11 @@ s32 MID_PARSER_Read(void)
 
   file_valid = 1;
 
+#if MID_PARSER_EVENT_BUFFER_SIZE
+  // decode all tracks into the event index (if possible)
+  MID_PARSER_IndexBuild();
+#endif
+
   return 0; // no error
 }
 
@@ -290,6 +338,43 @@ s32 MID_PARSER_FetchEvents(u32 tick_offset, u32 num_ticks)
 
   u8 num_tracks_running = 0;
   u8 track = 0;
+
+#if MID_PARSER_EVENT_BUFFER_SIZE
+  if( index_valid ) {
+    mid_parser_event_t *events = (mid_parser_event_t *)event_buffer;
+    u8 *data = (u8 *)event_buffer;
+
+    // tracks which are still running
+    for(track=0; track<midi_tracks_num; ++track)
+      if( index_track_end[track] > index_pos )
+	++num_tracks_running;
+
+    while( index_pos < index_num_events ) {
+      mid_parser_event_t *e = &events[index_pos];
+
+      // exit if next tick is not within given timeframe
+      if( e->tick >= (tick_offset + num_ticks) )
+	break;
+
+      ++index_pos;
+
+      if( e->is_meta ) {
+	if( mid_parser_playmeta_callback != NULL ) {
+	  u32 len = data[e->data_offset] | ((u32)data[e->data_offset+1] << 8);
+	  memcpy(meta_buffer, &data[e->data_offset+2], len);
+	  meta_buffer[len] = 0; // terminate with 0 for the case that a string has been transfered
+	  mid_parser_playmeta_callback(e->track, e->meta, len, meta_buffer, e->tick);
+	}
+      } else {
+	if( mid_parser_playevent_callback != NULL )
+	  mid_parser_playevent_callback(e->track, e->midi_package, e->tick);
+      }
+    }
+
+    return num_tracks_running;
+  }
+#endif
+
   midi_track_t *mt = &midi_tracks[0];
   for(track=0; track<midi_tracks_num; ++mt, ++track) {
     while( mt->file_pos < mt->chunk_end ) {
@@ -305,144 +390,377 @@ s32 MID_PARSER_FetchEvents(u32 tick_offset, u32 num_ticks)
       mid_parser_seek_callback(mt->file_pos);
 
       // get event
-      u8 event;
-      mt->file_pos += mid_parser_read_callback(&event, 1);
+      MID_PARSER_ParseEvent(track, mt, mid_parser_playevent_callback, mid_parser_playmeta_callback);
 
-      if( event == 0xf0 ) { // SysEx event
-	u32 length = (u32)MID_PARSER_ReadVarLen(&mt->file_pos);
-#if DEBUG_VERBOSE_LEVEL >= 3
-	DEBUG_MSG("[MID_PARSER:%d:%u] SysEx event with %u bytes\n\r", track, mt->tick, length);
-#endif
+      // get delta length to next event if end of track hasn't been reached yet
+      if( mt->file_pos < mt->chunk_end ) {
+	u32 delta = (u32)MID_PARSER_ReadVarLen(&mt->file_pos);
+	mt->tick += delta;
+      }
+    }
+  }
 
-	// TODO: use optimized packages for SysEx!
-	mios32_midi_package_t midi_package;
-	midi_package.type = 0xf; // single bytes will be transmitted
+  return num_tracks_running;
+}
 
-	// initial 0xf0
-	midi_package.evnt0 = 0xf0;
-	if( mid_parser_playevent_callback != NULL )
-	  mid_parser_playevent_callback(track, midi_package, mt->tick);
 
-	// remaining bytes
-	int i;
-	for(i=0; i<length; ++i) {
-	  u8 evnt0;
-	  mt->file_pos += mid_parser_read_callback(&evnt0, 1);
-	  midi_package.evnt0 = evnt0;
-	  if( mid_parser_playevent_callback != NULL )
-	    mid_parser_playevent_callback(track, midi_package, mt->tick);
-	}
-      } else if( event == 0xf7 ) { // "Escaped" event (allows to send any MIDI data)
-	u32 length = (u32)MID_PARSER_ReadVarLen(&mt->file_pos);
+
+/////////////////////////////////////////////////////////////////////////////
+// Help function: parses the event at the current file position of a track
+// and forwards it to the given callback functions (which can be NULL)
+/////////////////////////////////////////////////////////////////////////////
+static void MID_PARSER_ParseEvent(u8 track, midi_track_t *mt, void *_playevent, void *_playmeta)
+{
+  s32 (*playevent)(u8 track, mios32_midi_package_t midi_package, u32 tick) = _playevent;
+  s32 (*playmeta)(u8 track, u8 meta, u32 len, u8 *buffer, u32 tick) = _playmeta;
+
+  // get event
+  u8 event;
+  mt->file_pos += mid_parser_read_callback(&event, 1);
+
+  if( event == 0xf0 ) { // SysEx event
+    u32 length = (u32)MID_PARSER_ReadVarLen(&mt->file_pos);
 #if DEBUG_VERBOSE_LEVEL >= 3
-	DEBUG_MSG("[MID_PARSER:%d:%u] Escaped event with %u bytes\n\r", track, mt->tick, length);
+    DEBUG_MSG("[MID_PARSER:%d:%u] SysEx event with %u bytes\n\r", track, mt->tick, length);
 #endif
-	mios32_midi_package_t midi_package;
-	midi_package.type = 0xf; // single bytes will be transmitted
+
+#if MID_PARSER_SYSEX_PACKAGES
+    // the initial 0xf0 and the remaining bytes are sent with SysEx packages (up to 3 bytes per package)
+    mios32_midi_package_t midi_package;
+    u8 bytes[3];
+    u32 num_bytes = 1;
+    bytes[0] = 0xf0;
+    while( 1 ) {
+      u32 len = 3 - num_bytes;
+      if( len > length )
+	len = length;
+      if( len ) {
+	mt->file_pos += mid_parser_read_callback(&bytes[num_bytes], len);
+	num_bytes += len;
+	length -= len;
+      }
+
+      u8 sysex_end = !length && bytes[num_bytes-1] == 0xf7;
+      if( !length && !sysex_end && num_bytes < 3 ) {
+	// SysEx will be continued with an escaped event: send remaining bytes as single bytes
+	midi_package.ALL = 0;
+	midi_package.type = 0xf;
 	int i;
-	for(i=0; i<length; ++i) {
-	  u8 evnt0;
-	  mt->file_pos += mid_parser_read_callback(&evnt0, 1);
-	  midi_package.evnt0 = evnt0;
-	  if( mid_parser_playevent_callback != NULL )
-	    mid_parser_playevent_callback(track, midi_package, mt->tick);
+	for(i=0; i<num_bytes; ++i) {
+	  midi_package.evnt0 = bytes[i];
+	  if( playevent != NULL )
+	    playevent(track, midi_package, mt->tick);
 	}
-      } else if( event == 0xff ) { // Meta Event
-	u8 meta;
-	mt->file_pos += mid_parser_read_callback(&meta, 1);
-	u32 length = (u32)MID_PARSER_ReadVarLen(&mt->file_pos);
+	break;
+      }
 
-	if( mid_parser_playmeta_callback != NULL ) {
-	  u32 buflen = length;
-	  if( buflen > (MID_PARSER_META_BUFFER_SIZE-1) ) {
-	    buflen = MID_PARSER_META_BUFFER_SIZE - 1;
+      midi_package.ALL = 0;
+      midi_package.type = sysex_end ? (0x4 + num_bytes) : 0x4; // 0x4: SysEx starts or continues, 0x5..0x7: SysEx ends with 1..3 bytes
+      midi_package.evnt0 = bytes[0];
+      if( num_bytes >= 2 )
+	midi_package.evnt1 = bytes[1];
+      if( num_bytes >= 3 )
+	midi_package.evnt2 = bytes[2];
+      if( playevent != NULL )
+	playevent(track, midi_package, mt->tick);
+
+      if( !length )
+	break;
+      num_bytes = 0;
+    }
+#else
+    mios32_midi_package_t midi_package;
+    midi_package.ALL = 0;
+    midi_package.type = 0xf; // single bytes will be transmitted
+
+    // initial 0xf0
+    midi_package.evnt0 = 0xf0;
+    if( playevent != NULL )
+      playevent(track, midi_package, mt->tick);
+
+    // remaining bytes
+    int i;
+    for(i=0; i<length; ++i) {
+      u8 evnt0;
+      mt->file_pos += mid_parser_read_callback(&evnt0, 1);
+      midi_package.evnt0 = evnt0;
+      if( playevent != NULL )
+	playevent(track, midi_package, mt->tick);
+    }
+#endif
+  } else if( event == 0xf7 ) { // "Escaped" event (allows to send any MIDI data)
+    u32 length = (u32)MID_PARSER_ReadVarLen(&mt->file_pos);
+#if DEBUG_VERBOSE_LEVEL >= 3
+    DEBUG_MSG("[MID_PARSER:%d:%u] Escaped event with %u bytes\n\r", track, mt->tick, length);
+#endif
+    mios32_midi_package_t midi_package;
+    midi_package.ALL = 0;
+    midi_package.type = 0xf; // single bytes will be transmitted
+    int i;
+    for(i=0; i<length; ++i) {
+      u8 evnt0;
+      mt->file_pos += mid_parser_read_callback(&evnt0, 1);
+      midi_package.evnt0 = evnt0;
+      if( playevent != NULL )
+	playevent(track, midi_package, mt->tick);
+    }
+  } else if( event == 0xff ) { // Meta Event
+    u8 meta;
+    mt->file_pos += mid_parser_read_callback(&meta, 1);
+    u32 length = (u32)MID_PARSER_ReadVarLen(&mt->file_pos);
+
+    u32 buflen = length;
+    if( buflen > (MID_PARSER_META_BUFFER_SIZE-1) ) {
+      buflen = MID_PARSER_META_BUFFER_SIZE - 1;
 #if DEBUG_VERBOSE_LEVEL >= 2
-	    DEBUG_MSG("[MID_PARSER:%d:%u] Meta Event 0x%02x with %u bytes - cut at %u bytes!\n\r", track, mt->tick, meta, length, buflen);
+      DEBUG_MSG("[MID_PARSER:%d:%u] Meta Event 0x%02x with %u bytes - cut at %u bytes!\n\r", track, mt->tick, meta, length, buflen);
 #endif
-	  } else {
+    } else {
 #if DEBUG_VERBOSE_LEVEL >= 3
-	    DEBUG_MSG("[MID_PARSER:%d:%u] Meta Event 0x%02x with %u bytes\n\r", track, mt->tick, meta, buflen);
+      DEBUG_MSG("[MID_PARSER:%d:%u] Meta Event 0x%02x with %u bytes\n\r", track, mt->tick, meta, buflen);
 #endif
-	  }
-
-	  if( buflen ) {
-	    // copy bytes into buffer
-	    mt->file_pos += mid_parser_read_callback(meta_buffer, buflen);
-
-	    if( length > buflen ) {
-	      // no free memory: dummy reads
-	      int i;
-	      u8 dummy;
-	      for(i=buflen; i<length; ++i)
-		mt->file_pos += mid_parser_read_callback(&dummy, 1);
-	    }
-	  }
-
-	  meta_buffer[buflen] = 0; // terminate with 0 for the case that a string has been transfered
-	  
-	  // -> forward to callback function
-	  mid_parser_playmeta_callback(track, meta, buflen, meta_buffer, mt->tick);
-	}
-      } else { // common MIDI event
-	mios32_midi_package_t midi_package;
-
-	if( event & 0x80 ) {
-	  mt->running_status = event;
-	  midi_package.evnt0 = event;
-	  u8 evnt1;
-	  mt->file_pos += mid_parser_read_callback(&evnt1, 1);
-	  midi_package.evnt1 = evnt1;
-	} else {
-	  midi_package.evnt0 = mt->running_status;
-	  midi_package.evnt1 = event;
-	}
-	midi_package.type = midi_package.event;
-
-	switch( midi_package.event ) {
-	  case NoteOff:
-	  case NoteOn:
-	  case PolyPressure:
-	  case CC:
-	  case PitchBend:
-	  {
-	    u8 evnt2;
-	    mt->file_pos += mid_parser_read_callback(&evnt2, 1);
-	    midi_package.evnt2 = evnt2;
-
-	    if( mid_parser_playevent_callback != NULL )
-	      mid_parser_playevent_callback(track, midi_package, mt->tick);
+    }
+
+    // the bytes are read even if no callback is installed, so that the file position is correct
+    if( buflen ) {
+      // copy bytes into buffer
+      mt->file_pos += mid_parser_read_callback(meta_buffer, buflen);
+
+      if( length > buflen ) {
+	// no free memory: dummy reads
+	int i;
+	u8 dummy;
+	for(i=buflen; i<length; ++i)
+	  mt->file_pos += mid_parser_read_callback(&dummy, 1);
+      }
+    }
+
+    meta_buffer[buflen] = 0; // terminate with 0 for the case that a string has been transfered
+
+    // -> forward to callback function
+    if( playmeta != NULL )
+      playmeta(track, meta, buflen, meta_buffer, mt->tick);
+  } else { // common MIDI event
+    mios32_midi_package_t midi_package;
+    midi_package.ALL = 0;
+
+    if( event & 0x80 ) {
+      mt->running_status = event;
+      midi_package.evnt0 = event;
+      u8 evnt1;
+      mt->file_pos += mid_parser_read_callback(&evnt1, 1);
+      midi_package.evnt1 = evnt1;
+    } else {
+      midi_package.evnt0 = mt->running_status;
+      midi_package.evnt1 = event;
+    }
+    midi_package.type = midi_package.event;
+
+    switch( midi_package.event ) {
+      case NoteOff:
+      case NoteOn:
+      case PolyPressure:
+      case CC:
+      case PitchBend:
+      {
+	u8 evnt2;
+	mt->file_pos += mid_parser_read_callback(&evnt2, 1);
+	midi_package.evnt2 = evnt2;
+
+	if( playevent != NULL )
+	  playevent(track, midi_package, mt->tick);
 #if DEBUG_VERBOSE_LEVEL >= 3
-	    DEBUG_MSG("[MID_PARSER:%d:%u] %02x%02x%02x\n\r", track, mt->tick, midi_package.evnt0, midi_package.evnt1, midi_package.evnt2);
+	DEBUG_MSG("[MID_PARSER:%d:%u] %02x%02x%02x\n\r", track, mt->tick, midi_package.evnt0, midi_package.evnt1, midi_package.evnt2);
 #endif
-	  }
-	  break;
-	  case ProgramChange:
-	  case Aftertouch:
-	    if( mid_parser_playevent_callback != NULL )
-	      mid_parser_playevent_callback(track, midi_package, mt->tick);
+      }
+      break;
+      case ProgramChange:
+      case Aftertouch:
+	if( playevent != NULL )
+	  playevent(track, midi_package, mt->tick);
 #if DEBUG_VERBOSE_LEVEL >= 3
-	    DEBUG_MSG("[MID_PARSER:%d:%u] %02x%02x\n\r", track, mt->tick, midi_package.evnt0, midi_package.evnt1);
+	DEBUG_MSG("[MID_PARSER:%d:%u] %02x%02x\n\r", track, mt->tick, midi_package.evnt0, midi_package.evnt1);
 #endif
-	    break;
-	  default:
+	break;
+      default:
 #if DEBUG_VERBOSE_LEVEL >= 1
-	    DEBUG_MSG("[MID_PARSER:%d:%u] ooops? got 0xf0 status in MIDI event stream!\n\r", track, mt->tick);
+	DEBUG_MSG("[MID_PARSER:%d:%u] ooops? got 0xf0 status in MIDI event stream!\n\r", track, mt->tick);
 #endif
-	    break;
-	}
-      }
+	break;
+    }
+  }
+}
+
+
+#if MID_PARSER_EVENT_BUFFER_SIZE
+/////////////////////////////////////////////////////////////////////////////
+// Help functions for the event index
+/////////////////////////////////////////////////////////////////////////////
+
+// allocates a new event, and <data_len> bytes at the end of the event buffer
+// returns NULL (and invalidates the index) if the buffer is full
+static mid_parser_event_t *MID_PARSER_IndexAlloc(u32 data_len)
+{
+  if( !index_valid || index_num_events >= 0x10000 ||
+      ((index_num_events+1) * sizeof(mid_parser_event_t) + data_len) > index_data_top ) {
+    index_valid = 0;
+    return NULL;
+  }
+
+  mid_parser_event_t *e = &((mid_parser_event_t *)event_buffer)[index_num_events];
+  e->seq = index_num_events;
+  ++index_num_events;
+  index_data_top -= data_len;
+
+  return e;
+}
+
+// called by MID_PARSER_ParseEvent() while the index is built
+static s32 MID_PARSER_IndexEvent(u8 track, mios32_midi_package_t midi_package, u32 tick)
+{
+  mid_parser_event_t *e = MID_PARSER_IndexAlloc(0);
+  if( e == NULL )
+    return -1; // buffer full
+
+  e->tick = tick;
+  e->midi_package = midi_package;
+  e->track = track;
+  e->is_meta = 0;
+
+  return 0; // no error
+}
+
+// called by MID_PARSER_ParseEvent() while the index is built
+static s32 MID_PARSER_IndexMeta(u8 track, u8 meta, u32 len, u8 *buffer, u32 tick)
+{
+  // data: 2 bytes length, followed by meta bytes
+  mid_parser_event_t *e = MID_PARSER_IndexAlloc(2 + len);
+  if( e == NULL )
+    return -1; // buffer full
+
+  u8 *data = (u8 *)event_buffer + index_data_top;
+  data[0] = len & 0xff;
+  data[1] = len >> 8;
+  memcpy(&data[2], buffer, len);
+
+  e->tick = tick;
+  e->data_offset = index_data_top;
+  e->meta = meta;
+  e->track = track;
+  e->is_meta = 1;
+
+  return 0; // no error
+}
+
+// sort order: tick, and read order for events with the same tick
+static inline u8 MID_PARSER_IndexLess(mid_parser_event_t *a, mid_parser_event_t *b)
+{
+  return a->tick < b->tick || (a->tick == b->tick && a->seq < b->seq);
+}
+
+static void MID_PARSER_IndexSiftDown(mid_parser_event_t *events, u32 root, u32 num)
+{
+  while( 1 ) {
+    u32 child = 2*root + 1;
+    if( child >= num )
+      break;
+
+    if( (child+1) < num && MID_PARSER_IndexLess(&events[child], &events[child+1]) )
+      ++child;
+
+    if( !MID_PARSER_IndexLess(&events[root], &events[child]) )
+      break;
+
+    mid_parser_event_t tmp = events[root];
+    events[root] = events[child];
+    events[child] = tmp;
+    root = child;
+  }
+}
+
+// heap sort, works in place
+static void MID_PARSER_IndexSort(mid_parser_event_t *events, u32 num)
+{
+  u32 i;
+
+  // already sorted? (e.g. format 0 files)
+  for(i=1; i<num; ++i)
+    if( MID_PARSER_IndexLess(&events[i], &events[i-1]) )
+      break;
+  if( i >= num )
+    return;
+
+  for(i=num/2; i>0; --i)
+    MID_PARSER_IndexSiftDown(events, i-1, num);
+
+  for(i=num-1; i>0; --i) {
+    mid_parser_event_t tmp = events[0];
+    events[0] = events[i];
+    events[i] = tmp;
+    MID_PARSER_IndexSiftDown(events, 0, i);
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Decodes all tracks into the event index
+// returns < 0 if the events don't fit into the buffer
+/////////////////////////////////////////////////////////////////////////////
+static s32 MID_PARSER_IndexBuild(void)
+{
+  index_valid = 1; // will be cleared by MID_PARSER_IndexAlloc() if the buffer is full
+  index_num_events = 0;
+  index_pos = 0;
+  index_data_top = sizeof(event_buffer);
+
+  u8 track = 0;
+  midi_track_t *mt = &midi_tracks[0];
+  for(track=0; track<midi_tracks_num; ++mt, ++track) {
+    // parse a copy, the track position is still required for the file based fallback
+    midi_track_t t = *mt;
+    t.file_pos = t.initial_file_pos;
+    t.tick = t.initial_tick;
+    t.running_status = 0x80;
+
+    // the events of a track are read sequentially
+    mid_parser_seek_callback(t.file_pos);
+    while( index_valid && t.file_pos < t.chunk_end && !mid_parser_eof_callback() ) {
+      MID_PARSER_ParseEvent(track, &t, MID_PARSER_IndexEvent, MID_PARSER_IndexMeta);
 
       // get delta length to next event if end of track hasn't been reached yet
-      if( mt->file_pos < mt->chunk_end ) {
-	u32 delta = (u32)MID_PARSER_ReadVarLen(&mt->file_pos);
-	mt->tick += delta;
+      if( t.file_pos < t.chunk_end ) {
+	u32 delta = (u32)MID_PARSER_ReadVarLen(&t.file_pos);
+	t.tick += delta;
       }
     }
+
+    if( !index_valid ) {
+#if DEBUG_VERBOSE_LEVEL >= 1
+      DEBUG_MSG("[MID_PARSER] event index: buffer full at track %d - events will be read from file\n\r", track+1);
+#endif
+      return -1; // buffer full
+    }
   }
 
-  return num_tracks_running;
-}
+  // merge the tracks
+  mid_parser_event_t *events = (mid_parser_event_t *)event_buffer;
+  MID_PARSER_IndexSort(events, index_num_events);
 
+  // determine the position behind the last event of each track
+  u32 i;
+  for(i=0; i<midi_tracks_num; ++i)
+    index_track_end[i] = 0;
+  for(i=0; i<index_num_events; ++i)
+    index_track_end[events[i].track] = i + 1;
+
+#if DEBUG_VERBOSE_LEVEL >= 1
+  DEBUG_MSG("[MID_PARSER] event index: %u events, %u bytes\n\r",
+	    index_num_events, index_num_events * sizeof(mid_parser_event_t) + (sizeof(event_buffer) - index_data_top));
+#endif
+
+  return 0; // no error
+}
+#endif
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -500,6 +818,10 @@ s32 MID_PARSER_RestartSong(void)
     mt->running_status = 0x80;
   }
 
+#if MID_PARSER_EVENT_BUFFER_SIZE
+  index_pos = 0;
+#endif
+
   return 0; // no error
 }
 
@@ -27,6 +27,22 @@
 #define MID_PARSER_META_BUFFER_SIZE 80
 #endif
 
+// optional buffer for the event index in bytes (12 bytes per event + meta data)
+// if the MIDI file fits into this buffer, MID_PARSER_Read() decodes all tracks into
+// a tick sorted event list, and MID_PARSER_FetchEvents() doesn't access the file anymore
+// 0: disabled, events are always read from file
+#ifndef MID_PARSER_EVENT_BUFFER_SIZE
+#define MID_PARSER_EVENT_BUFFER_SIZE 0
+#endif
+
+// SysEx events are forwarded to the playevent callback:
+// 0: as single bytes (package type 0xf), so that the application can bypass them
+// 1: as SysEx packages (type 0x4..0x7, up to 3 bytes per package) - the callback
+//    has to handle these package types
+#ifndef MID_PARSER_SYSEX_PACKAGES
+#define MID_PARSER_SYSEX_PACKAGES 0
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Global Types
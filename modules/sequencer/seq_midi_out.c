@@ -48,7 +48,11 @@ typedef struct seq_midi_out_queue_item_t {
   u16                   len;
   mios32_midi_package_t package;
   u32                   timestamp;
+#if SEQ_MIDI_OUT_SCHEDULER == 1
+  u32                   order; // insertion counter, sorts items of same timestamp and priority
+#else
   struct seq_midi_out_queue_item_t *next;
+#endif
 } seq_midi_out_queue_item_t;
 
 
@@ -59,6 +63,17 @@ typedef struct seq_midi_out_queue_item_t {
 static seq_midi_out_queue_item_t *SEQ_MIDI_OUT_SlotMalloc(void);
 static void SEQ_MIDI_OUT_SlotFree(seq_midi_out_queue_item_t *item);
 
+static s32 SEQ_MIDI_OUT_QueueInsert(seq_midi_out_queue_item_t *new_item);
+static seq_midi_out_queue_item_t *SEQ_MIDI_OUT_QueueFirst(void);
+static void SEQ_MIDI_OUT_QueueRemoveFirst(void);
+
+#if SEQ_MIDI_OUT_SCHEDULER == 1
+static u8 SEQ_MIDI_OUT_HeapBefore(seq_midi_out_queue_item_t *a, seq_midi_out_queue_item_t *b);
+static u32 SEQ_MIDI_OUT_HeapSiftDown(u32 pos, seq_midi_out_queue_item_t *item);
+static u8 SEQ_MIDI_OUT_ReScheduleMatch(seq_midi_out_queue_item_t *item, seq_midi_out_event_type_t event_type, u32 *reschedule_filter);
+static u32 SEQ_MIDI_OUT_DelayedTimestamp(mios32_midi_port_t port, u32 timestamp);
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Global variables
@@ -73,6 +88,16 @@ u32 seq_midi_out_max_allocated;
 u32 seq_midi_out_dropouts;
 #endif
 
+//! only for analysis purposes - has to be enabled with SEQ_MIDI_OUT_SCHEDULER_ANALYSIS
+#if SEQ_MIDI_OUT_SCHEDULER_ANALYSIS
+u32 seq_midi_out_sched_inserts;
+u32 seq_midi_out_sched_insert_steps;
+u32 seq_midi_out_sched_insert_steps_max;
+u32 seq_midi_out_sched_dispatches;
+u32 seq_midi_out_sched_dispatch_steps;
+u32 seq_midi_out_sched_dispatch_steps_max;
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Local variables
@@ -83,7 +108,28 @@ static s32 (*callback_bpm_is_running)(void);
 static u32 (*callback_bpm_tick_get)(void);
 static s32 (*callback_bpm_set)(float bpm);
 
+#if SEQ_MIDI_OUT_SCHEDULER == 1
+// binary heap: the item with the earliest timestamp is located at sched_heap[0]
+static seq_midi_out_queue_item_t *sched_heap[SEQ_MIDI_OUT_MAX_EVENTS];
+static u32 sched_heap_size;
+static u32 sched_order;
+
+// tag index: number of queued items for each tag (mios32_midi_package_t.cable)
+static u16 sched_tag_count[16];
+
+// priority of events with the same timestamp (indexed with seq_midi_out_event_type_t)
+// Clock and Tempo events are sent first, then Off events, then CCs, and finally On events
+static const u8 sched_event_priority[6] = {
+  0, // SEQ_MIDI_OUT_ClkEvent
+  0, // SEQ_MIDI_OUT_TempoEvent
+  2, // SEQ_MIDI_OUT_CCEvent
+  3, // SEQ_MIDI_OUT_OnEvent
+  1, // SEQ_MIDI_OUT_OffEvent
+  3, // SEQ_MIDI_OUT_OnOffEvent
+};
+#else
 static seq_midi_out_queue_item_t *midi_queue;
+#endif
 
 
 #if SEQ_MIDI_OUT_MALLOC_METHOD >= 0 && SEQ_MIDI_OUT_MALLOC_METHOD <= 3
@@ -110,6 +156,13 @@ static seq_midi_out_queue_item_t *midi_queue;
 // Note: we could easily provide an option for static heap allocation as well
 static seq_midi_out_queue_item_t *alloc_heap;
 static u32 alloc_pos;
+#elif SEQ_MIDI_OUT_MALLOC_METHOD == 6
+
+// free-list slab: indices of free slots are stacked, so that allocation and
+// release are done in constant time
+static seq_midi_out_queue_item_t *alloc_heap;
+static u16 alloc_free_stack[SEQ_MIDI_OUT_MAX_EVENTS];
+static u32 alloc_free_num;
 #endif
 
 #if SEQ_MIDI_OUT_SUPPORT_DELAY
@@ -141,6 +194,14 @@ s32 SEQ_MIDI_OUT_Init(u32 mode)
   seq_midi_out_max_allocated = 0;
   seq_midi_out_dropouts = 0;
 #endif
+#if SEQ_MIDI_OUT_SCHEDULER_ANALYSIS
+  seq_midi_out_sched_inserts = 0;
+  seq_midi_out_sched_insert_steps = 0;
+  seq_midi_out_sched_insert_steps_max = 0;
+  seq_midi_out_sched_dispatches = 0;
+  seq_midi_out_sched_dispatch_steps = 0;
+  seq_midi_out_sched_dispatch_steps_max = 0;
+#endif
 
   // memory will be allocated with first event
   SEQ_MIDI_OUT_FreeHeap();
@@ -323,7 +384,6 @@ s32 SEQ_MIDI_OUT_Send(mios32_midi_port_t port, mios32_midi_package_t midi_packag
     new_item->event_type = event_type;
     new_item->timestamp = timestamp;
     new_item->len = len;
-    new_item->next = NULL;
   }
 
 #if DEBUG_VERBOSE_LEVEL >= 2
@@ -333,73 +393,10 @@ s32 SEQ_MIDI_OUT_Send(mios32_midi_port_t port, mios32_midi_package_t midi_packag
   DEBUG_MSG("[SEQ_MIDI_OUT_Send:%u] (tag %d) %02x %02x %02x len:%u @%u\n", timestamp, midi_package.cable, midi_package.evnt0, midi_package.evnt1, midi_package.evnt2, len, SEQ_BPM_TickGet());
 #endif
 
-  // search in queue for last item which has the same (or earlier) timestamp
-  seq_midi_out_queue_item_t *item;
-  if( (item=midi_queue) == NULL ) {
-    // no item in queue -- first element
-    midi_queue = new_item;
-  } else {
-    u8 insert_before_item = 0;
-    seq_midi_out_queue_item_t *last_item = NULL;
-    seq_midi_out_queue_item_t *next_item;
-    do {
-      // Clock and Tempo events are sorted before CC and Note events at a given timestamp
-      if( (event_type == SEQ_MIDI_OUT_ClkEvent || event_type == SEQ_MIDI_OUT_TempoEvent ) && 
-	  item->timestamp >= timestamp &&
-	  (item->event_type == SEQ_MIDI_OUT_OnEvent || 
-	   item->event_type == SEQ_MIDI_OUT_OffEvent || 
-	   item->event_type == SEQ_MIDI_OUT_OnOffEvent || 
-	   item->event_type == SEQ_MIDI_OUT_CCEvent) ) {
-	// found any event with same timestamp, insert clock before these events
-	// note that the Clock event order doesn't get lost if clock events 
-	// are queued at the same timestamp (e.g. MIDI start -> MIDI clock)
-	insert_before_item = 1;
-	break;
-      }
-
-      // CCs are sorted before notes at a given timestamp
-      // (new CC before On events at the same timestamp)
-      // CCs are still played after Off or Clock events
-      if( event_type == SEQ_MIDI_OUT_CCEvent && 
-	  item->timestamp == timestamp &&
-	  (item->event_type == SEQ_MIDI_OUT_OnEvent || item->event_type == SEQ_MIDI_OUT_OnOffEvent) ) {
-	// found On event with same timestamp, play CC before On event
-	insert_before_item = 1;
-	break;
-      }
-
-      if( item->timestamp > timestamp ) {
-	// found entry with later timestamp
-	insert_before_item = 1;
-	break;
-      }
-
-      if( (next_item=item->next) == NULL ) {
-	// end of queue reached, insert new item at the end
-	break;
-      }
-	
-      if( next_item->timestamp > timestamp ) {
-	// found entry with later timestamp
-	break;
-      }
-
-      // switch to next item
-      last_item = item;
-      item = next_item;
-    } while( 1 );
-
-    // insert/add item into/to list
-    if( insert_before_item ) {
-      if( last_item == NULL )
-	midi_queue = new_item;
-      else
-	last_item->next = new_item;
-      new_item->next = item;
-    } else {
-      item->next = new_item;
-      new_item->next = next_item;
-    }
+  // insert item into queue
+  if( SEQ_MIDI_OUT_QueueInsert(new_item) < 0 ) {
+    SEQ_MIDI_OUT_SlotFree(new_item);
+    return -1; // allocation error
   }
 
   // schedule off event now if length > 16bit (since it cannot be stored in event record)
@@ -408,9 +405,9 @@ s32 SEQ_MIDI_OUT_Send(mios32_midi_port_t port, mios32_midi_package_t midi_packag
   }
 
   // display queue
-#if DEBUG_VERBOSE_LEVEL >= 4
+#if DEBUG_VERBOSE_LEVEL >= 4 && SEQ_MIDI_OUT_SCHEDULER == 0
   DEBUG_MSG("--- vvv ---\n");
-  item=midi_queue;
+  seq_midi_out_queue_item_t *item=midi_queue;
   while( item != NULL ) {
     DEBUG_MSG("[%u] (tag %d) %02x %02x %02x len:%u @%u\n", item->timestamp, item->package.cable, item->package.evnt0, item->package.evnt1, item->package.evnt2, item->len, SEQ_BPM_TickGet());
     item = item->next;
@@ -448,6 +445,60 @@ s32 SEQ_MIDI_OUT_Send(mios32_midi_port_t port, mios32_midi_package_t midi_packag
 /////////////////////////////////////////////////////////////////////////////
 s32 SEQ_MIDI_OUT_ReSchedule(u8 tag, seq_midi_out_event_type_t event_type, u32 timestamp, u32 *reschedule_filter)
 {
+#if SEQ_MIDI_OUT_SCHEDULER == 1
+  // the tag index allows us to skip the search if no item has been queued with this tag
+  if( !sched_tag_count[tag & 0xf] )
+    return 0; // nothing to do
+
+  // like in the queue, the search ends at the first matching event which will be played with
+  // the next invocation of the Out Handler (to avoid, that a re-scheduled event will be checked again)
+  // since the heap isn't sorted, this item has to be determined first
+  seq_midi_out_queue_item_t *stop_item = NULL;
+  u32 num_tagged = sched_tag_count[tag & 0xf];
+  u32 i;
+  for(i=0; i<sched_heap_size && num_tagged; ++i) {
+    seq_midi_out_queue_item_t *item = sched_heap[i];
+    if( item->package.cable != tag )
+      continue;
+    --num_tagged;
+
+    if( SEQ_MIDI_OUT_ReScheduleMatch(item, event_type, reschedule_filter) &&
+	item->timestamp <= SEQ_MIDI_OUT_DelayedTimestamp(item->port, timestamp) &&
+	(stop_item == NULL || SEQ_MIDI_OUT_HeapBefore(item, stop_item)) )
+      stop_item = item;
+  }
+
+  // matching items which are sent before the stop item are re-keyed in place
+  // (none of them is due), the heap will be restored once at the end
+  u8 heap_modified = 0;
+  num_tagged = sched_tag_count[tag & 0xf];
+  for(i=0; i<sched_heap_size && num_tagged; ++i) {
+    seq_midi_out_queue_item_t *item = sched_heap[i];
+    if( item->package.cable != tag )
+      continue;
+    --num_tagged;
+
+    if( SEQ_MIDI_OUT_ReScheduleMatch(item, event_type, reschedule_filter) &&
+	(stop_item == NULL || SEQ_MIDI_OUT_HeapBefore(item, stop_item)) ) {
+#if DEBUG_VERBOSE_LEVEL >= 2
+      DEBUG_MSG("[SEQ_MIDI_OUT_ReSchedule:%u] (tag %d) %02x %02x %02x @%u\n", timestamp, item->package.cable, item->package.evnt0, item->package.evnt1, item->package.evnt2, SEQ_BPM_TickGet());
+#endif
+
+      // re-schedule item at new timestamp (sorted like a new item)
+      item->timestamp = SEQ_MIDI_OUT_DelayedTimestamp(item->port, timestamp);
+      item->order = sched_order++;
+      heap_modified = 1;
+    }
+  }
+
+  if( heap_modified ) {
+    // restore heap property
+    s32 pos;
+    for(pos=(s32)(sched_heap_size/2)-1; pos>=0; --pos) {
+      SEQ_MIDI_OUT_HeapSiftDown(pos, sched_heap[pos]);
+    }
+  }
+#else
   // search in queue for items with the given tag
 
   seq_midi_out_queue_item_t *prev_item = NULL;
@@ -535,10 +586,108 @@ s32 SEQ_MIDI_OUT_ReSchedule(u8 tag, seq_midi_out_event_type_t event_type, u32 ti
       item = item->next;
     }
   }
+#endif
 
   return 0; // no error
 }
 
+/////////////////////////////////////////////////////////////////////////////
+//! This function removes On, OnOff and CC events assigned to a given "tag"
+//! (0..15, stored in mios32_midi_package_t.cable) which are scheduled after
+//! the given timestamp.
+//!
+//! Off events are kept, so that notes which already have been played will
+//! be released as usual.
+//!
+//! Usecase: events which have been generated ahead of time (lookahead) can
+//! be withdrawn if they are not valid anymore, e.g. because the track has
+//! been muted meanwhile.
+//!
+//! \param[in] tag (0..15) the mios32_midi_package.t.cable number of events which should be removed
+//! \param[in] timestamp only events which should be sent after this bpm_tick will be removed
+//! \return the number of removed events
+/////////////////////////////////////////////////////////////////////////////
+s32 SEQ_MIDI_OUT_Cancel(u8 tag, u32 timestamp)
+{
+  s32 num_removed = 0;
+
+#if SEQ_MIDI_OUT_SCHEDULER == 1
+  // the tag index allows us to skip the search if no item has been queued with this tag
+  u32 num_tagged = sched_tag_count[tag & 0xf];
+  if( !num_tagged )
+    return 0; // nothing to do
+
+  // matching items are replaced by the last item of the heap,
+  // the heap will be restored once at the end
+  u32 i = 0;
+  while( i<sched_heap_size && num_tagged ) {
+    seq_midi_out_queue_item_t *item = sched_heap[i];
+    if( item->package.cable != tag ) {
+      ++i;
+      continue;
+    }
+    --num_tagged;
+
+    if( item->timestamp <= timestamp ||
+	(item->event_type != SEQ_MIDI_OUT_OnEvent &&
+	 item->event_type != SEQ_MIDI_OUT_OnOffEvent &&
+	 item->event_type != SEQ_MIDI_OUT_CCEvent) ) {
+      ++i;
+      continue;
+    }
+
+    // remove item (the last item will be checked with the next iteration)
+    sched_heap[i] = sched_heap[--sched_heap_size];
+    --sched_tag_count[tag];
+    SEQ_MIDI_OUT_SlotFree(item);
+    ++num_removed;
+  }
+
+  if( num_removed ) {
+    // restore heap property
+    s32 pos;
+    for(pos=(s32)(sched_heap_size/2)-1; pos>=0; --pos) {
+      SEQ_MIDI_OUT_HeapSiftDown(pos, sched_heap[pos]);
+    }
+  }
+#else
+  seq_midi_out_queue_item_t *prev_item = NULL;
+  seq_midi_out_queue_item_t *item = midi_queue;
+  while( item != NULL ) {
+    if( item->package.cable == tag && item->timestamp > timestamp &&
+	(item->event_type == SEQ_MIDI_OUT_OnEvent ||
+	 item->event_type == SEQ_MIDI_OUT_OnOffEvent ||
+	 item->event_type == SEQ_MIDI_OUT_CCEvent) ) {
+      // remove item from queue
+      seq_midi_out_queue_item_t *next_item = item->next;
+      SEQ_MIDI_OUT_SlotFree(item);
+      item = next_item;
+
+      // fix link to next item
+      if( prev_item == NULL ) {
+	midi_queue = item;
+      } else {
+	prev_item->next = item;
+      }
+
+      ++num_removed;
+    } else {
+      // switch to next item
+      prev_item = item;
+      item = item->next;
+    }
+  }
+#endif
+
+#if DEBUG_VERBOSE_LEVEL >= 2
+  if( num_removed ) {
+    DEBUG_MSG("[SEQ_MIDI_OUT_Cancel:%u] (tag %d) removed %d events @%u\n", timestamp, tag, num_removed, SEQ_BPM_TickGet());
+  }
+#endif
+
+  return num_removed;
+}
+
 
 /////////////////////////////////////////////////////////////////////////////
 //! This function empties the queue and plays all "off" events
@@ -547,13 +696,14 @@ s32 SEQ_MIDI_OUT_ReSchedule(u8 tag, seq_midi_out_event_type_t event_type, u32 ti
 s32 SEQ_MIDI_OUT_FlushQueue(void)
 {
   seq_midi_out_queue_item_t *item;
-  while( (item=midi_queue) != NULL ) {
+  while( (item=SEQ_MIDI_OUT_QueueFirst()) != NULL ) {
+    SEQ_MIDI_OUT_QueueRemoveFirst();
+
     if( item->event_type == SEQ_MIDI_OUT_OffEvent || item->event_type == SEQ_MIDI_OUT_OnOffEvent ) {
       item->package.velocity = 0; // ensure that velocity is 0
       callback_midi_send_package(item->port, item->package);
     }
 
-    midi_queue = item->next;
     SEQ_MIDI_OUT_SlotFree(item);
   }
 
@@ -569,8 +719,8 @@ s32 SEQ_MIDI_OUT_FreeHeap(void)
 {
   // ensure that all items are delocated
   seq_midi_out_queue_item_t *item;
-  while( (item=midi_queue) != NULL ) {
-    midi_queue = item->next;
+  while( (item=SEQ_MIDI_OUT_QueueFirst()) != NULL ) {
+    SEQ_MIDI_OUT_QueueRemoveFirst();
     SEQ_MIDI_OUT_SlotFree(item);
   }
 
@@ -579,6 +729,17 @@ s32 SEQ_MIDI_OUT_FreeHeap(void)
   // not relevant
 #elif SEQ_MIDI_OUT_MALLOC_METHOD == 5
   // not relevant
+#elif SEQ_MIDI_OUT_MALLOC_METHOD == 6
+  // stack will be filled once the heap has been allocated again
+  MIOS32_IRQ_Disable();
+  seq_midi_out_queue_item_t *heap = alloc_heap;
+  alloc_heap = NULL;
+  alloc_free_num = 0;
+  seq_midi_out_allocated = 0;
+  MIOS32_IRQ_Enable();
+
+  if( heap != NULL )
+    vPortFree(heap);
 #else
   if( alloc_heap != NULL ) {
     vPortFree(alloc_heap);
@@ -610,11 +771,11 @@ s32 SEQ_MIDI_OUT_Handler(void)
     return 0;
 
   // search in queue for items which have to be played now (or have been missed earlier)
-  // note that we are going through a sorted list, therefore we can exit once a timestamp
+  // note that we are going through a sorted queue, therefore we can exit once a timestamp
   // has been found which has to be played later than now
 
   seq_midi_out_queue_item_t *item;
-  while( (item=midi_queue) != NULL && item->timestamp <= callback_bpm_tick_get() ) {
+  while( (item=SEQ_MIDI_OUT_QueueFirst()) != NULL && item->timestamp <= callback_bpm_tick_get() ) {
 #if DEBUG_VERBOSE_LEVEL >= 2
 #if DEBUG_VERBOSE_LEVEL == 2
     if( item->event_type != SEQ_MIDI_OUT_ClkEvent )
@@ -622,6 +783,9 @@ s32 SEQ_MIDI_OUT_Handler(void)
     DEBUG_MSG("[SEQ_MIDI_OUT_Handler:%u] (tag %d) %02x %02x %02x @%u\n", item->timestamp, item->package.cable, item->package.evnt0, item->package.evnt1, item->package.evnt2, SEQ_BPM_TickGet());
 #endif
 
+    // remove item from queue before the callbacks are executed, so that they are allowed to schedule new events
+    SEQ_MIDI_OUT_QueueRemoveFirst();
+
     // if tempo event: change BPM stored in midi_package.ALL
     if( item->event_type == SEQ_MIDI_OUT_TempoEvent ) {
       callback_bpm_set(item->package.ALL);
@@ -632,29 +796,17 @@ s32 SEQ_MIDI_OUT_Handler(void)
     // schedule Off event if requested
     if( item->event_type == SEQ_MIDI_OUT_OnOffEvent && item->len ) {
       // ensure that we get a free memory slot by releasing the current item before queuing the off item
-#if 0
-      seq_midi_out_queue_item_t copy = *item;
-#else
-      // ???
-      seq_midi_out_queue_item_t copy;
-      copy.port = item->port;
-      copy.event_type = item->event_type;
-      copy.len = item->len;
-      copy.package.ALL = item->package.ALL;
-      copy.timestamp = item->timestamp;
-      copy.next = item->next;
-#endif
-      copy.package.velocity = 0; // ensure that velocity is 0
+      mios32_midi_port_t port = item->port;
+      mios32_midi_package_t package = item->package;
+      package.velocity = 0; // ensure that velocity is 0
+      u32 delayed_timestamp = item->len + item->timestamp;
 
-      // remove item from queue
-      midi_queue = item->next;
       SEQ_MIDI_OUT_SlotFree(item);
 
-      u32 delayed_timestamp = copy.len + copy.timestamp;
 #if SEQ_MIDI_OUT_SUPPORT_DELAY
       // revert timestamp delay (will be added again by SEQ_MIDI_OUT_Send())
-      if( copy.port < PPQN_DELAY_NUM ) {
-	s8 delay = ppqn_delay[copy.port];
+      if( port < PPQN_DELAY_NUM ) {
+	s8 delay = ppqn_delay[port];
 	if( (delay > 0) && (delayed_timestamp < delay) ) {
 	  delayed_timestamp = 0;
 	} else {
@@ -663,10 +815,8 @@ s32 SEQ_MIDI_OUT_Handler(void)
       }
 #endif
 
-      SEQ_MIDI_OUT_Send(copy.port, copy.package, SEQ_MIDI_OUT_OffEvent, delayed_timestamp, 0);
+      SEQ_MIDI_OUT_Send(port, package, SEQ_MIDI_OUT_OffEvent, delayed_timestamp, 0);
     } else {
-      // remove item from queue
-      midi_queue = item->next;
       SEQ_MIDI_OUT_SlotFree(item);
     }
   }
@@ -675,6 +825,252 @@ s32 SEQ_MIDI_OUT_Handler(void)
 }
 
 
+#if SEQ_MIDI_OUT_SCHEDULER == 1
+/////////////////////////////////////////////////////////////////////////////
+// Local function which returns 1 if item a has to be sent before item b
+/////////////////////////////////////////////////////////////////////////////
+static u8 SEQ_MIDI_OUT_HeapBefore(seq_midi_out_queue_item_t *a, seq_midi_out_queue_item_t *b)
+{
+  if( a->timestamp != b->timestamp )
+    return a->timestamp < b->timestamp;
+
+  u8 priority_a = sched_event_priority[a->event_type];
+  u8 priority_b = sched_event_priority[b->event_type];
+  if( priority_a != priority_b )
+    return priority_a < priority_b;
+
+  // same timestamp and priority: keep the insertion order (works also on counter overrun)
+  return (s32)(a->order - b->order) < 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Local function which moves an item from the given heap position downwards
+// until the heap property is restored
+// returns the number of visited levels
+/////////////////////////////////////////////////////////////////////////////
+static u32 SEQ_MIDI_OUT_HeapSiftDown(u32 pos, seq_midi_out_queue_item_t *item)
+{
+  u32 steps = 0;
+
+  u32 child;
+  while( (child=2*pos+1) < sched_heap_size ) {
+    if( (child+1) < sched_heap_size && SEQ_MIDI_OUT_HeapBefore(sched_heap[child+1], sched_heap[child]) )
+      ++child;
+
+    if( !SEQ_MIDI_OUT_HeapBefore(sched_heap[child], item) )
+      break;
+
+    sched_heap[pos] = sched_heap[child];
+    pos = child;
+    ++steps;
+  }
+  sched_heap[pos] = item;
+
+  return steps;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Local function which returns 1 if an item should be re-scheduled
+// by SEQ_MIDI_OUT_ReSchedule (the tag is checked by the caller)
+/////////////////////////////////////////////////////////////////////////////
+static u8 SEQ_MIDI_OUT_ReScheduleMatch(seq_midi_out_queue_item_t *item, seq_midi_out_event_type_t event_type, u32 *reschedule_filter)
+{
+  u8 evnt1 = item->package.evnt1;
+  return (item->event_type == event_type) &&
+    (reschedule_filter == NULL ||
+     !(reschedule_filter[evnt1>>5] & (1 << (evnt1 & 0x1f))));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Local function which returns the timestamp with the delay of the given port
+/////////////////////////////////////////////////////////////////////////////
+static u32 SEQ_MIDI_OUT_DelayedTimestamp(mios32_midi_port_t port, u32 timestamp)
+{
+#if SEQ_MIDI_OUT_SUPPORT_DELAY
+  if( port < PPQN_DELAY_NUM ) {
+    s8 delay = ppqn_delay[port];
+    if( (delay < 0) && (timestamp < -delay) ) {
+      timestamp = 0;
+    } else {
+      timestamp += delay;
+    }
+  }
+#endif
+
+  return timestamp;
+}
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local function to insert an item into the queue
+// returns < 0 if the item can't be queued
+/////////////////////////////////////////////////////////////////////////////
+static s32 SEQ_MIDI_OUT_QueueInsert(seq_midi_out_queue_item_t *new_item)
+{
+  u32 steps = 0;
+
+#if SEQ_MIDI_OUT_SCHEDULER == 1
+  if( sched_heap_size >= SEQ_MIDI_OUT_MAX_EVENTS ) {
+#if SEQ_MIDI_OUT_MALLOC_ANALYSIS
+    ++seq_midi_out_dropouts;
+#endif
+    return -1; // heap full
+  }
+
+  new_item->order = sched_order++;
+  ++sched_tag_count[new_item->package.cable];
+
+  // move the new item upwards until the parent has to be sent earlier
+  u32 pos = sched_heap_size++;
+  while( pos ) {
+    u32 parent = (pos-1) / 2;
+    if( !SEQ_MIDI_OUT_HeapBefore(new_item, sched_heap[parent]) )
+      break;
+
+    sched_heap[pos] = sched_heap[parent];
+    pos = parent;
+    ++steps;
+  }
+  sched_heap[pos] = new_item;
+#else
+  u32 timestamp = new_item->timestamp;
+  seq_midi_out_event_type_t event_type = new_item->event_type;
+  new_item->next = NULL;
+
+  // search in queue for last item which has the same (or earlier) timestamp
+  seq_midi_out_queue_item_t *item;
+  if( (item=midi_queue) == NULL ) {
+    // no item in queue -- first element
+    midi_queue = new_item;
+  } else {
+    u8 insert_before_item = 0;
+    seq_midi_out_queue_item_t *last_item = NULL;
+    seq_midi_out_queue_item_t *next_item;
+    do {
+      ++steps;
+
+      // Clock and Tempo events are sorted before CC and Note events at a given timestamp
+      if( (event_type == SEQ_MIDI_OUT_ClkEvent || event_type == SEQ_MIDI_OUT_TempoEvent ) && 
+	  item->timestamp >= timestamp &&
+	  (item->event_type == SEQ_MIDI_OUT_OnEvent || 
+	   item->event_type == SEQ_MIDI_OUT_OffEvent || 
+	   item->event_type == SEQ_MIDI_OUT_OnOffEvent || 
+	   item->event_type == SEQ_MIDI_OUT_CCEvent) ) {
+	// found any event with same timestamp, insert clock before these events
+	// note that the Clock event order doesn't get lost if clock events 
+	// are queued at the same timestamp (e.g. MIDI start -> MIDI clock)
+	insert_before_item = 1;
+	break;
+      }
+
+      // CCs are sorted before notes at a given timestamp
+      // (new CC before On events at the same timestamp)
+      // CCs are still played after Off or Clock events
+      if( event_type == SEQ_MIDI_OUT_CCEvent && 
+	  item->timestamp == timestamp &&
+	  (item->event_type == SEQ_MIDI_OUT_OnEvent || item->event_type == SEQ_MIDI_OUT_OnOffEvent) ) {
+	// found On event with same timestamp, play CC before On event
+	insert_before_item = 1;
+	break;
+      }
+
+      if( item->timestamp > timestamp ) {
+	// found entry with later timestamp
+	insert_before_item = 1;
+	break;
+      }
+
+      if( (next_item=item->next) == NULL ) {
+	// end of queue reached, insert new item at the end
+	break;
+      }
+	
+      if( next_item->timestamp > timestamp ) {
+	// found entry with later timestamp
+	break;
+      }
+
+      // switch to next item
+      last_item = item;
+      item = next_item;
+    } while( 1 );
+
+    // insert/add item into/to list
+    if( insert_before_item ) {
+      if( last_item == NULL )
+	midi_queue = new_item;
+      else
+	last_item->next = new_item;
+      new_item->next = item;
+    } else {
+      item->next = new_item;
+      new_item->next = next_item;
+    }
+  }
+#endif
+
+#if SEQ_MIDI_OUT_SCHEDULER_ANALYSIS
+  ++seq_midi_out_sched_inserts;
+  seq_midi_out_sched_insert_steps += steps;
+  if( steps > seq_midi_out_sched_insert_steps_max )
+    seq_midi_out_sched_insert_steps_max = steps;
+#endif
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local function which returns the item which has to be sent next
+// returns NULL if queue is empty
+/////////////////////////////////////////////////////////////////////////////
+static seq_midi_out_queue_item_t *SEQ_MIDI_OUT_QueueFirst(void)
+{
+#if SEQ_MIDI_OUT_SCHEDULER == 1
+  return sched_heap_size ? sched_heap[0] : NULL;
+#else
+  return midi_queue;
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local function which removes the first item from the queue
+// (the memory of the item won't be released)
+/////////////////////////////////////////////////////////////////////////////
+static void SEQ_MIDI_OUT_QueueRemoveFirst(void)
+{
+  u32 steps = 0;
+
+#if SEQ_MIDI_OUT_SCHEDULER == 1
+  if( !sched_heap_size )
+    return;
+
+  seq_midi_out_queue_item_t *item = sched_heap[0];
+  if( sched_tag_count[item->package.cable] )
+    --sched_tag_count[item->package.cable];
+
+  // move last item to the top and let it sink down
+  if( --sched_heap_size )
+    steps = SEQ_MIDI_OUT_HeapSiftDown(0, sched_heap[sched_heap_size]);
+#else
+  if( midi_queue == NULL )
+    return;
+
+  midi_queue = midi_queue->next;
+  steps = 1;
+#endif
+
+#if SEQ_MIDI_OUT_SCHEDULER_ANALYSIS
+  ++seq_midi_out_sched_dispatches;
+  seq_midi_out_sched_dispatch_steps += steps;
+  if( steps > seq_midi_out_sched_dispatch_steps_max )
+    seq_midi_out_sched_dispatch_steps_max = steps;
+#endif
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Local function to allocate memory
 // returns NULL if no memory free
@@ -709,6 +1105,48 @@ static seq_midi_out_queue_item_t *SEQ_MIDI_OUT_SlotMalloc(void)
     seq_midi_out_max_allocated = seq_midi_out_allocated;
 #endif
 
+  return item;
+#elif SEQ_MIDI_OUT_MALLOC_METHOD == 6
+
+  ///////////////////////////////////////////////////////////////////////////
+  ///////////////////////////////////////////////////////////////////////////
+  ///////////////////////////////////////////////////////////////////////////
+
+  // take the slot from top of stack
+  // interrupts are disabled for a few cycles, so that the MIDI task and the sequencer task can allocate concurrently
+  seq_midi_out_queue_item_t *item = NULL;
+  MIOS32_IRQ_Disable();
+
+  // allocate memory if this hasn't been done yet
+  // (within the critical section, so that a concurrent call can't allocate it twice or take a slot before the stack is filled)
+  if( alloc_heap == NULL ) {
+    alloc_heap = (seq_midi_out_queue_item_t *)pvPortMalloc(
+      sizeof(seq_midi_out_queue_item_t)*SEQ_MIDI_OUT_MAX_EVENTS);
+
+    if( alloc_heap != NULL ) {
+      // all slots are free (lowest index on top of stack)
+      int i;
+      for(i=0; i<SEQ_MIDI_OUT_MAX_EVENTS; ++i)
+	alloc_free_stack[i] = SEQ_MIDI_OUT_MAX_EVENTS - 1 - i;
+      alloc_free_num = SEQ_MIDI_OUT_MAX_EVENTS;
+    }
+  }
+
+  if( alloc_free_num ) {
+    item = &alloc_heap[alloc_free_stack[--alloc_free_num]];
+    ++seq_midi_out_allocated;
+#if SEQ_MIDI_OUT_MALLOC_ANALYSIS
+    if( seq_midi_out_allocated > seq_midi_out_max_allocated )
+      seq_midi_out_max_allocated = seq_midi_out_allocated;
+#endif
+  }
+#if SEQ_MIDI_OUT_MALLOC_ANALYSIS
+  else {
+    ++seq_midi_out_dropouts;
+  }
+#endif
+  MIOS32_IRQ_Enable();
+
   return item;
 #else
 
@@ -717,15 +1155,19 @@ static seq_midi_out_queue_item_t *SEQ_MIDI_OUT_SlotMalloc(void)
   ///////////////////////////////////////////////////////////////////////////
 
   // allocate memory if this hasn't been done yet
+  // (interrupts disabled, so that a concurrent call can't allocate it twice)
+  MIOS32_IRQ_Disable();
   if( alloc_heap == NULL ) {
     alloc_heap = (seq_midi_out_queue_item_t *)pvPortMalloc(
       sizeof(seq_midi_out_queue_item_t)*SEQ_MIDI_OUT_MAX_EVENTS);
-    if( alloc_heap == NULL ) {
+  }
+  MIOS32_IRQ_Enable();
+
+  if( alloc_heap == NULL ) {
 #if SEQ_MIDI_OUT_MALLOC_ANALYSIS
-      ++seq_midi_out_dropouts;
+    ++seq_midi_out_dropouts;
 #endif
-      return NULL;
-    }
+    return NULL;
   }
 
   // is there still a free slot?
@@ -822,6 +1264,29 @@ static void SEQ_MIDI_OUT_SlotFree(seq_midi_out_queue_item_t *item)
 #elif SEQ_MIDI_OUT_MALLOC_METHOD == 5
   free(item);
   --seq_midi_out_allocated;
+#elif SEQ_MIDI_OUT_MALLOC_METHOD == 6
+
+  ///////////////////////////////////////////////////////////////////////////
+  ///////////////////////////////////////////////////////////////////////////
+  ///////////////////////////////////////////////////////////////////////////
+
+  u32 pos = item - alloc_heap;
+  if( item < alloc_heap || pos >= SEQ_MIDI_OUT_MAX_EVENTS ) {
+    // should never happen! (can be checked by setting a breakpoint or printf to this location)
+#if DEBUG_VERBOSE_LEVEL >= 1
+    DEBUG_MSG("[SEQ_MIDI_OUT_SlotFree] Malfunction case #1\n");
+#endif
+    return;
+  }
+
+  // put the slot on top of stack
+  MIOS32_IRQ_Disable();
+  if( alloc_free_num < SEQ_MIDI_OUT_MAX_EVENTS ) {
+    alloc_free_stack[alloc_free_num++] = pos;
+    if( seq_midi_out_allocated )
+      --seq_midi_out_allocated;
+  }
+  MIOS32_IRQ_Enable();
 #else
 
   ///////////////////////////////////////////////////////////////////////////
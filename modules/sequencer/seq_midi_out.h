@@ -30,6 +30,7 @@ extern "C" {
 // 3: internal static allocation with 32bit flags
 // 4: FreeRTOS based pvPortMalloc
 // 5: malloc provided by library
+// 6: internal static allocation with free-list (constant allocation time)
 #ifndef SEQ_MIDI_OUT_MALLOC_METHOD
 #define SEQ_MIDI_OUT_MALLOC_METHOD 3
 #endif
@@ -51,6 +52,20 @@ extern "C" {
 #define SEQ_MIDI_OUT_SUPPORT_DELAY 0
 #endif
 
+// scheduler method:
+// 0: sorted linked list (insert O(n), dispatch O(1))
+// 1: binary heap with tag index (insert and dispatch O(log n))
+//    allocates additional 4 bytes for each event
+#ifndef SEQ_MIDI_OUT_SCHEDULER
+#define SEQ_MIDI_OUT_SCHEDULER 0
+#endif
+
+// enable seq_midi_out_sched_* counters which sum up the number of queue
+// items which have been visited on insert and dispatch operations
+#ifndef SEQ_MIDI_OUT_SCHEDULER_ANALYSIS
+#define SEQ_MIDI_OUT_SCHEDULER_ANALYSIS 0
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Global Types
@@ -79,6 +94,7 @@ extern s32 SEQ_MIDI_OUT_Callback_BPM_Set_Set(void *_callback_bpm_set);
 
 extern s32 SEQ_MIDI_OUT_Send(mios32_midi_port_t port, mios32_midi_package_t midi_package, seq_midi_out_event_type_t event_type, u32 timestamp, u32 len);
 extern s32 SEQ_MIDI_OUT_ReSchedule(u8 tag, seq_midi_out_event_type_t event_type, u32 timestamp, u32 *reschedule_filter);
+extern s32 SEQ_MIDI_OUT_Cancel(u8 tag, u32 timestamp);
 extern s32 SEQ_MIDI_OUT_FlushQueue(void);
 extern s32 SEQ_MIDI_OUT_FreeHeap(void);
 extern s32 SEQ_MIDI_OUT_Handler(void);
@@ -97,6 +113,14 @@ extern u32 seq_midi_out_allocated;
 extern u32 seq_midi_out_max_allocated;
 extern u32 seq_midi_out_dropouts;
 #endif
+#if SEQ_MIDI_OUT_SCHEDULER_ANALYSIS
+extern u32 seq_midi_out_sched_inserts;
+extern u32 seq_midi_out_sched_insert_steps;
+extern u32 seq_midi_out_sched_insert_steps_max;
+extern u32 seq_midi_out_sched_dispatches;
+extern u32 seq_midi_out_sched_dispatch_steps;
+extern u32 seq_midi_out_sched_dispatch_steps_max;
+#endif
 
 #ifdef __cplusplus
 }
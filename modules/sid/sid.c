@@ -82,6 +82,10 @@ static const u8 update_order[SID_REGS_NUM] = {
   25, 26, 27, 28, 29, 30, 31 // SwinSID registers
 };
 
+#if SID_USE_CHANGE_LIST
+static u8 update_order_pos[SID_REGS_NUM]; // inverse of update_order[]
+#endif
+
 static u8 sid_available;
 
 #if SID_USE_MBNET
@@ -91,6 +95,18 @@ static u8 mbnet_my_node_id;
 static u32 mbnet_tx_msg_ctr;
 static u32 mbnet_tx_msg_ctr_min;
 static u32 mbnet_tx_msg_ctr_max;
+#if SID_USE_CHANGE_LIST
+static u32 mbnet_tx_cycle_mask[SID_NUM]; // registers which have been sent in the current cycle
+static u32 mbnet_tx_cycle_bytes;
+#endif
+#endif
+
+#if SID_USE_CHANGE_LIST
+static u32 stat_timestamp;
+static u32 stat_updates;
+static u32 stat_regs_changed;
+static u32 stat_bytes_sent;
+static u32 stat_bytes_saved;
 #endif
 
 #if !SID_USE_MBNET && defined(MIOS32_FAMILY_STM32F10x)
@@ -135,6 +151,10 @@ typedef struct {
 // Local Prototypes
 /////////////////////////////////////////////////////////////////////////////
 
+#if SID_USE_CHANGE_LIST
+static inline u32 SID_ChangeMaskGet(u8 sid);
+#endif
+
 #if !SID_USE_MBNET
 static inline void SID_UpdateReg(sid_cs_pin_t *cs_pin0, sid_cs_pin_t *cs_pin1, u8 cs, u8 addr, u8 data, u8 reset);
 #else
@@ -167,10 +187,26 @@ s32 SID_Init(u32 mode)
   mbnet_tx_msg_ctr_min = 0;
   mbnet_tx_msg_ctr_max = 0;
   mbnet_my_node_id = 0xff;
+#if SID_USE_CHANGE_LIST
+  for(sid=0; sid<SID_NUM; ++sid)
+    mbnet_tx_cycle_mask[sid] = 0;
+  mbnet_tx_cycle_bytes = 0;
+#endif
 #else
   sid_available = (u8)((1 << SID_NUM)-1);
 #endif
 
+#if SID_USE_CHANGE_LIST
+  for(reg=0; reg<SID_REGS_NUM; ++reg)
+    update_order_pos[update_order[reg]] = reg;
+
+  stat_timestamp = MIOS32_TIMESTAMP_Get();
+  stat_updates = 0;
+  stat_regs_changed = 0;
+  stat_bytes_sent = 0;
+  stat_bytes_saved = 0;
+#endif
+
 #ifdef SIDEMU_ENABLED
   SYNTH_Init(0);
 #endif
@@ -336,6 +372,21 @@ s32 SID_Update(u32 mode)
 
   // transfer SID registers to shadow registers and check for updates
   MIOS32_IRQ_Disable();
+#if SID_USE_CHANGE_LIST
+  ++stat_updates;
+  for(sid=0; sid<SID_NUM; ++sid) {
+    u32 changed = SID_ChangeMaskGet(sid);
+
+    if( changed ) {
+      sid_regs_shadow_updated[sid] |= changed;
+      for(reg=0; reg<(SID_REGS_NUM/4); ++reg)
+	sid_regs_shadow[sid].ALL32[reg] = sid_regs[sid].ALL32[reg];
+
+      for(; changed; changed &= changed-1)
+	++stat_regs_changed;
+    }
+  }
+#else
   for(sid=0; sid<SID_NUM; ++sid) {
     u8 *regs = (u8 *)&sid_regs[sid];
     u8 *regs_shadow = (u8 *)&sid_regs_shadow[sid];
@@ -346,6 +397,7 @@ s32 SID_Update(u32 mode)
       *regs_shadow++ = *regs++;
     }
   }
+#endif
   MIOS32_IRQ_Enable();
 
   // trigger next update
@@ -355,6 +407,25 @@ s32 SID_Update(u32 mode)
     if( mbnet_tx_msg_ctr > mbnet_tx_msg_ctr_max )
       mbnet_tx_msg_ctr_max = mbnet_tx_msg_ctr;
 
+#if SID_USE_CHANGE_LIST
+    // statistics: compare with the number of bytes which would have been sent in 8 byte blocks
+    {
+      u32 block_bytes = 0;
+      for(sid=0; sid<SID_NUM; ++sid) {
+	int block;
+	for(block=0; block<(SID_REGS_NUM/8); ++block)
+	  if( mbnet_tx_cycle_mask[sid] & (0xffUL << (8*block)) )
+	    block_bytes += 8;
+	mbnet_tx_cycle_mask[sid] = 0;
+      }
+
+      stat_bytes_sent += mbnet_tx_cycle_bytes;
+      if( block_bytes > mbnet_tx_cycle_bytes )
+	stat_bytes_saved += block_bytes - mbnet_tx_cycle_bytes;
+      mbnet_tx_cycle_bytes = 0;
+    }
+#endif
+
     mbnet_tx_msg_ctr = 0;
     mbnet_tx_reg_ctr = 0;
 
@@ -375,6 +446,76 @@ s32 SID_MBNET_TxHandler(mbnet_id_t *mbnet_id, mbnet_msg_t *msg, u8 *dlc)
   if( mbnet_tx_state == MBNET_TX_STATE_DONE )
     return 0; // nothing else to do...
 
+#if SID_USE_CHANGE_LIST
+  // - search for the next changed register, and send it together with the following
+  //   changed registers (up to 8) in a single message
+  // - check if there are remaining registers which have to be updated - if not, set remote_reg_update
+  // - if all registers for all SIDs have been updated, change to MBNET_TX_STATE_DONE
+  u8 tx_sid = 0;
+  u8 tx_addr = 0;
+  u8 tx_dlc = 0;
+  u8 remote_reg_update = 0;
+
+  MIOS32_IRQ_Disable();
+  while( 1 ) {
+    u8 sid = (mbnet_tx_state-MBNET_TX_STATE_SID1);
+    u32 updated = sid_regs_shadow_updated[sid];
+
+    if( updated ) {
+      u32 run;
+
+      tx_sid = sid;
+      for(tx_addr=0; !(updated & (1U << tx_addr)); ++tx_addr);
+      run = (updated >> tx_addr) & 0xff;
+      for(tx_dlc=8; !(run & (1U << (tx_dlc-1))); --tx_dlc);
+
+      // last message of this cycle?
+      updated &= ~(((1U << tx_dlc)-1) << tx_addr);
+      if( !updated ) {
+	u8 next_sid;
+	for(next_sid=sid+1; next_sid<SID_NUM && next_sid<(MBNET_TX_STATE_SID3-MBNET_TX_STATE_SID1); ++next_sid)
+	  if( sid_regs_shadow_updated[next_sid] )
+	    break;
+
+	if( next_sid >= SID_NUM || next_sid >= (MBNET_TX_STATE_SID3-MBNET_TX_STATE_SID1) ) {
+	  mbnet_tx_state = MBNET_TX_STATE_DONE;
+	  remote_reg_update = 1; // update SID registers at remote side
+	}
+      }
+      break;
+    }
+
+    if( ++mbnet_tx_state == MBNET_TX_STATE_SID3 || (mbnet_tx_state-MBNET_TX_STATE_SID1) >= SID_NUM ) {
+      mbnet_tx_state = MBNET_TX_STATE_DONE;
+      MIOS32_IRQ_Enable();
+      return 0; // abort loop, because register update has finished
+    }
+  }
+
+  // create MBNet message
+  mbnet_id->control = (remote_reg_update ? 0xfd00 : 0xfe00) + tx_addr + 0x20*(tx_sid&1);
+  mbnet_id->tos     = MBNET_REQ_RAM_WRITE;
+  mbnet_id->ms      = mbnet_my_node_id >> 4;
+  mbnet_id->ack     = 0;
+  mbnet_id->node    = 0x00 + (tx_sid/2);
+
+  *dlc = tx_dlc;
+
+  {
+    u32 mask = ((1U << tx_dlc)-1) << tx_addr;
+    int i;
+
+    msg->data_l = 0;
+    msg->data_h = 0;
+    for(i=0; i<tx_dlc; ++i)
+      msg->bytes[i] = sid_regs_shadow[tx_sid].ALL[tx_addr + i];
+
+    sid_regs_shadow_updated[tx_sid] &= ~mask;
+    mbnet_tx_cycle_mask[tx_sid] |= mask;
+    mbnet_tx_cycle_bytes += tx_dlc;
+  }
+  MIOS32_IRQ_Enable();
+#else
   // - search for next register set of 8 bytes which have been updated (-> tx_required)
   // - check if there are remaining bytes which have to be updated - if not, set remote_reg_update
   // - if all registers for all SIDs have been updated, change to MBNET_TX_STATE_DONE
@@ -437,6 +578,7 @@ s32 SID_MBNET_TxHandler(mbnet_id_t *mbnet_id, mbnet_msg_t *msg, u8 *dlc)
   msg->data_h |= (u32)*regs_shadow++ << 24;
   sid_regs_shadow_updated[tx_sid] &= ~(0xff << tx_addr);
   MIOS32_IRQ_Enable();
+#endif
 
   ++mbnet_tx_msg_ctr;
 
@@ -467,9 +609,25 @@ s32 SID_Update(u32 mode)
 	sid_regs_shadow[sid].ALL[reg] = ~sid_regs[sid].ALL[reg];
   }
 
+#if SID_USE_CHANGE_LIST
+  ++stat_updates;
+#endif
+
   // this loop should run so fast as possible, 
   // we consider to update two SIDs at once if values are identical
   for(sid=0; sid<SID_NUM; sid+=2) {
+#if SID_USE_CHANGE_LIST
+    u32 changed = SID_ChangeMaskGet(sid+0) | SID_ChangeMaskGet(sid+1);
+    u32 changed_ordered = 0;
+
+    if( !changed )
+      continue; // no update required for both SIDs
+
+    // translate register numbers into update order
+    for(reg=0; changed; ++reg, changed >>= 1)
+      if( changed & 1 )
+	changed_ordered |= (1U << update_order_pos[reg]);
+#endif
     u8 *update_order_ptr = (u8 *)&update_order[0];
     u8 *sidl = (u8 *)&sid_regs[sid+0].ALL[0];
     u8 *sidl_shadow = (u8 *)&sid_regs_shadow[sid+0].ALL[0];
@@ -486,10 +644,21 @@ s32 SID_Update(u32 mode)
     sid_cs_pin_t *cs_pin1 = NULL;
 #endif
 
+#if SID_USE_CHANGE_LIST
+    for(i=0; changed_ordered; ++i, update_order_ptr++, changed_ordered >>= 1) {
+      u8 data;
+
+      if( !(changed_ordered & 1) )
+	continue;
+
+      reg = *update_order_ptr;
+      ++stat_regs_changed;
+#else
     for(i=0; i<SID_REGS_NUM; ++i, update_order_ptr++) {
       u8 data;
 
       reg = *update_order_ptr;
+#endif
 
       // check if update of left/right channel SID are required
       // partly duplicated code ensures best performance in all cases!
@@ -538,6 +707,10 @@ static inline void SID_UpdateReg(sid_cs_pin_t *cs_pin0, sid_cs_pin_t *cs_pin1, u
     SIDEMU_setRegister(addr, data);
 #endif
 
+#if SID_USE_CHANGE_LIST
+  stat_bytes_sent += 2; // address and data byte
+#endif
+
 #ifdef MIOS32_FAMILY_STM32F10x
   // low-active reset is connected to "A6" of the first SR
   if( !reset )
@@ -638,6 +811,36 @@ static inline void SID_UpdateReg(sid_cs_pin_t *cs_pin0, sid_cs_pin_t *cs_pin1, u
 #endif
 
 
+#if SID_USE_CHANGE_LIST
+/////////////////////////////////////////////////////////////////////////////
+// Returns the registers which have been changed since the last update
+// (bit n = register n)
+// The registers are compared in 32bit words, so that unchanged register
+// sets are skipped with a single compare
+/////////////////////////////////////////////////////////////////////////////
+static inline u32 SID_ChangeMaskGet(u8 sid)
+{
+  u32 *regs = &sid_regs[sid].ALL32[0];
+  u32 *regs_shadow = &sid_regs_shadow[sid].ALL32[0];
+  u32 changed = 0;
+  int word;
+
+  for(word=0; word<(SID_REGS_NUM/4); ++word) {
+    u32 diff = regs[word] ^ regs_shadow[word];
+
+    if( diff ) { // (little endian: first register in LSB)
+      if( diff & 0x000000ff ) changed |= (1U << (4*word+0));
+      if( diff & 0x0000ff00 ) changed |= (1U << (4*word+1));
+      if( diff & 0x00ff0000 ) changed |= (1U << (4*word+2));
+      if( diff & 0xff000000 ) changed |= (1U << (4*word+3));
+    }
+  }
+
+  return changed;
+}
+#endif
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Can be called periodically (e.g. each second) to output statistics
 /////////////////////////////////////////////////////////////////////////////
@@ -652,6 +855,32 @@ s32 SID_PrintStatistics(void)
   }
 #endif
 
+#if SID_USE_CHANGE_LIST
+  {
+    MIOS32_IRQ_Disable();
+    u32 delay = MIOS32_TIMESTAMP_GetDelay(stat_timestamp);
+    u32 updates = stat_updates;
+    u32 regs_changed = stat_regs_changed;
+    u32 bytes_sent = stat_bytes_sent;
+    u32 bytes_saved = stat_bytes_saved;
+    stat_timestamp = MIOS32_TIMESTAMP_Get();
+    stat_updates = 0;
+    stat_regs_changed = 0;
+    stat_bytes_sent = 0;
+    stat_bytes_saved = 0;
+    MIOS32_IRQ_Enable();
+
+    if( delay && updates ) {
+      // scale to values per second
+      MIOS32_MIDI_SendDebugMessage("SID Updates:%d/s Regs:%d/s Bytes sent:%d/s saved:%d/s",
+				   (u32)(((unsigned long long)updates * 1000) / delay),
+				   (u32)(((unsigned long long)regs_changed * 1000) / delay),
+				   (u32)(((unsigned long long)bytes_sent * 1000) / delay),
+				   (u32)(((unsigned long long)bytes_saved * 1000) / delay));
+    }
+  }
+#endif
+
   return 0; // no error
 }
 
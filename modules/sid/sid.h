@@ -122,6 +122,15 @@ extern "C" {
 #define SID_USE_MBNET 0
 #endif
 
+// 1: SID_Update() determines the changed registers once per update cycle
+//    (32bit compares, one bit per register), and only these registers are transfered.
+//    Via MBNet, runs of up to 8 changed registers are sent instead of complete 8 byte blocks
+//    SID_PrintStatistics() displays the transfered and saved bytes per second
+//    (bytes are only saved via MBNet, the SRIO based transfer already skipped unchanged registers before)
+#ifndef SID_USE_CHANGE_LIST
+#define SID_USE_CHANGE_LIST 0
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Global Types
@@ -157,6 +166,7 @@ typedef union {
 
 typedef union {
   u8 ALL[SID_REGS_NUM];
+  u32 ALL32[SID_REGS_NUM/4]; // for fast comparisons
 
   struct {
 #if 0
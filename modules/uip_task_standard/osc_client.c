@@ -21,6 +21,7 @@
 
 #if !defined(MIOS32_FAMILY_EMULATION)
 #include "uip.h"
+#include "uip_task.h"
 #endif
 #include "osc_server.h"
 #include "osc_client.h"
@@ -37,6 +38,20 @@
 #endif
 
 
+/////////////////////////////////////////////////////////////////////////////
+// bundles are filled by the sending tasks and flushed by the uIP task
+// (recursive mutex, OSC_SERVER_SendPacket() takes it as well)
+/////////////////////////////////////////////////////////////////////////////
+
+#if !defined(MIOS32_FAMILY_EMULATION)
+# define MUTEX_BUNDLE_TAKE MUTEX_UIP_TAKE
+# define MUTEX_BUNDLE_GIVE MUTEX_UIP_GIVE
+#else
+# define MUTEX_BUNDLE_TAKE { }
+# define MUTEX_BUNDLE_GIVE { }
+#endif
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Transfer mode names
 // must be aligned with definitions in osc_client.h!!!
@@ -71,6 +86,32 @@ static u16 osc_transfer_mode[OSC_CLIENT_NUM_PORTS];
 static u8 sysex_buffer[OSC_CLIENT_NUM_PORTS][OSC_CLIENT_SYSEX_BUFFER_SIZE];
 static u8 sysex_buffer_len[OSC_CLIENT_NUM_PORTS];
 
+// NTP time (seconds.fraction in 32.32 format) at MIOS32_TIMESTAMP 0
+// not initialized by OSC_CLIENT_Init(), so that the synchronized time doesn't get lost on a network change
+static unsigned long long osc_bundle_epoch = (unsigned long long)OSC_CLIENT_BUNDLE_EPOCH << 32;
+
+#if OSC_CLIENT_BUNDLE_MAX_SIZE
+// bundle buffers
+typedef struct {
+  u16 len;        // 0: no message collected yet
+  u32 timestamp;  // MIOS32_TIMESTAMP of the collected messages
+  u8  buffer[OSC_CLIENT_BUNDLE_MAX_SIZE];
+} osc_bundle_t;
+
+static u8 osc_bundle_mode[OSC_CLIENT_NUM_PORTS];
+static osc_bundle_t osc_bundle[OSC_CLIENT_NUM_PORTS];
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Local prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+static s32 OSC_CLIENT_SendPacket(u8 osc_port, u8 *packet, u32 len);
+#if OSC_CLIENT_BUNDLE_MAX_SIZE
+static s32 OSC_CLIENT_BundleSend(u8 osc_port);
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Initialize the OSC client
@@ -82,6 +123,10 @@ s32 OSC_CLIENT_Init(u32 mode)
   for(i=0; i<OSC_CLIENT_NUM_PORTS; ++i) {
     osc_transfer_mode[i] = OSC_CLIENT_TRANSFER_MODE_MIDI;
     sysex_buffer_len[i] = 0;
+#if OSC_CLIENT_BUNDLE_MAX_SIZE
+    osc_bundle_mode[i] = OSC_CLIENT_BUNDLE_MODE_DEFAULT;
+    osc_bundle[i].len = 0;
+#endif
   }
 
   return 0; // no error
@@ -123,6 +168,40 @@ const char* OSC_CLIENT_TransferModeShortNameGet(u8 mode)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Bundle Mode Set/Get functions
+// returns -2 if bundle mode not available (OSC_CLIENT_BUNDLE_MAX_SIZE == 0)
+/////////////////////////////////////////////////////////////////////////////
+s32 OSC_CLIENT_BundleModeSet(u8 osc_port, u8 enable)
+{
+  if( osc_port >= OSC_CLIENT_NUM_PORTS )
+    return -1; // invalid connection
+
+#if OSC_CLIENT_BUNDLE_MAX_SIZE
+  // send pending messages before bundle mode is disabled
+  if( !enable )
+    OSC_CLIENT_BundleFlush(osc_port);
+
+  osc_bundle_mode[osc_port] = enable ? 1 : 0;
+  return 0; // no error
+#else
+  return enable ? -2 : 0; // bundle mode not available
+#endif
+}
+
+u8 OSC_CLIENT_BundleModeGet(u8 osc_port)
+{
+#if OSC_CLIENT_BUNDLE_MAX_SIZE
+  if( osc_port >= OSC_CLIENT_NUM_PORTS )
+    return 0;
+
+  return osc_bundle_mode[osc_port];
+#else
+  return 0;
+#endif
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Send a MIDI event
 // Path: /midi <midi-package>
@@ -403,7 +482,7 @@ s32 OSC_CLIENT_SendMIDIEvent(u8 osc_port, mios32_midi_package_t package)
   }
 
   // send packet and exit
-  return OSC_SERVER_SendPacket(osc_port, packet, (u32)(end_ptr-packet));
+  return OSC_CLIENT_SendPacket(osc_port, packet, (u32)(end_ptr-packet));
 }
 
 
@@ -485,7 +564,7 @@ s32 OSC_CLIENT_SendNRPNEvent(u8 osc_port, u8 chn, u16 nrpn_number, u16 nrpn_valu
   }
 
   // send packet and exit
-  return OSC_SERVER_SendPacket(osc_port, packet, (u32)(end_ptr-packet));
+  return OSC_CLIENT_SendPacket(osc_port, packet, (u32)(end_ptr-packet));
 }
 
 
@@ -522,7 +601,7 @@ s32 OSC_CLIENT_SendSysEx(u8 osc_port, u8 *stream, u32 count)
     end_ptr = MIOS32_OSC_PutString(end_ptr, ",b");
     end_ptr = MIOS32_OSC_PutBlob(end_ptr, (u8 *)&stream[send_offset], bytes_to_send);
 
-    OSC_SERVER_SendPacket(osc_port, packet, (u32)(end_ptr-packet));
+    OSC_CLIENT_SendPacket(osc_port, packet, (u32)(end_ptr-packet));
 
     send_offset += bytes_to_send;
   };
@@ -567,4 +646,153 @@ s32 OSC_CLIENT_SendMIDIEventBundled(u8 osc_port, mios32_midi_package_t *p, u8 nu
   return OSC_SERVER_SendPacket(osc_port, packet, (u32)(end_ptr-packet));
 }
 
+
+/////////////////////////////////////////////////////////////////////////////
+// Converts a MIOS32_TIMESTAMP (mS since startup) into the timetag of a bundle
+/////////////////////////////////////////////////////////////////////////////
+mios32_osc_timetag_t OSC_CLIENT_BundleTimetagGet(u32 timestamp)
+{
+  mios32_osc_timetag_t timetag;
+
+  MIOS32_IRQ_Disable(); // 64bit access must be atomic
+  unsigned long long epoch = osc_bundle_epoch;
+  MIOS32_IRQ_Enable();
+
+  timestamp += OSC_CLIENT_BUNDLE_LATENCY;
+  unsigned long long t = epoch + (((unsigned long long)timestamp << 32) / 1000);
+  timetag.seconds = (u32)(t >> 32);
+  timetag.fraction = (u32)t;
+
+  return timetag;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Sets the current time of the bundle timetags in NTP format (seconds since
+// 1900 + fraction), e.g. received from a time server or from the host
+/////////////////////////////////////////////////////////////////////////////
+s32 OSC_CLIENT_BundleTimeSet(mios32_osc_timetag_t timetag)
+{
+  unsigned long long now = ((unsigned long long)timetag.seconds << 32) | timetag.fraction;
+
+  MIOS32_IRQ_Disable(); // 64bit access must be atomic
+  osc_bundle_epoch = now - (((unsigned long long)MIOS32_TIMESTAMP_Get() << 32) / 1000);
+  MIOS32_IRQ_Enable();
+
+  return 0; // no error
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Sends a single OSC message, or adds it to the bundle of the port if
+// bundle mode is enabled
+/////////////////////////////////////////////////////////////////////////////
+static s32 OSC_CLIENT_SendPacket(u8 osc_port, u8 *packet, u32 len)
+{
+#if OSC_CLIENT_BUNDLE_MAX_SIZE
+  // "#bundle" + timetag (16 bytes) + size of the element (4 bytes) + message
+  // messages which don't fit into an empty bundle are sent directly
+  if( osc_bundle_mode[osc_port] && len > 0 && (16 + 4 + len) <= OSC_CLIENT_BUNDLE_MAX_SIZE ) {
+    osc_bundle_t *bundle = &osc_bundle[osc_port];
+    u32 timestamp = MIOS32_TIMESTAMP_Get();
+    s32 status = 0;
+
+    MUTEX_BUNDLE_TAKE;
+
+    // send the collected messages if the mS has passed, or if the new message doesn't fit anymore
+    if( bundle->len && (bundle->timestamp != timestamp || (bundle->len + 4 + len) > OSC_CLIENT_BUNDLE_MAX_SIZE) )
+      status = OSC_CLIENT_BundleSend(osc_port);
+
+    if( !bundle->len ) {
+      u8 *end_ptr = bundle->buffer;
+      end_ptr = MIOS32_OSC_PutString(end_ptr, "#bundle");
+      end_ptr = MIOS32_OSC_PutTimetag(end_ptr, OSC_CLIENT_BundleTimetagGet(timestamp));
+      bundle->len = (u16)(end_ptr - bundle->buffer);
+      bundle->timestamp = timestamp;
+    }
+
+    // add bundle element
+    u8 *end_ptr = MIOS32_OSC_PutWord(&bundle->buffer[bundle->len], len);
+    memcpy(end_ptr, packet, len);
+    bundle->len += 4 + len;
+
+    MUTEX_BUNDLE_GIVE;
+
+    return status;
+  }
+#endif
+
+  return OSC_SERVER_SendPacket(osc_port, packet, len);
+}
+
+
+#if OSC_CLIENT_BUNDLE_MAX_SIZE
+/////////////////////////////////////////////////////////////////////////////
+// Sends the bundle of a port (if messages have been collected)
+// MUTEX_BUNDLE_TAKE has to be called before
+/////////////////////////////////////////////////////////////////////////////
+static s32 OSC_CLIENT_BundleSend(u8 osc_port)
+{
+  osc_bundle_t *bundle = &osc_bundle[osc_port];
+
+  if( !bundle->len )
+    return 0; // nothing to send
+
+  s32 status = OSC_SERVER_SendPacket(osc_port, bundle->buffer, bundle->len);
+  bundle->len = 0;
+
+  return status;
+}
+#endif
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Sends the collected messages of a port immediately
+// (e.g. if an application knows that no further events follow)
+/////////////////////////////////////////////////////////////////////////////
+s32 OSC_CLIENT_BundleFlush(u8 osc_port)
+{
+  if( osc_port >= OSC_CLIENT_NUM_PORTS )
+    return -1; // invalid port
+
+#if OSC_CLIENT_BUNDLE_MAX_SIZE
+  s32 status;
+
+  MUTEX_BUNDLE_TAKE;
+  status = OSC_CLIENT_BundleSend(osc_port);
+  MUTEX_BUNDLE_GIVE;
+
+  return status;
+#else
+  return 0; // no error
+#endif
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Should be called each mS (from the uIP task) to send the bundles
+// which have been collected in a previous mS
+/////////////////////////////////////////////////////////////////////////////
+s32 OSC_CLIENT_Periodic_mS(void)
+{
+#if OSC_CLIENT_BUNDLE_MAX_SIZE
+  u32 timestamp = MIOS32_TIMESTAMP_Get();
+  int osc_port;
+
+  for(osc_port=0; osc_port<OSC_CLIENT_NUM_PORTS; ++osc_port) {
+    osc_bundle_t *bundle = &osc_bundle[osc_port];
+
+    // deadline reached?
+    if( bundle->len && bundle->timestamp != timestamp ) {
+      MUTEX_BUNDLE_TAKE;
+      if( bundle->len && bundle->timestamp != timestamp ) // check again, could have been sent meanwhile
+	OSC_CLIENT_BundleSend(osc_port);
+      MUTEX_BUNDLE_GIVE;
+    }
+  }
+#endif
+
+  return 0; // no error
+}
+
 #endif
\ No newline at end of file
@@ -36,6 +36,41 @@ extern "C" {
 #define OSC_CLIENT_TRANSFER_MODE_TOSC  4
 
 
+// optional bundle mode: all OSC messages which are sent to a port within the same mS
+// (MIOS32_TIMESTAMP) are collected into a single #bundle, which is sent once the mS
+// has passed (OSC_CLIENT_Periodic_mS()), or if the next message wouldn't fit anymore.
+// Can be enabled per port with OSC_CLIENT_BundleModeSet(), this is the default:
+#ifndef OSC_CLIENT_BUNDLE_MODE_DEFAULT
+#define OSC_CLIENT_BUNDLE_MODE_DEFAULT 0
+#endif
+
+// max. size of a bundle (UDP payload) - must be below the MTU of the network device
+// (ENC28J60: UIP_BUFSIZE - UIP_LLH_LEN - UIP_IPUDPH_LEN) and the ESP8266 link
+// A buffer of this size is allocated for each port; 0 disables the bundle mode to save RAM
+// Note: OSC_CLIENT_Periodic_mS() has to be called each mS, this is done by uip_task.c
+#ifndef OSC_CLIENT_BUNDLE_MAX_SIZE
+# if defined(MIOS32_FAMILY_STM32F4xx)
+#  define OSC_CLIENT_BUNDLE_MAX_SIZE 512
+# else
+#  define OSC_CLIENT_BUNDLE_MAX_SIZE 0
+# endif
+#endif
+
+// the timetag of a bundle is derived from the MIOS32_TIMESTAMP of the first message.
+// this optional latency (in mS) is added, so that the receiver can schedule the bundles in advance
+#ifndef OSC_CLIENT_BUNDLE_LATENCY
+#define OSC_CLIENT_BUNDLE_LATENCY 0
+#endif
+
+// Since there is no realtime clock, the timetags count from this NTP time (seconds since 1900)
+// at startup. It can be synchronized during runtime with OSC_CLIENT_BundleTimeSet(), e.g. with
+// the "set osc_time" terminal command. As long as the time isn't known, the receiver can
+// only evaluate the difference between the timetags
+#ifndef OSC_CLIENT_BUNDLE_EPOCH
+#define OSC_CLIENT_BUNDLE_EPOCH 0
+#endif
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Global Types
 /////////////////////////////////////////////////////////////////////////////
@@ -58,6 +93,13 @@ extern s32 OSC_CLIENT_SendNRPNEvent(u8 osc_port, u8 chn, u16 nrpn_number, u16 nr
 extern s32 OSC_CLIENT_SendSysEx(u8 osc_port, u8 *stream, u32 count);
 extern s32 OSC_CLIENT_SendMIDIEventBundled(u8 osc_port, mios32_midi_package_t *p, u8 num_events, mios32_osc_timetag_t timetag);
 
+extern s32 OSC_CLIENT_BundleModeSet(u8 osc_port, u8 enable);
+extern u8 OSC_CLIENT_BundleModeGet(u8 osc_port);
+extern mios32_osc_timetag_t OSC_CLIENT_BundleTimetagGet(u32 timestamp);
+extern s32 OSC_CLIENT_BundleTimeSet(mios32_osc_timetag_t timetag);
+extern s32 OSC_CLIENT_BundleFlush(u8 osc_port);
+extern s32 OSC_CLIENT_Periodic_mS(void);
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Export global variables
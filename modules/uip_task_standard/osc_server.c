@@ -75,6 +75,10 @@ s32 OSC_SERVER_Init(u32 mode)
   // disable send packet
   osc_send_packet = NULL;
 
+  // compile the search tree for faster parsing (if enabled via MIOS32_OSC_SEARCH_HASH_SIZE)
+  // the tree is only compiled once, re-initialisations have no effect
+  MIOS32_OSC_CompileSearchTree(parse_root);
+
   // remove open connections
   for(con=0; con<OSC_SERVER_NUM_CONNECTIONS; ++con)
     if( osc_conn[con] != NULL )
@@ -395,6 +399,29 @@ s32 OSC_SERVER_SendPacket(u8 con, u8 *packet, u32 len)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Help function: returns the decimal number of a path part, which is
+// terminated by '/' or the end of the path
+// returns -1 if no valid number (e.g. empty value of "/1/note_")
+/////////////////////////////////////////////////////////////////////////////
+static s32 OSC_SERVER_PathValueGet(char *str)
+{
+  if( *str < '0' || *str > '9' )
+    return -1; // no number
+
+  s32 value = 0;
+  do {
+    value = 10*value + (*str++ - '0');
+    if( value > 0xffff )
+      return -1; // number too big
+  } while( *str >= '0' && *str <= '9' );
+
+  if( *str != 0 && *str != '/' )
+    return -1; // invalid character
+
+  return value;
+}
+
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -491,7 +518,8 @@ static s32 OSC_SERVER_Method_MCMPP(mios32_osc_args_t *osc_args, u32 method_arg)
       // (key) value not transmitted for 0xc0 (program change), 0xd0 (aftertouch), 0xe0 (pitch)
 
     // get value
-    note = atoi(path_values);
+    if( (note = OSC_SERVER_PathValueGet(path_values)) < 0 )
+      return -2; // invalid format
 
     // next slash
     if( (path_values = strchr(path_values+1, '/')) == NULL )
@@ -500,7 +528,7 @@ static s32 OSC_SERVER_Method_MCMPP(mios32_osc_args_t *osc_args, u32 method_arg)
   }
 
   // get channel
-  int chn = atoi(path_values) - 1;
+  int chn = OSC_SERVER_PathValueGet(path_values) - 1;
   if( chn < 0 || chn >= 15 )
     return -3; // invalid channel
 
@@ -756,10 +784,11 @@ static s32 OSC_SERVER_Method_EventTOSC(mios32_osc_args_t *osc_args, u32 method_a
   if( (path_values = strchr(path_values+1, '_')) == NULL )
     return -1;
 
-  // get value
-  int note = 60;
-  note = atoi(path_values+1);
-  if( note < 0 ) note = 0; else if( note > 127 ) note = 127;
+  // get value (an empty value, e.g. "/1/note_", is rejected)
+  int note = OSC_SERVER_PathValueGet(path_values+1);
+  if( note < 0 )
+    return -2; // invalid format
+  if( note > 127 ) note = 127;
 
   // get velocity
   int velocity = 127;
@@ -119,6 +119,8 @@ s32 UIP_TERMINAL_Help(void *_output_function)
   out("  set osc_remote_port <con> <port>: changes OSC Remote Port (1024..65535)");
   out("  set osc_local_port <con> <port>:  changes OSC Local Port (1024..65535)");
   out("  set osc_mode <con> <mode>:        changes OSC Transfer Mode (0..%d)", OSC_CLIENT_NUM_TRANSFER_MODES-1);
+  out("  set osc_bundle <con> <on|off>:    sends all OSC messages of a mS in a single bundle");
+  out("  set osc_time <seconds>:            sets the time of the bundle timetags (seconds since 1970)");
   out("  set udpmon <0..4>:                enables UDP monitor (verbose level: %d)\n", UIP_TASK_UDP_MonitorLevelGet());
 
 #if OSC_SERVER_ESP8266_ENABLED
@@ -381,6 +383,47 @@ s32 UIP_TERMINAL_ParseLine(char *input, void *_output_function)
 	}
 	return 1; // command taken
 
+      } else if( strcmp(parameter, "osc_bundle") == 0 ) {
+	s32 con = -1;
+	if( (parameter = strtok_r(NULL, separators, &brkt)) )
+	  con = get_dec(parameter);
+	if( con < 1 || con > OSC_SERVER_NUM_CONNECTIONS) {
+	  out("Invalid OSC connection specified as first parameter (expecting 1..%d)!", OSC_SERVER_NUM_CONNECTIONS);
+	  return 1; // command taken
+	}
+
+	con-=1; // the user counts from 1
+
+	s32 on_off = -1;
+	if( (parameter = strtok_r(NULL, separators, &brkt)) )
+	  on_off = get_on_off(parameter);
+
+	if( on_off < 0 ) {
+	  out("Expecting 'on' or 'off'!");
+	} else if( OSC_CLIENT_BundleModeSet(con, on_off) >= 0 ) {
+	  out("OSC%d bundle mode %s", con+1, on_off ? "enabled" : "disabled");
+	} else {
+	  out("ERROR: bundle mode not available (OSC_CLIENT_BUNDLE_MAX_SIZE == 0)!");
+	}
+	return 1; // command taken
+
+      } else if( strcmp(parameter, "osc_time") == 0 ) {
+	char *next = NULL;
+	unsigned long seconds = 0;
+	if( (parameter = strtok_r(NULL, separators, &brkt)) )
+	  seconds = strtoul(parameter, &next, 0);
+
+	if( next == NULL || next == parameter ) {
+	  out("Please specify the current time in seconds since 1970 (e.g. 'date +%%s')!");
+	} else {
+	  mios32_osc_timetag_t timetag;
+	  timetag.seconds = (u32)seconds + 2208988800UL; // NTP counts from 1900
+	  timetag.fraction = 0;
+	  OSC_CLIENT_BundleTimeSet(timetag);
+	  out("OSC bundle time set to %lu seconds since 1970", seconds);
+	}
+	return 1; // command taken
+
       } else if( strcmp(parameter, "udpmon") == 0 ) {
 	char *arg;
 	if( (arg = strtok_r(NULL, separators, &brkt)) ) {
@@ -465,6 +508,7 @@ s32 UIP_TERMINAL_PrintNetwork(void *_output_function)
 
     s32 mode = OSC_CLIENT_TransferModeGet(con);
     out("OSC%d Transfer Mode: %d - %s", con+1, mode, OSC_CLIENT_TransferModeFullNameGet(mode));
+    out("OSC%d Bundle Mode: %s", con+1, OSC_CLIENT_BundleModeGet(con) ? "on" : "off");
   }
 
   out("UDP Monitor: verbose level #%d\n", UIP_TASK_UDP_MonitorLevelGet());
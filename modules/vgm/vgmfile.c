@@ -289,6 +289,18 @@ s32 VGM_File_StartStream(VgmSource* sourcestream, char* filepath, VgmFileMetadat
     vss->filepath = vgmh2_malloc(len+1);
     memcpy(vss->filepath, filepath, len);
     vss->filepath[len] = 0;
+    //Map the clusters of the file, so that the heads can be buffered without reopening it
+    MUTEX_SDCARD_TAKE;
+    s32 maplen = FILE_ReadClusterMapCreate(&vss->file, NULL, 0);
+    if(maplen > 0){
+        vss->clustermap = vgmh2_malloc(maplen * sizeof(u32));
+        if(vss->clustermap != NULL && FILE_ReadClusterMapCreate(&vss->file, vss->clustermap, maplen) != maplen){
+            vgmh2_free(vss->clustermap);
+            vss->clustermap = NULL;
+        }
+    }
+    MUTEX_SDCARD_GIVE;
+    DBG("VGM_File_StartStream: cluster map with %d words", vss->clustermap != NULL ? maplen : 0);
     //Allocate memory for block
     if(!vss->blocklen) return 0; //No blocks, done!
     vss->block = malloc(vss->blocklen);
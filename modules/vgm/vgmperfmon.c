@@ -13,6 +13,8 @@
 
 #include "vgmperfmon.h"
 #include "vgmplayer.h"
+#include "vgmstream.h"
+#include <genesis.h>
 #include "vgm_heap2.h"
 #include "FreeRTOS.h"
 
@@ -43,6 +45,24 @@ u8 VGM_PerfMon_GetTaskCPU(u8 task){
     return percents[task];
 }
 
+u32 VGM_PerfMon_GetUnderruns(VgmHead* head){
+    if(head == NULL || head->source->type != VGM_SOURCE_TYPE_STREAM) return 0;
+    return ((VgmHeadStream*)head->data)->underruns;
+}
+u32 VGM_PerfMon_GetTotalUnderruns(){
+    u32 total = 0;
+    u8 i;
+    for(i=0; i<vgm_numheads; ++i){
+        total += VGM_PerfMon_GetUnderruns(vgm_heads[i]);
+    }
+    return total;
+}
+
+u32 VGM_PerfMon_GetOPN2WritesSaved(u8 chip){
+    if(chip >= GENESIS_COUNT) return 0;
+    return genesis_opn2_queuestats[chip].dropped + genesis_opn2_queuestats[chip].coalesced;
+}
+
 vgm_meminfo_t VGM_PerfMon_GetMemInfo(){
     vgm_meminfo_t ret;
     ret.main_total = configTOTAL_HEAP_SIZE >> 3;
@@ -14,6 +14,7 @@
 #define _VGMPERFMON_H
 
 #include <mios32.h>
+#include "vgmhead.h"
 
 #define VGM_PERFMON_NUM_TASKS 2
 #define VGM_PERFMON_TASK_CHIP 0
@@ -26,6 +27,13 @@ extern void VGM_PerfMon_ClockOut(u8 task);
 extern void VGM_PerfMon_Periodic();
 extern u8 VGM_PerfMon_GetTaskCPU(u8 task);
 
+//Number of times a stream head had to wait for data from the SD card
+extern u32 VGM_PerfMon_GetUnderruns(VgmHead* head);
+extern u32 VGM_PerfMon_GetTotalUnderruns();
+
+//Number of OPN2 writes the write queue saved (redundant or replaced writes)
+extern u32 VGM_PerfMon_GetOPN2WritesSaved(u8 chip);
+
 typedef struct {
     u16 main_total;
     u16 main_used;
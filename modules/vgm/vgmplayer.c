@@ -89,28 +89,42 @@ u16 VgmPlayer_WorkCallback(){
                             wrotetochip = 1;
                         }
                     }else{
-                        //OPN2 write
-                        u = TIM2->CNT - chipdata[chip].opn2_lastwritetime;
-                        if(u < VGMP_OPN2BUSYDELAY){
-                            u = VGMP_OPN2BUSYDELAY - u;
+                        //OPN2 write, goes through the chip's write queue
+                        if(Genesis_OPN2QueueWrite(chip, (cmd.cmd & 0x01), cmd.addr, cmd.data)){
+                            VGM_Head_cmdNext(h, vgm_time);
+                            wrotetochip = 1;
+                        }else{
+                            //Queue full, try again once the chip has taken the next write
+                            u = TIM2->CNT - chipdata[chip].opn2_lastwritetime;
+                            u = (u < VGMP_OPN2BUSYDELAY) ? (VGMP_OPN2BUSYDELAY - u) : 0;
                             if(u < minwait){
                                 minwait = u;
                             }
-                        }else{
-                            Genesis_OPN2Write(chip, (cmd.cmd & 0x01), cmd.addr, cmd.data);
-                            VGM_Head_cmdNext(h, vgm_time);
-                            //Don't delay after 0x2x commands
-                            if(cmd.addr >= 0x20 && cmd.addr < 0x2F && cmd.addr != 0x28){
-                                chipdata[chip].opn2_lastwritetime = TIM2->CNT - VGMP_OPN2BUSYDELAY;
-                            }else{
-                                chipdata[chip].opn2_lastwritetime = TIM2->CNT;
-                            }
-                            wrotetochip = 1;
                         }
                     }
                 }
             }
         }
+        //Write queued OPN2 commands as far as the chips are ready for them
+        for(chip=0; chip<GENESIS_COUNT; ++chip){
+            if(!Genesis_OPN2QueueDepth(chip)) continue;
+            u = TIM2->CNT - chipdata[chip].opn2_lastwritetime;
+            if(u >= VGMP_OPN2BUSYDELAY){
+                if(Genesis_OPN2QueueDrain(chip)){
+                    chipdata[chip].opn2_lastwritetime = TIM2->CNT;
+                }else{
+                    //Don't delay after 0x2x commands
+                    chipdata[chip].opn2_lastwritetime = TIM2->CNT - VGMP_OPN2BUSYDELAY;
+                }
+                //Heads waiting for a full queue can continue
+                wrotetochip = 1;
+            }else{
+                u = VGMP_OPN2BUSYDELAY - u;
+                if(u < minwait){
+                    minwait = u;
+                }
+            }
+        }
     }
     //Set up next delay
     if(minwait < 100){
@@ -119,7 +133,8 @@ u16 VgmPlayer_WorkCallback(){
     }else if(minwait > VGMP_MAXDELAY){
         if(VGM_Player_docapture 
                 && (TIM2->CNT - lasttimecaptured >= 30000)
-                && (TIM2->CNT - chipdata[nextchiptocapture].opn2_lastwritetime >= VGMP_OPN2BUSYDELAY)){
+                && (TIM2->CNT - chipdata[nextchiptocapture].opn2_lastwritetime >= VGMP_OPN2BUSYDELAY)
+                && !Genesis_OPN2QueueDepth(nextchiptocapture)){
             //If we have plenty of time, capture some operator states
             Genesis_CaptureOPN2OpStates(nextchiptocapture);
             lasttimecaptured = TIM2->CNT;
@@ -31,25 +31,32 @@ u8 vgm_sdtask_usingsdcard;
 static void VGM_SDTask(void* pvParameters){
     portTickType xLastExecutionTime;
     xLastExecutionTime = xTaskGetTickCount();
-    u8 i, fi = 0;
+    u8 i, n;
+    u32 ahead, bestahead;
     VgmHead* vh;
+    VgmHead* best;
     while(1){
         vTaskDelayUntil(&xLastExecutionTime, 1 / portTICK_RATE_MS);
-        i = fi;
-        while(1){
-            if(vgm_sdtask_disable){
-                fi = i; //start back where you are now
-                break; //stop immediately
-            }
-            vh = vgm_heads[i];
-            if(vh != NULL){
-                if(vh->playing && vh->source->type == VGM_SOURCE_TYPE_STREAM){
-                    VGM_HeadStream_BackgroundBuffer(vh);
+        //Read at most one block per head per tick on average, always for the
+        //stream head which is closest to running out of data
+        for(n=0; n<vgm_numheads; ++n){
+            if(vgm_sdtask_disable) break; //stop immediately
+            best = NULL;
+            bestahead = 0xFFFFFFFF;
+            for(i=0; i<vgm_numheads; ++i){
+                vh = vgm_heads[i];
+                if(vh != NULL){
+                    if(vh->playing && vh->source->type == VGM_SOURCE_TYPE_STREAM){
+                        ahead = VGM_HeadStream_BufferedAhead(vh);
+                        if(ahead < bestahead){
+                            bestahead = ahead;
+                            best = vh;
+                        }
+                    }
                 }
             }
-            ++i;
-            if(i >= vgm_numheads) i = 0;
-            if(i == fi) break; //Have done them all
+            if(best == NULL) break; //All read-ahead rings are full
+            VGM_HeadStream_BackgroundBuffer(best);
         }
     }
 }
@@ -45,22 +45,63 @@ void VGM_HeadStream_unBuffer(VgmHeadStream* vhs, u8 len){
     }
 }
 
+s8 VGM_HeadStream_findBuffer(VgmHeadStream* vhs, u32 addr){
+    u8 i;
+    for(i=0; i<VGM_HEADSTREAM_NUMBUFFERS; ++i){
+        if(addr >= vhs->bufferaddr[i] && addr < (vhs->bufferaddr[i] + VGM_SOURCESTREAM_BUFSIZE)) return i;
+    }
+    return -1;
+}
+s8 VGM_HeadStream_findFreeBuffer(VgmHead* head, VgmHeadStream* vhs){
+    u8 i;
+    for(i=0; i<VGM_HEADSTREAM_NUMBUFFERS; ++i){
+        //Empty, or entirely behind the play position
+        if(vhs->bufferaddr[i] == 0xFFFFFFFF) return i;
+        if(vhs->bufferaddr[i] + VGM_SOURCESTREAM_BUFSIZE <= head->srcaddr) return i;
+    }
+    return -1;
+}
+void VGM_HeadStream_seek(VgmHead* head, VgmHeadStream* vhs){
+    //If we're still within the ring, just keep reading ahead from there
+    if(VGM_HeadStream_findBuffer(vhs, head->srcaddr) >= 0) return;
+    //Otherwise start over from the new address
+    u8 i;
+    for(i=0; i<VGM_HEADSTREAM_NUMBUFFERS; ++i){
+        vhs->bufferaddr[i] = 0xFFFFFFFF;
+    }
+    vhs->wantbufferaddr = head->srcaddr;
+    vhs->wantbuffer = 1;
+    vhs->seeking = 1;
+}
+void VGM_HeadStream_underrun(VgmHeadStream* vhs){
+    //Count each stall once, not every time the player retries
+    if(vhs->seeking || vhs->stalled) return;
+    vhs->stalled = 1;
+    ++vhs->underruns;
+}
+
 VgmHeadStream* VGM_HeadStream_Create(VgmSource* source){
     VgmHeadStream* vhs = vgmh2_malloc(sizeof(VgmHeadStream));
     vhs->srcblockaddr = 0;
     vhs->subbufferlen = 0;
-    vhs->buffer1 = malloc(VGM_SOURCESTREAM_BUFSIZE); //Buffers accessed using DMA,
-    vhs->buffer2 = malloc(VGM_SOURCESTREAM_BUFSIZE); //have to use normal malloc
-    vhs->buffer1addr = 0xFFFFFFFF;
-    vhs->buffer2addr = 0xFFFFFFFF;
+    u8 i;
+    for(i=0; i<VGM_HEADSTREAM_NUMBUFFERS; ++i){
+        vhs->buffer[i] = malloc(VGM_SOURCESTREAM_BUFSIZE); //Buffers accessed using DMA,
+        vhs->bufferaddr[i] = 0xFFFFFFFF;                   //have to use normal malloc
+    }
     vhs->wantbuffer = 0;
+    vhs->seeking = 0;
+    vhs->stalled = 0;
     vhs->wantbufferaddr = 0;
+    vhs->underruns = 0;
     return vhs;
 }
 void VGM_HeadStream_Delete(void* headstream){
     VgmHeadStream* vhs = (VgmHeadStream*)headstream;
-    free(vhs->buffer1);
-    free(vhs->buffer2);
+    u8 i;
+    for(i=0; i<VGM_HEADSTREAM_NUMBUFFERS; ++i){
+        free(vhs->buffer[i]);
+    }
     vgmh2_free(vhs);
 }
 void VGM_HeadStream_Restart(VgmHead* head){
@@ -69,10 +110,12 @@ void VGM_HeadStream_Restart(VgmHead* head){
     head->srcaddr = (head->source->markstart < vss->vgmdatastartaddr) 
             ? vss->vgmdatastartaddr : head->source->markstart;
     vhs->srcblockaddr = 0;
-    vhs->buffer1addr = 0xFFFFFFFF;
-    vhs->buffer2addr = 0xFFFFFFFF;
-    vhs->wantbufferaddr = head->srcaddr;
-    vhs->wantbuffer = 1;
+    u8 i;
+    for(i=0; i<VGM_HEADSTREAM_NUMBUFFERS; ++i){
+        vhs->bufferaddr[i] = 0xFFFFFFFF;
+    }
+    vhs->stalled = 0;
+    VGM_HeadStream_seek(head, vhs);
     DBG("HeadStream_Restart srcaddr=%d", head->srcaddr);
     VGM_HeadStream_cmdNext(head, VGM_Player_GetVGMTime());
 }
@@ -91,39 +134,32 @@ u8 VGM_HeadStream_cmdNext(VgmHead* head, u32 vgm_time){
             head->srcaddr += l;
             VGM_HeadStream_unBuffer(vhs, 7); //Remove this command from subbuffer
             //Set up the stream where the block ends
-            vhs->wantbufferaddr = head->srcaddr;
-            vhs->wantbuffer = 1;
+            VGM_HeadStream_seek(head, vhs);
             head->iswait = 1; //Act as a wait for 0 (or negative) time
             return 0; //Report that the command couldn't be loaded
         }else if(vhs->subbufferlen == 0){
-            //Check if we're about to run out of buffer
-            if(head->srcaddr >= vhs->buffer1addr && head->srcaddr < (vhs->buffer1addr + VGM_SOURCESTREAM_BUFSIZE)){
-                //We're in buffer1
-                if((vhs->buffer1addr + VGM_SOURCESTREAM_BUFSIZE - head->srcaddr) < VGM_HEADSTREAM_SUBBUFFER_MAXLEN 
-                        && vhs->buffer2addr != (vhs->buffer1addr + VGM_SOURCESTREAM_BUFSIZE)){
-                    //About to run out of buffer1, and buffer2 isn't ready
-                    vhs->wantbufferaddr = (vhs->buffer1addr + VGM_SOURCESTREAM_BUFSIZE);
-                    vhs->wantbuffer = 2; //in case you didn't know already
-                    head->iswait = 1; //Act as a wait for 0 (or negative) time
-                    return 0; //Report that the command couldn't be loaded
+            //Check that the next command is in the ring
+            if(VGM_HeadStream_findBuffer(vhs, head->srcaddr) < 0){
+                //Not buffered (yet)
+                VGM_HeadStream_underrun(vhs);
+                if(!vhs->wantbuffer || head->srcaddr < vhs->wantbufferaddr 
+                        || head->srcaddr >= (vhs->wantbufferaddr + VGM_SOURCESTREAM_BUFSIZE)){
+                    //And it isn't the next block to be read either
+                    VGM_HeadStream_seek(head, vhs);
                 }
-            }else if(head->srcaddr >= vhs->buffer2addr && head->srcaddr < (vhs->buffer2addr + VGM_SOURCESTREAM_BUFSIZE)){
-                //We're in buffer2
-                if((vhs->buffer2addr + VGM_SOURCESTREAM_BUFSIZE - head->srcaddr) < VGM_HEADSTREAM_SUBBUFFER_MAXLEN 
-                        && vhs->buffer1addr != (vhs->buffer2addr + VGM_SOURCESTREAM_BUFSIZE)){
-                    //About to run out of buffer2, and buffer1 isn't ready
-                    vhs->wantbufferaddr = (vhs->buffer2addr + VGM_SOURCESTREAM_BUFSIZE);
-                    vhs->wantbuffer = 1; //in case you didn't know already
-                    head->iswait = 1; //Act as a wait for 0 (or negative) time
-                    return 0; //Report that the command couldn't be loaded
-                }
-            }else{
-                //We're not in either buffer
-                vhs->wantbufferaddr = head->srcaddr;
-                vhs->wantbuffer = 1; //in case you didn't know already
                 head->iswait = 1; //Act as a wait for 0 (or negative) time
                 return 0; //Report that the command couldn't be loaded
             }
+            //Check if we're about to run out of buffer
+            u32 lastaddr = head->srcaddr + VGM_HEADSTREAM_SUBBUFFER_MAXLEN - 1;
+            if(lastaddr < vss->datalen && VGM_HeadStream_findBuffer(vhs, lastaddr) < 0){
+                //The next block isn't ready
+                VGM_HeadStream_underrun(vhs);
+                head->iswait = 1; //Act as a wait for 0 (or negative) time
+                return 0; //Report that the command couldn't be loaded
+            }
+            vhs->seeking = 0;
+            vhs->stalled = 0;
         }
         if(head->srcaddr > head->source->markend){
             head->isdone = 1;
@@ -228,8 +264,7 @@ u8 VGM_HeadStream_cmdNext(VgmHead* head, u32 vgm_time){
                 head->srcaddr = head->source->loopaddr;
                 VGM_HeadStream_unBuffer(vhs, 1); //Remove this command from subbuffer
                 //Set up to stream from here
-                vhs->wantbufferaddr = head->srcaddr;
-                vhs->wantbuffer = 1;
+                VGM_HeadStream_seek(head, vhs);
                 head->iswait = 1; //Act as a wait for 0 (or negative) time
                 return 0; //Report that the command couldn't be loaded
             }else{
@@ -245,8 +280,7 @@ u8 VGM_HeadStream_cmdNext(VgmHead* head, u32 vgm_time){
             head->srcaddr += l;
             VGM_HeadStream_unBuffer(vhs, 7); //Remove this command from subbuffer
             //Set up the stream where the block ends
-            vhs->wantbufferaddr = head->srcaddr;
-            vhs->wantbuffer = 1;
+            VGM_HeadStream_seek(head, vhs);
             head->iswait = 1; //Act as a wait for 0 (or negative) time
             return 0; //Report that the command couldn't be loaded
             //}
@@ -263,38 +297,34 @@ u8 VGM_HeadStream_cmdNext(VgmHead* head, u32 vgm_time){
 }
 u8 VGM_HeadStream_getByte(VgmSourceStream* vss, VgmHeadStream* vhs, u32 addr){
     if(addr >= vss->datalen) return 0;
-    if(addr >= vhs->buffer1addr && addr < (vhs->buffer1addr + VGM_SOURCESTREAM_BUFSIZE)){
-        if(vhs->buffer2addr != vhs->buffer1addr + VGM_SOURCESTREAM_BUFSIZE){
-            //Set up to background buffer next
-            vhs->wantbuffer = 2;
-            vhs->wantbufferaddr = vhs->buffer1addr + VGM_SOURCESTREAM_BUFSIZE;
-        }
-        return vhs->buffer1[addr - vhs->buffer1addr];
-    }
-    if(addr >= vhs->buffer2addr && addr < (vhs->buffer2addr + VGM_SOURCESTREAM_BUFSIZE)){
-        if(vhs->buffer1addr != vhs->buffer2addr + VGM_SOURCESTREAM_BUFSIZE){
-            //Set up to background buffer next
-            vhs->wantbuffer = 1;
-            vhs->wantbufferaddr = vhs->buffer2addr + VGM_SOURCESTREAM_BUFSIZE;
-        }
-        return vhs->buffer2[addr - vhs->buffer2addr];
+    s8 b = VGM_HeadStream_findBuffer(vhs, addr);
+    if(b >= 0){
+        return vhs->buffer[b][addr - vhs->bufferaddr[b]];
     }
+    ++vhs->underruns;
     DBG("VGM_HeadStream_getByte() buffer underflow!");
     return 0x66; //error, stop stream
 }
-void VGM_HeadStream_BackgroundBuffer(VgmHead* head){
+u32 VGM_HeadStream_BufferedAhead(VgmHead* head){
+    VgmHeadStream* vhs = (VgmHeadStream*)head->data;
+    if(!vhs->wantbuffer) return 0xFFFFFFFF; //Read up to the end of the file
+    if(VGM_HeadStream_findFreeBuffer(head, vhs) < 0) return 0xFFFFFFFF; //Ring is full
+    if(vhs->seeking || vhs->wantbufferaddr <= head->srcaddr) return 0; //Waiting for data
+    return vhs->wantbufferaddr - head->srcaddr;
+}
+u8 VGM_HeadStream_BackgroundBuffer(VgmHead* head){
     VgmHeadStream* vhs = (VgmHeadStream*)head->data;
     VgmSourceStream* vss = (VgmSourceStream*)head->source->data;
-    u8* bufferto = NULL;
-    u32* addrto = NULL;
-    if(vhs->wantbuffer == 1){
-        bufferto = vhs->buffer1;
-        addrto = &(vhs->buffer1addr);
-    }else if(vhs->wantbuffer == 2){
-        bufferto = vhs->buffer2;
-        addrto = &(vhs->buffer2addr);
+    //The player (TIM3 interrupt) may seek at any time
+    MIOS32_IRQ_Disable();
+    s8 b = vhs->wantbuffer ? VGM_HeadStream_findFreeBuffer(head, vhs) : -1;
+    u32 addr = vhs->wantbufferaddr;
+    if(b >= 0){
+        vhs->bufferaddr[b] = 0xFFFFFFFF; //Not valid while it's being read
     }
-    if(bufferto != NULL){
+    MIOS32_IRQ_Enable();
+    if(b >= 0){
+        u8* bufferto = vhs->buffer[b];
         vgm_sdtask_usingsdcard = 1;
         MUTEX_SDCARD_TAKE;
         
@@ -302,10 +332,15 @@ void VGM_HeadStream_BackgroundBuffer(VgmHead* head){
         MIOS32_BOARD_LED_Set(0b1111, 0b0100);
         VGM_PerfMon_ClockIn(VGM_PERFMON_TASK_CARD);
         
-        FILE_ReadReOpen(&vss->file);
-        FILE_ReadSeek(vhs->wantbufferaddr);
-        FILE_ReadBuffer(bufferto, VGM_SOURCESTREAM_BUFSIZE);
-        FILE_ReadClose(&vss->file);
+        if(vss->clustermap != NULL){
+            //Direct sector reads, no need to reopen the file and follow the FAT chain
+            FILE_ReadClusterMapBuffer(&vss->file, vss->clustermap, addr, bufferto, VGM_SOURCESTREAM_BUFSIZE);
+        }else{
+            FILE_ReadReOpen(&vss->file);
+            FILE_ReadSeek(addr);
+            FILE_ReadBuffer(bufferto, VGM_SOURCESTREAM_BUFSIZE);
+            FILE_ReadClose(&vss->file);
+        }
         
         VGM_PerfMon_ClockOut(VGM_PERFMON_TASK_CARD);
         MIOS32_BOARD_LED_Set(0b1111, leds);
@@ -313,9 +348,17 @@ void VGM_HeadStream_BackgroundBuffer(VgmHead* head){
         MUTEX_SDCARD_GIVE_NOYIELD;
         vgm_sdtask_usingsdcard = 0;
         
-        vhs->wantbuffer = 0;
-        *addrto = vhs->wantbufferaddr;
+        MIOS32_IRQ_Disable();
+        if(vhs->wantbufferaddr == addr){
+            //Didn't seek meanwhile, continue with the next block
+            vhs->bufferaddr[b] = addr;
+            vhs->wantbufferaddr += VGM_SOURCESTREAM_BUFSIZE;
+            if(vhs->wantbufferaddr >= vss->datalen) vhs->wantbuffer = 0;
+        }
+        MIOS32_IRQ_Enable();
+        return 1;
     }
+    return 0;
 }
 
 VgmSource* VGM_SourceStream_Create(){
@@ -337,6 +380,7 @@ VgmSource* VGM_SourceStream_Create(){
     vss->vgmdatastartaddr = 0;
     vss->block = NULL;
     vss->blocklen = 0;
+    vss->clustermap = NULL;
     return source;
 }
 void VGM_SourceStream_Delete(void* sourcestream){
@@ -347,6 +391,9 @@ void VGM_SourceStream_Delete(void* sourcestream){
     if(vss->block != NULL){
         free(vss->block);
     }
+    if(vss->clustermap != NULL){
+        vgmh2_free(vss->clustermap);
+    }
     vgmh2_free(vss);
 }
 
@@ -22,29 +22,36 @@
 #define VGM_SOURCESTREAM_BUFSIZE 512
 #endif
 
+//Number of VGM_SOURCESTREAM_BUFSIZE blocks read ahead per stream head
+#ifndef VGM_HEADSTREAM_NUMBUFFERS
+#define VGM_HEADSTREAM_NUMBUFFERS 4
+#endif
+
 #define VGM_HEADSTREAM_SUBBUFFER_MAXLEN 16
 
 typedef union {
-    u8 ALL[28+VGM_HEADSTREAM_SUBBUFFER_MAXLEN];
+    u8 ALL[16+(8*VGM_HEADSTREAM_NUMBUFFERS)+VGM_HEADSTREAM_SUBBUFFER_MAXLEN];
     struct{
         u32 srcblockaddr;
         
-        u8* buffer1;
-        u8* buffer2;
-        u32 buffer1addr;
-        u32 buffer2addr;
+        //Ring of read-ahead blocks, address 0xFFFFFFFF if empty
+        u8* buffer[VGM_HEADSTREAM_NUMBUFFERS];
+        u32 bufferaddr[VGM_HEADSTREAM_NUMBUFFERS];
         
         u8 subbuffer[VGM_HEADSTREAM_SUBBUFFER_MAXLEN];
         u8 subbufferlen;
         
-        u8 wantbuffer;
-        u16 dummy2;
+        u8 wantbuffer; //Ring is being filled, wantbufferaddr is the next block to read
+        u8 seeking; //Waiting for the block at a new address (not counted as underrun)
+        u8 stalled; //Waiting for data which should have been read ahead already
         u32 wantbufferaddr;
+        
+        u32 underruns;
     };
 } VgmHeadStream;
 
 typedef union {
-    u8 ALL[20+sizeof(file_t)];
+    u8 ALL[24+sizeof(file_t)];
     struct{
         file_t file;
         char* filepath;
@@ -54,6 +61,8 @@ typedef union {
         
         u8* block;
         u32 blocklen;
+        
+        u32* clustermap; //See FILE_ReadClusterMapCreate(), NULL if not available
     };
 } VgmSourceStream;
 
@@ -63,7 +72,8 @@ extern void VGM_HeadStream_Delete(void* headstream);
 extern void VGM_HeadStream_Restart(VgmHead* head);
 extern u8 VGM_HeadStream_cmdNext(VgmHead* head, u32 vgm_time);
 extern u8 VGM_HeadStream_getByte(VgmSourceStream* vss, VgmHeadStream* vhs, u32 addr);
-extern void VGM_HeadStream_BackgroundBuffer(VgmHead* head);
+extern u32 VGM_HeadStream_BufferedAhead(VgmHead* head);
+extern u8 VGM_HeadStream_BackgroundBuffer(VgmHead* head);
 
 extern VgmSource* VGM_SourceStream_Create();
 extern void VGM_SourceStream_Delete(void* sourcestream);